@@ -15,14 +15,48 @@
 */
 #include <stdio.h>
 #include "RBTree.h"
+#include "RBTreeMemory.h"
 #include <stdlib.h>
 
+#define MALLOC_HEADER_SIZE sizeof(size_t)
+#define MALLOC_ALIGNMENT (2 * sizeof(size_t))
+#define MALLOC_MIN_CHUNK (4 * sizeof(size_t))
+
 typedef enum Side
 {
     Right,
     Left
 } Side;
 
+/**
+ * @brief a tree that keeps track of the memory it uses, made by newAccountedRBTree:
+ * tree - the tree itself, given to the RBTree functions through accountedRBTree
+ * sizeFunc - reports the size of a key, NULL if keys aren't counted
+ * keyBytes - the bytes of all the keys in the tree, as reported by sizeFunc
+ * keyOverhead - the allocator overhead of all the keys in the tree, as reported by sizeFunc
+ * budget - the maximal total bytes the tree may use, 0 for no limit
+ */
+typedef struct AccountedTree
+{
+    RBTree tree;
+    KeySizeFunc sizeFunc;
+    size_t keyBytes;
+    size_t keyOverhead;
+    size_t budget;
+} AccountedTree;
+
+/**
+ * @brief the sizes of the keys of a tree, added up by addKeySize:
+ * sizeFunc - reports the size of a key
+ * keyBytes, keyOverhead - the sizes of the keys so far
+ */
+typedef struct KeySizes
+{
+    KeySizeFunc sizeFunc;
+    size_t keyBytes;
+    size_t keyOverhead;
+} KeySizes;
+
 /**
  * creates a new node, returns NULL for failure in allocation
  * @param parent - the new nodes parent
@@ -96,6 +130,23 @@ int iterateTree(Node *curNode, forEachFunc func, void *args);
  */
 void iterateTreeFree(Node *node, FreeFunc func);
 
+/**
+ * the total bytes the tree would use after adding a key of the given size
+ * @param account - the accounting of the tree
+ * @param keyBytes - the payload of the new key
+ * @param keyOverhead - the allocator overhead of the new key
+ * @return - the total bytes, as memoryUsageRBTree would report them
+ */
+size_t projectedUsage(AccountedTree *account, size_t keyBytes, size_t keyOverhead);
+
+/**
+ * adds the size of a key to the sizes, for iterateTree
+ * @param data - the key
+ * @param sizes - the KeySizes added up so far
+ * @return - 1 always, for the iteration to go on
+ */
+int addKeySize(const void *data, void *sizes);
+
 Node *createNewNode(Node *parent, Node *left, Node *right, void *data)
 {
     Node *newNode = (Node *) malloc(sizeof(Node));
@@ -466,3 +517,130 @@ void freeRBTree(RBTree *tree)
     free(tree);
 }
 
+size_t allocationOverhead(size_t requested)
+{
+    size_t chunk = (requested + MALLOC_HEADER_SIZE + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1);
+    if (chunk < MALLOC_MIN_CHUNK)
+    {
+        chunk = MALLOC_MIN_CHUNK;
+    }
+    return chunk - requested;
+}
+
+size_t projectedUsage(AccountedTree *account, size_t keyBytes, size_t keyOverhead)
+{
+    size_t nodes = (size_t) account->tree.size + 1;
+    return sizeof(AccountedTree) + allocationOverhead(sizeof(AccountedTree)) +
+           nodes * (sizeof(Node) + allocationOverhead(sizeof(Node))) +
+           account->keyBytes + keyBytes + account->keyOverhead + keyOverhead;
+}
+
+AccountedTree *newAccountedRBTree(CompareFunc compFunc, FreeFunc freeFunc, KeySizeFunc sizeFunc,
+                                  size_t memoryBudget)
+{
+    AccountedTree *account = (AccountedTree *) malloc(sizeof(AccountedTree));
+    if (account == NULL)
+    {
+        fprintf(stderr, "Allocation Failed!");
+        exit(EXIT_FAILURE);
+    }
+    account->tree.compFunc = compFunc;
+    account->tree.freeFunc = freeFunc;
+    account->tree.root = NULL;
+    account->tree.size = 0;
+    account->sizeFunc = sizeFunc;
+    account->keyBytes = 0;
+    account->keyOverhead = 0;
+    account->budget = memoryBudget;
+    return account;
+}
+
+RBTree *accountedRBTree(AccountedTree *account)
+{
+    if (account == NULL)
+    {
+        return NULL;
+    }
+    return &account->tree;
+}
+
+int addToAccountedRBTree(AccountedTree *account, void *data)
+{
+    if (account == NULL)
+    {
+        return 0;
+    }
+    size_t keyBytes = 0;
+    size_t keyOverhead = 0;
+    if (account->sizeFunc != NULL)
+    {
+        account->sizeFunc(data, &keyBytes, &keyOverhead);
+    }
+    if (account->budget != 0 && projectedUsage(account, keyBytes, keyOverhead) > account->budget)
+    {
+        return 0;
+    }
+    if (!addToRBTree(&account->tree, data))
+    {
+        return 0;
+    }
+    account->keyBytes += keyBytes;
+    account->keyOverhead += keyOverhead;
+    return 1;
+}
+
+void freeAccountedRBTree(AccountedTree *account)
+{
+    if (account == NULL)
+    {
+        return;
+    }
+    iterateTreeFree(account->tree.root, account->tree.freeFunc);
+    free(account);
+}
+
+int setMemoryBudgetRBTree(AccountedTree *account, size_t memoryBudget)
+{
+    if (account == NULL)
+    {
+        return 0;
+    }
+    account->budget = memoryBudget;
+    return 1;
+}
+
+int memoryUsageRBTree(AccountedTree *account, MemoryUsage *usage)
+{
+    if (account == NULL || usage == NULL)
+    {
+        return 0;
+    }
+    if (account->sizeFunc != NULL) // keys may have grown or shrunk since they were added
+    {
+        KeySizes sizes = {account->sizeFunc, 0, 0};
+        iterateTree(account->tree.root, addKeySize, &sizes);
+        account->keyBytes = sizes.keyBytes;
+        account->keyOverhead = sizes.keyOverhead;
+    }
+    size_t nodes = (size_t) account->tree.size;
+    usage->treeBytes = sizeof(AccountedTree);
+    usage->nodeBytes = nodes * sizeof(Node);
+    usage->keyBytes = account->keyBytes;
+    usage->overheadBytes = allocationOverhead(sizeof(AccountedTree)) +
+                           nodes * allocationOverhead(sizeof(Node)) + account->keyOverhead;
+    usage->totalBytes = usage->treeBytes + usage->nodeBytes + usage->keyBytes +
+                        usage->overheadBytes;
+    usage->budget = account->budget;
+    return 1;
+}
+
+int addKeySize(const void *data, void *sizes)
+{
+    KeySizes *total = (KeySizes *) sizes;
+    size_t keyBytes = 0;
+    size_t keyOverhead = 0;
+    total->sizeFunc(data, &keyBytes, &keyOverhead);
+    total->keyBytes += keyBytes;
+    total->keyOverhead += keyOverhead;
+    return 1;
+}
@@ -0,0 +1,124 @@
+/**
+* @file RBTreeMemory.h
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 12 Dec 2019
+*
+* @brief memory accounting for RBTree - how many bytes a tree and the keys stored in it take,
+* and an optional hard budget on that amount.
+* @section LICENSE
+* This program is not a free software;
+*/
+#ifndef RBTREEMEMORY_H
+#define RBTREEMEMORY_H
+
+#include <stddef.h>
+#include "RBTree.h"
+
+/**
+ * a tree that keeps track of the memory it uses. it is only made by newAccountedRBTree, and the
+ * RBTree functions reach its tree through accountedRBTree.
+ */
+typedef struct AccountedTree AccountedTree;
+
+/**
+ * a function that reports the heap memory held by a key stored in the tree.
+ * @param data - the key
+ * @param payload - out: the number of bytes requested from the allocator for this key
+ * @param overhead - out: the estimated allocator overhead on top of payload (see
+ * allocationOverhead)
+ */
+typedef void (*KeySizeFunc)(const void *data, size_t *payload, size_t *overhead);
+
+/**
+ * @brief the memory a tree uses, in bytes:
+ * treeBytes - the tree struct itself, with its accounting
+ * nodeBytes - all the tree nodes
+ * keyBytes - the keys, as reported by the tree's KeySizeFunc (0 if it has none)
+ * overheadBytes - estimated allocator bookkeeping and padding for all of the above
+ * totalBytes - the sum of all of the above
+ * budget - the hard budget of the tree, 0 for none
+ */
+typedef struct MemoryUsage
+{
+    size_t treeBytes;
+    size_t nodeBytes;
+    size_t keyBytes;
+    size_t overheadBytes;
+    size_t totalBytes;
+    size_t budget;
+} MemoryUsage;
+
+/**
+ * constructs a new RBTree that keeps track of the memory it uses.
+ * @param compFunc a function to compare two variables.
+ * @param freeFunc a function to free a variable.
+ * @param sizeFunc a function reporting the size of a key, NULL if keys shouldn't be counted.
+ * @param memoryBudget the maximal number of bytes (as reported by memoryUsageRBTree) the tree may
+ * use, 0 for no limit. addToAccountedRBTree fails once adding a key would pass it. a key is
+ * measured when it is added, and again only by memoryUsageRBTree - the growth of a key changed in
+ * place is missed by the budget until memoryUsageRBTree is called.
+ * @return a pointer to the new tree, exits on allocation failure like newRBTree.
+ */
+AccountedTree *newAccountedRBTree(CompareFunc compFunc, FreeFunc freeFunc, KeySizeFunc sizeFunc,
+                                  size_t memoryBudget);
+
+/**
+ * the tree kept by an accounted tree, for containsRBTree and forEachRBTree. keys must be added
+ * through addToAccountedRBTree for them to be counted.
+ * @param account the accounted tree
+ * @return the tree, NULL if account is NULL
+ */
+RBTree *accountedRBTree(AccountedTree *account);
+
+/**
+ * add an item to an accounted tree, like addToRBTree, unless it would pass the memory budget.
+ * @param account the tree to add an item to.
+ * @param data item to add to the tree.
+ * @return 0 on failure (other wise 1).
+ */
+int addToAccountedRBTree(AccountedTree *account, void *data);
+
+/**
+ * free all memory of the accounted tree, like freeRBTree.
+ * @param account pointer to the tree to free.
+ */
+void freeAccountedRBTree(AccountedTree *account);
+
+/**
+ * changes the hard memory budget of a tree. keys already in the tree are never removed, so a
+ * budget lower than the current usage only blocks further additions.
+ * @param account the tree to change
+ * @param memoryBudget the new budget in bytes, 0 for no limit
+ * @return 1 for success, 0 otherwise
+ */
+int setMemoryBudgetRBTree(AccountedTree *account, size_t memoryBudget);
+
+/**
+ * reports how much memory the tree uses. every key is measured again, so keys changed in place
+ * after they were added - like a Vector grown by copyIfNormIsLarger - are counted at their
+ * current size, and the budget checks that follow start from these sizes.
+ * @param account the tree to measure
+ * @param usage out: filled with the tree's usage
+ * @return 1 for success, 0 otherwise
+ */
+int memoryUsageRBTree(AccountedTree *account, MemoryUsage *usage);
+
+/**
+ * estimates the bookkeeping and alignment padding the allocator adds to a single allocation.
+ * @param requested the number of bytes given to malloc
+ * @return the estimated number of bytes used beyond requested
+ */
+size_t allocationOverhead(size_t requested);
+
+/**
+ * KeySizeFunc for keys of type Vector (see Structs.h)
+ */
+void vectorMemorySize(const void *vector, size_t *payload, size_t *overhead);
+
+/**
+ * KeySizeFunc for keys that are null-terminated strings
+ */
+void stringMemorySize(const void *s, size_t *payload, size_t *overhead);
+
+#endif //RBTREEMEMORY_H
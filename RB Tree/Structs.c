@@ -11,6 +11,7 @@
 */
 
 #include "Structs.h"
+#include "RBTreeMemory.h"
 #include <stdlib.h>
 # include <string.h>
 
@@ -145,4 +146,19 @@ void freeString(void *s)
 {
     char *str = (char *) s;
     free(str);
+}
+
+void vectorMemorySize(const void *vector, size_t *payload, size_t *overhead)
+{
+    const Vector *vec = (const Vector *) vector;
+    size_t arrayBytes = (vec->len > 0) ? (size_t) vec->len * sizeof(double) : 0;
+    *payload = sizeof(Vector) + arrayBytes;
+    *overhead = allocationOverhead(sizeof(Vector)) + allocationOverhead(arrayBytes);
+}
+
+void stringMemorySize(const void *s, size_t *payload, size_t *overhead)
+{
+    size_t bytes = strlen((const char *) s) + 1;
+    *payload = bytes;
+    *overhead = allocationOverhead(bytes);
 }
\ No newline at end of file
@@ -13,645 +13,821 @@
 * Process: building the input, and then collectting different required stats on the graph
 * Output : printing to user
 */
+#include "TreeAnalyzer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "queue.h"
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+
+#define USAGE "Usage: TreeAnalyzer [Options] <Graph File Path> <First Vertex> <Second Vertex>\n" \
+              "       TreeAnalyzer [Options] --batch <Queries File | -> [--weights <Weights File>] " \
+              "<Graph File Path>\n" \
+              "       TreeAnalyzer [Options] --server <Socket Path | -> [--dynamic] " \
+              "<Graph File Path>\n" \
+              "       TreeAnalyzer [Options] --eccentricity <Output File | -> [--binary] " \
+              "<Graph File Path>\n" \
+              "       TreeAnalyzer [Options] --distances <Output File | -> [--binary] " \
+              "<Graph File Path>\n" \
+              "       TreeAnalyzer --stream [--memory <MB>] <Graph File Path>\n" \
+              "Options: --threads <N>, --cache, --verify-cache, --incremental, " \
+              "--relabel <bfs | dfs>, --stats <text | json>\n"
+
+#define CACHE_OFF 0
+#define CACHE_ON 1
+#define CACHE_VERIFIED 2
+#define DEFAULT_STREAM_MEMORY_MB 256
+#define DISTANCES_MAGIC "DST1"
 
 /**
- * @brief - a struct the consists of :
- * value - the number that represents the node
- * distance - relevant when measuring distance from other nodes in a graph
- * num of sons - the amount of sons the node has
- * father - the node directing to this node in a graph
- * nodeSons - an array of nodes that represents all the nodes that this nodes direct an edge to
- * in a graph
- * previous in path - which is the value of the node which we used to get to the current one,
- * when measuring distance
+ * @brief the options given to the program before the graph file:
+ * numOfThreads - the number of threads to use, given by --threads. the number of processors
+ * by default.
+ * threadsGiven - 1 if given --threads. only then is the BFS of the path run on numOfThreads
+ * threads, by the experimental parallel BFS - otherwise it is sequential.
+ * queriesFile - the file of queries to answer given by --batch, "-" for the standard input.
+ * NULL if not given.
+ * weightsFile - the file of the weights of the vertices for the batch queries given by --weights.
+ * NULL if not given, for all the weights to start at 0.
+ * socketPath - the UNIX socket to serve queries on given by --server, "-" for the standard input
+ * and output. NULL if not given.
+ * dynamicServer - 1 if given --dynamic, for the served tree to change by link and cut requests
+ * eccentricityFile - the file to write the eccentricity of every vertex to given by
+ * --eccentricity, "-" for the standard output. NULL if not given.
+ * distancesFile - the file to write the number of pairs of vertices at every distance to given by
+ * --distances, "-" for the standard output. NULL if not given.
+ * binaryOutput - 1 if given --binary, for the eccentricities or the distances to be written in
+ * binary, 0 for CSV
+ * cacheMode - CACHE_ON if given --cache: the tree is loaded from the binary snapshot next to the
+ * graph file, and the snapshot is written if it is missing or out of date. CACHE_VERIFIED if given
+ * --verify-cache: the same, but the whole snapshot is checked before it is used. CACHE_OFF by
+ * default.
+ * incremental - 1 if given --incremental: the state kept next to the graph file by the last run
+ * is brought up to date with the lines of the file that changed, instead of parsing and analyzing
+ * the whole file, and is written if it is missing or can't be brought up to date
+ * relabelOrder - RELABEL_BFS or RELABEL_DFS if given --relabel bfs or --relabel dfs: the nodes
+ * are renumbered in that order from the root before any work is done on the tree, and translated
+ * back in the output. RELABEL_NONE by default.
+ * streamMode - 1 if given --stream: only the stats of the tree are computed, without reading it
+ * into memory
+ * memoryMegabytes - the memory the stream mode may use given by --memory, in MB
+ * statsFormat - STATS_TEXT or STATS_JSON if given --stats text or --stats json: the time, memory
+ * and BFS runs of every phase of the run are printed to the standard error at its end.
+ * STATS_OFF by default.
  */
-typedef struct Node
+typedef struct Options
 {
-    int value;
-    int distance;
-    int numOfSons;
-    struct Node *father;
-    struct Node **nodeSons;
-    int previousInPath;
-} Node;
-/**
- * @brief the Tree struct, consists of:
- * value - the number of nodes in the tree
- * allNodesPtr - a pointer to all the nodes in the Tree
- */
-typedef struct AllTree
-{
-    int value;
-    Node *allNodesPtr;
-} AllTree;
+    int numOfThreads;
+    int threadsGiven;
+    const char *queriesFile;
+    const char *weightsFile;
+    const char *socketPath;
+    int dynamicServer;
+    const char *eccentricityFile;
+    const char *distancesFile;
+    int binaryOutput;
+    int cacheMode;
+    int incremental;
+    int relabelOrder;
+    int streamMode;
+    long memoryMegabytes;
+    int statsFormat;
+} Options;
 
-#define DELIMITER " "
-#define NOSONS "-"
 static int nodeU;
 static int nodeV;
 
-int checkValidOfLine(char line[], int maxNode);
-
-int checkValidInput(int numOfArgs, char *const *argv);
-
-int checkNodeIsValid(char *nodeValue, int numOfNodesInTree);
+int parseOptions(int numOfArgs, char *const *argv, Options *options);
 
-int checkCharIsNum(char num[1025]);
+int checkValidInput(int numOfArgs, char *const *args, const Options *options,
+                    AllTree **mainTree, TreeMetrics *metrics, ParseError *error);
 
-int initNode(int value, int numOfSons, AllTree *mainTree);
+int checkNodeIsValid(const char *nodeValue, long long numOfNodesInTree);
 
-AllTree *initTree(int n);
+void bfsTalsEdition(int root, AllTree *mainTree, BfsScratch *scratch);
 
-AllTree *parseFile(char *file, AllTree *mainTree);
+int runBatchMode(AllTree *mainTree, const Options *options);
 
-int addToNodeSon(int fatherIndex, char sonIndex[], int sonCount, AllTree *mainTree);
+int runEccentricityMode(AllTree *mainTree, const Options *options);
 
-Node *findRoot(AllTree *mainTree);
+int runDistancesMode(AllTree *mainTree, const Options *options);
 
-void bfsTalsEdition(Node *root, AllTree *mainTree);
+int openOutputFile(const char *path, AllTree *mainTree);
 
-int findMaxDist(int flag, AllTree *mainTree);
+int runStreamMode(const char *fileName, const Options *options);
 
-int findMinDist(AllTree *mainTree);
+int isWideRun(int numOfArgs, char *const *args, const Options *options);
 
-int findDiameterLength(Node *root, AllTree *mainTree);
+int runWideMode(char *const *args);
 
-void freeTree(AllTree *mainTree);
+void printInvalidInput(const ParseError *error);
 
-int checkFile(const FILE *fileToProcess);
+void printTreeReport(AllTree *mainTree, int numOfThreads, const TreeMetrics *knownMetrics);
 
 int main(int argc, char *argv[])
 {
-    int valid;
+    int valid = -1;
+    Options options;
+    ParseError error = {0, ""};
     AllTree *mainTree = NULL;
-    if ((valid = checkValidInput(argc, argv)) == 1)
+    TreeMetrics metrics;
+    int firstArg = parseOptions(argc, argv, &options);
+    if (firstArg > 0)
     {
-        nodeU = (int) strtol(argv[2], NULL, 10);
-        nodeV = (int) strtol(argv[3], NULL, 10);
-        mainTree = parseFile(argv[1], mainTree);
+        enableStats(options.statsFormat);
     }
-    else
+    if (firstArg > 0 && options.streamMode && argc - firstArg == 1)
+    {
+        return runStreamMode(argv[firstArg], &options);
+    }
+    if (firstArg > 0 && isWideRun(argc - firstArg, argv + firstArg, &options))
     {
+        return runWideMode(argv + firstArg);
+    }
+    if (firstArg > 0 && !options.streamMode)
+    {
+        valid = checkValidInput(argc - firstArg, argv + firstArg, &options, &mainTree, &metrics,
+                                &error);
+    }
+    if (valid != 1)
+    {
+        if (mainTree != NULL)
+        {
+            freeTree(mainTree);
+        }
         if (valid == -1)
         {
-            fprintf(stderr, "Usage: TreeAnalyzer <Graph File Path> <First Vertex> <Second "
-                            "Vertex>\n");
+            fprintf(stderr, USAGE);
         }
         else
         {
-            fprintf(stderr, "Invalid input\n");
+            printInvalidInput(&error);
         }
         exit(EXIT_FAILURE);
     }
-    Node *root = findRoot(mainTree);
-    bfsTalsEdition(root, mainTree);
-    int max = findMaxDist(0, mainTree);
-    int min = findMinDist(mainTree);
-    printf("Root Vertex: %d\n", root->value);
-    printf("Vertices Count: %d\n", (mainTree->value));
-    printf("Edges Count: %d\n", (mainTree->value - 1));
-    printf("Length of Minimal Branch: %d\n", min);
-    printf("Length of Maximal Branch: %d\n", max);
-    int diameter = findDiameterLength(root, mainTree);
-    printf("Diameter Length: %d\n", diameter);
-    printf("Shortest Path Between %d and %d: ", nodeU, nodeV);
-    bfsTalsEdition(&mainTree->allNodesPtr[nodeV], mainTree);
-    int curNode = nodeU;
-    while (mainTree->allNodesPtr[curNode].value != nodeV)
-    {
-        printf("%d ", curNode);
-        curNode = mainTree->allNodesPtr[curNode].previousInPath;
-
-    }
-    printf("%d\n", nodeV);
-    freeTree(mainTree);
-    return 0;
-}
-
-
-/********************************************************************************
-*********************************************************************************
-*******************         validity checks            **************************
-*********************************************************************************
-********************************************************************************/
-
-/**
- * @brief - this is the main functions that checks the validity of the input.
- * first - numof args is checked. then the filre - if openable, and if approved - its inside is
- * checked.
- * @param numOfArgs - the num of args given to the program at run
- * @param argv - a pointer to the args given by the user in the cmd while running the program
- * @return - 0 if input is invalid, -1 if input args doesn't fit the required, and 1 if the input
- * is valid
- */
-int checkValidInput(int numOfArgs, char *const *argv)
-{
-    int isValid = 1;
-    int numOfNOdesInTree = 0;
-
-    if (numOfArgs == 4)
+    if (options.relabelOrder != RELABEL_NONE)
     {
-        FILE *fileToProcess;
-        char *fileName = argv[1];
-        char *nodeUstr = argv[2];
-        char *nodeVstr = argv[3];
-        fileToProcess = fopen(fileName, "r");
-        if (fileToProcess == NULL)
+        startStatsPhase("relabel");
+        relabelTree(mainTree, findRoot(mainTree), options.relabelOrder);
+        if (metrics.root != -1)
         {
-            return 0;
+            metrics.root = INTERNAL_LABEL(mainTree, metrics.root);
+            metrics.diameterStart = INTERNAL_LABEL(mainTree, metrics.diameterStart);
+            metrics.diameterEnd = INTERNAL_LABEL(mainTree, metrics.diameterEnd);
         }
-        numOfNOdesInTree = checkFile(fileToProcess);
-        if (numOfNOdesInTree == 0)
-        {
-            isValid = 0;
-        }
-        fclose(fileToProcess);
-        if ((checkNodeIsValid(nodeUstr, numOfNOdesInTree) == 0) ||
-            (checkNodeIsValid(nodeVstr, numOfNOdesInTree) == 0))
-        {
-            isValid = 0;
-        }
-        return isValid;
     }
-
-    else // input args are invalid
+    int exitCode = 0;
+    if (options.queriesFile != NULL)
     {
-        return -1;
+        exitCode = runBatchMode(mainTree, &options);
+    }
+    else if (options.eccentricityFile != NULL)
+    {
+        exitCode = runEccentricityMode(mainTree, &options);
     }
+    else if (options.distancesFile != NULL)
+    {
+        exitCode = runDistancesMode(mainTree, &options);
+    }
+    else if (options.socketPath != NULL)
+    {
+        startStatsPhase("server");
+        exitCode = runServer(mainTree, findRoot(mainTree), options.socketPath,
+                             options.numOfThreads, options.dynamicServer);
+        freeTree(mainTree);
+    }
+    else
+    {
+        nodeU = INTERNAL_LABEL(mainTree, (int) strtol(argv[firstArg + 1], NULL, 10));
+        nodeV = INTERNAL_LABEL(mainTree, (int) strtol(argv[firstArg + 2], NULL, 10));
+        printTreeReport(mainTree, options.threadsGiven ? options.numOfThreads : 1, &metrics);
+        freeTree(mainTree);
+    }
+    return exitCode;
 }
 
 /**
- * @brief this function checks the file given by the user in the input
- * @param fileToProcess - a pointer to an open file
- * @param isValid - a pointer the the invalid int, kept in the function - checkValidInput
- * @param numOfNodesInTree - the number of nodes in the tree, a pointer to the number being
- * counted in the checkValidInput function
+ * @brief prints the stats of the tree, and the shortest path between the two vertices given
+ * @param numOfThreads - the number of threads to measure the distances on, 1 for the sequential
+ * BFS
+ * @param knownMetrics - the stats of the tree if they are already known, root -1 if they aren't
  */
-int checkFile(const FILE *fileToProcess)
+void printTreeReport(AllTree *mainTree, int numOfThreads, const TreeMetrics *knownMetrics)
 {
-    int isV = 1;
-    int numOfNodesInTree = 0;
-    int countLines = 0;
-    char line[1025] = {0};
-    fgets(line, 1025, (FILE *) fileToProcess);
-    sscanf(line, "%[^\r\n]", line);
-    if (strcmp(line, "") == 0)
+    TreeMetrics metrics = *knownMetrics;
+    startStatsPhase("metrics");
+    if (metrics.root == -1)
     {
-        isV = 0;
+        analyzeTree(mainTree, findRoot(mainTree), &metrics);
     }
-    else if (checkCharIsNum(line) == 0)
+    printf("Root Vertex: %d\n", ORIGINAL_LABEL(mainTree, metrics.root));
+    printf("Vertices Count: %d\n", (mainTree->value));
+    printf("Edges Count: %d\n", (mainTree->value - 1));
+    printf("Length of Minimal Branch: %d\n", metrics.minBranch);
+    printf("Length of Maximal Branch: %d\n", metrics.maxBranch);
+    printf("Diameter Length: %d\n", metrics.diameter);
+    printf("Shortest Path Between %d and %d: ", ORIGINAL_LABEL(mainTree, nodeU),
+           ORIGINAL_LABEL(mainTree, nodeV));
+    startStatsPhase("bfs");
+    BfsScratch *scratch = allocBfsScratch(mainTree->value);
+    if (numOfThreads > 1)
     {
-
-        isV = 0;
+        parallelBfs(mainTree, scratch, nodeV, numOfThreads);
     }
-    else if ((numOfNodesInTree = (int) strtol(line, NULL, 10)) <= 0)
+    else
     {
-        isV = 0;
+        bfsTalsEdition(nodeV, mainTree, scratch);
     }
-    else
+    freeBfsScratch(scratch);
+    startStatsPhase("output");
+    fflush(stdout); // the path goes after the report, straight to the standard output
+    OutputBuffer *out = openOutputBuffer(STDOUT_FILENO, OUTPUT_BUFFER_SIZE);
+    // the BFS ran from nodeV, so following the previous nodes from nodeU walks the path in order
+    int curNode = nodeU;
+    while (curNode != nodeV)
     {
-        countLines++;
-        while (fgets(line, 1024, (FILE *) fileToProcess) != NULL)
+        appendNumber(out, ORIGINAL_LABEL(mainTree, curNode));
+        appendChar(out, ' ');
+        curNode = mainTree->previousInPath[curNode];
+    }
+    appendNumber(out, ORIGINAL_LABEL(mainTree, nodeV));
+    appendChar(out, '\n');
+    closeOutputBuffer(out);
+}
+
+/**
+ * @brief answers the queries given by --batch on the tree, with the weights given by --weights,
+ * and frees it.
+ * @return - the exit code of the program
+ */
+int runBatchMode(AllTree *mainTree, const Options *options)
+{
+    FILE *queries = stdin;
+    long long *weights = NULL;
+    if (options->weightsFile != NULL)
+    {
+        startStatsPhase("weights");
+        ParseError error = {0, ""};
+        weights = parseWeightsFile(options->weightsFile, mainTree->value, &error);
+        if (weights == NULL)
         {
-            sscanf(line, "%[^\r\n]", line);
-            if (countLines - 1 == numOfNodesInTree)
+            fprintf(stderr, "Invalid input\n");
+            if (error.line != 0)
             {
-                if (fgets(line, 1024, (FILE *) fileToProcess) != NULL)
-                {
-                    isV = 0;
-                }
-                break;
+                fprintf(stderr, "line %ld of the weights file: %s\n", error.line, error.message);
             }
-            else if (checkValidOfLine(line, numOfNodesInTree) != 1)
+            else
             {
-                isV = 0;
-                break;
+                fprintf(stderr, "%s\n", error.message);
             }
-            countLines++;
-        }
-        if (countLines - 1 != numOfNodesInTree)
-        {
-            isV = 0;
+            freeTree(mainTree);
+            exit(EXIT_FAILURE);
         }
+        toInternalOrder(mainTree, weights);
     }
-    if (isV == 0)
+    if (strcmp(options->queriesFile, "-") != 0)
     {
-        return 0;
+        queries = fopen(options->queriesFile, "r");
+        if (queries == NULL)
+        {
+            fprintf(stderr, "Invalid input\nthe queries file can't be opened\n");
+            free(weights);
+            freeTree(mainTree);
+            exit(EXIT_FAILURE);
+        }
     }
-    else
+    startStatsPhase("batch");
+    OutputBuffer *out = openOutputBuffer(STDOUT_FILENO, OUTPUT_BUFFER_SIZE);
+    runBatchQueries(mainTree, findRoot(mainTree), weights, options->numOfThreads, queries, out);
+    closeOutputBuffer(out);
+    if (queries != stdin)
     {
-        return numOfNodesInTree;
+        fclose(queries);
     }
+    free(weights);
+    freeTree(mainTree);
+    return 0;
 }
 
-
 /**
- * given a line in the file, this funciton checks that it is valid to parse as a legal line
- * @param line - an array of char presenting a line from the file
- * @return 0 if not valid, 1 if valid
+ * @brief opens the file an output mode writes to, for an OutputBuffer to write it. exits the
+ * program, freeing the tree, if it can't be opened.
+ * @param path - the file, "-" for the standard output
+ * @return - the file descriptor of the file
  */
-int checkValidOfLine(char line[], int maxNode)
+int openOutputFile(const char *path, AllTree *mainTree)
 {
-    int countSons = 0;
-    char copy[1025];
-    strcpy(copy, line);
-    if (strcmp(copy, NOSONS) == 0) //if the line has only '-' it is valid
+    if (strcmp(path, "-") == 0)
     {
-        return 1;
-    }
-    char *nodeIndex = strtok(copy, DELIMITER); //else - go over the line. check it only has
-    // numbers, that are legit (legal numbers smaller than the number of nodes in the tree)
-    if (nodeIndex == NULL)
-    {//if line is empty
-        return 0;
+        fflush(stdout); // whatever stdio holds goes before the buffered output
+        return STDOUT_FILENO;
     }
-    while (nodeIndex != NULL)
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
     {
-        if (checkNodeIsValid(nodeIndex, maxNode) == 0)
-        {
-            return 0;
-        }
-        countSons++;
-        nodeIndex = strtok(NULL, DELIMITER);
-    }
-    int *allSons = (int *) malloc(countSons * sizeof(int));
-    if (allSons == NULL)
-    {
-        fprintf(stderr, "Memory allocation failed\n");
+        fprintf(stderr, "Invalid input\nthe output file can't be opened\n");
+        freeTree(mainTree);
         exit(EXIT_FAILURE);
     }
-    //now the check is to see whether a node appears more than once in a line.
-    int countChecked = 0;
-    strcpy(copy, line);
-    nodeIndex = strtok(copy, DELIMITER);
-    while (nodeIndex != NULL)
-    {
-        int number = (int) strtol(nodeIndex, NULL, 10);
-        for (int i = 0; i < countChecked; i++)
-        {
-            if (number == allSons[i])
-            {
-                free(allSons);
-                return 0;
-            }
-        }
-        allSons[countChecked] = number;
-        countChecked++;
-        nodeIndex = strtok(NULL, DELIMITER);
-    }
-    free(allSons);
-    return 1;
+    return fd;
 }
 
 /**
- * @brief - this function checks, given a number as a pointer to char, whether it is only a number
- * @param num
- * @return
+ * @brief writes the eccentricities of all the vertices to the file given by --eccentricity, and
+ * prints the radius and center of the tree - to the standard error if the eccentricities are
+ * written to the standard output. frees the tree.
+ * @return - the exit code of the program
  */
-int checkCharIsNum(char num[1025])
+int runEccentricityMode(AllTree *mainTree, const Options *options)
 {
-    char temp[1025] = {0};
-    sscanf(num, "%[0-9]", temp);
-    if (strcmp(temp, num) != 0)
+    int fd = openOutputFile(options->eccentricityFile, mainTree);
+    FILE *report = (fd == STDOUT_FILENO) ? stderr : stdout;
+    TreeCenter center;
+    startStatsPhase("eccentricity");
+    int32_t *eccentricity = allEccentricities(mainTree, findRoot(mainTree), &center);
+    toOriginalOrder(mainTree, eccentricity);
+    center.center = ORIGINAL_LABEL(mainTree, center.center);
+    if (center.secondCenter != -1)
+    {
+        center.secondCenter = ORIGINAL_LABEL(mainTree, center.secondCenter);
+        if (center.secondCenter < center.center) // the first of the two in the graph file
+        {
+            int temp = center.center;
+            center.center = center.secondCenter;
+            center.secondCenter = temp;
+        }
+    }
+    startStatsPhase("output");
+    OutputBuffer *out = openOutputBuffer(fd, OUTPUT_BUFFER_SIZE);
+    int written = writeEccentricities(eccentricity, mainTree->value, out, options->binaryOutput);
+    written = closeOutputBuffer(out) && written;
+    if (fd != STDOUT_FILENO && close(fd) != 0)
     {
-        return 0;
+        written = 0;
+    }
+    fprintf(report, "Radius: %d\n", center.radius);
+    if (center.secondCenter != -1)
+    {
+        fprintf(report, "Center: %d %d\n", center.center, center.secondCenter);
     }
     else
     {
-        return 1;
+        fprintf(report, "Center: %d\n", center.center);
+    }
+    free(eccentricity);
+    freeTree(mainTree);
+    if (!written)
+    {
+        fprintf(stderr, "Writing the eccentricities failed\n");
+        return EXIT_FAILURE;
     }
+    return 0;
 }
 
+
 /**
- * @brief - this function checks whether when given a node value, if it is legal in the given
- * tree - which means if this node was already in the line, and if the node value is a valid
- * number between 0 to n-1.
- * @param nodeValue - the node value to check on
- * @param numOfNodesInTree - the number of nodes in the tree
- * @return - 0 if invalid, 1 if valid
+ * @brief writes the number of pairs of vertices at every distance to the file given by
+ * --distances, as a CSV of "distance,pairs" lines under a header line. with --binary, as the 4
+ * bytes "DST1", the number of distances as a uint32 and the pairs at every distance from 1 as
+ * int64, in the byte order of the machine. frees the tree.
+ * @return - the exit code of the program
  */
-int checkNodeIsValid(char *nodeValue, int numOfNodesInTree)
+int runDistancesMode(AllTree *mainTree, const Options *options)
 {
-    int isValid = 1;
-    int intNodeIndex;
-    if (nodeValue == NULL)
-    {
-        return 0;
-    }
-    if (checkCharIsNum(nodeValue) == 0)
-    {
-        isValid = 0;
+    int fd = openOutputFile(options->distancesFile, mainTree);
+    startStatsPhase("centroids");
+    CentroidIndex *centroids = buildCentroidIndex(mainTree, findRoot(mainTree),
+                                                  options->numOfThreads, 1);
+    startStatsPhase("output");
+    OutputBuffer *out = openOutputBuffer(fd, OUTPUT_BUFFER_SIZE);
+    if (options->binaryOutput)
+    {
+        uint32_t numOfDistances = (uint32_t) (centroids->histogramLength - 1);
+        appendBytes(out, DISTANCES_MAGIC, 4);
+        appendBytes(out, &numOfDistances, sizeof(numOfDistances));
+        appendBytes(out, centroids->histogram + 1, numOfDistances * sizeof(long long));
     }
     else
     {
-        intNodeIndex = (int) strtol(nodeValue, NULL, 10);
-        if ((intNodeIndex >= numOfNodesInTree) || (intNodeIndex < 0))
+        appendOutput(out, "distance,pairs\n");
+        for (long k = 1; k < centroids->histogramLength; k++)
         {
-            isValid = 0;
+            appendNumber(out, k);
+            appendChar(out, ',');
+            appendNumber(out, centroids->histogram[k]);
+            appendChar(out, '\n');
         }
     }
-    return isValid;
+    int written = closeOutputBuffer(out);
+    if (fd != STDOUT_FILENO && close(fd) != 0)
+    {
+        written = 0;
+    }
+    freeCentroidIndex(centroids);
+    freeTree(mainTree);
+    if (!written)
+    {
+        fprintf(stderr, "Writing the distances failed\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
 }
 
-/********************************************************************************
-*********************************************************************************
-*************        Parsing & Initializing Tree         ************************
-*********************************************************************************
-********************************************************************************/
-
 /**
- * @brief in this function the assumption is that the input is valid(readably valid, not
- * neccessarily logically valid). this functions restarts the global main tree of the program and
- * all the nodes, according to the file given.
- * @param file - the file given by the user in the input
+ * @brief computes the stats of the tree given by --stream with the memory given by --memory,
+ * without reading the tree into memory, and prints them like the report of the tree does. the
+ * time it took and the memory it used are printed to the standard error.
+ * @return - the exit code of the program
  */
-AllTree *parseFile(char *file, AllTree *mainTree)
+int runStreamMode(const char *fileName, const Options *options)
 {
-    int countLines = 0;
-    int numOfNOdesInTree;
-    char *sonNodeIndex;
-    char line[1024];
-    char analyzeLine[1024];
-    int nodeSons = 0;
-    int sonsCount = 0;
-    FILE *fileToProcess;
-    fileToProcess = fopen(file, "r");
-    fgets(line, 1024, (FILE *) fileToProcess);
-    numOfNOdesInTree = (int) strtol(line, NULL, 10);
-    mainTree = initTree(numOfNOdesInTree);
-    countLines++;
-    while (fgets(line, 1024, (FILE *) fileToProcess) != NULL)
-    {
-        nodeSons = 0;
-        sscanf(line, "%[^\r\n]", line);
-        strcpy(analyzeLine, line);
-        sonNodeIndex = strtok(analyzeLine, DELIMITER);
-        if (strcmp(sonNodeIndex, NOSONS) != 0)
-        {
-            nodeSons = 0;
-            while (sonNodeIndex != NULL)
-            {
-                nodeSons++;
-                sonNodeIndex = strtok(NULL, DELIMITER);
-            }
-        }
-        if (initNode(countLines - 1, nodeSons, mainTree) == 1)
-        {
-            if (nodeSons > 0)
-            {
-                strcpy(analyzeLine, line);
-                sonNodeIndex = strtok(analyzeLine, DELIMITER);
-                sonsCount = 0;
-                while (sonNodeIndex != NULL)
-                {
-                    sonsCount++;
-                    addToNodeSon(countLines - 1, sonNodeIndex, sonsCount - 1, mainTree);
-                    sonNodeIndex = strtok(NULL, DELIMITER);
-                }
-            }
-        }
-        else
-        {
-            for (int i = 0; i <= countLines - 1; i++)
-            {
-                free(mainTree->allNodesPtr[i].nodeSons);
-            }
-            free(mainTree->allNodesPtr);
-            free(mainTree);
-            fprintf(stderr, "Memory allocation failed\n");
-            exit(EXIT_FAILURE);
-        }
-
-        countLines++;
+    struct timespec start;
+    struct timespec end;
+    ParseError error = {0, ""};
+    StreamedMetrics metrics;
+    long long numOfNodesInTree;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    startStatsPhase("stream");
+    if (streamAnalyzeTree(fileName, (size_t) options->memoryMegabytes << 20, &numOfNodesInTree,
+                          &metrics, &error) == 0)
+    {
+        printInvalidInput(&error);
+        exit(EXIT_FAILURE);
     }
-    fclose(fileToProcess);
-    return mainTree;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    startStatsPhase("output");
+    printf("Root Vertex: %lld\n", metrics.root);
+    printf("Vertices Count: %lld\n", numOfNodesInTree);
+    printf("Edges Count: %lld\n", numOfNodesInTree - 1);
+    printf("Length of Minimal Branch: %lld\n", metrics.minBranch);
+    printf("Length of Maximal Branch: %lld\n", metrics.maxBranch);
+    printf("Diameter Length: %lld\n", metrics.diameter);
+    double seconds = (double) (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "Streamed %lld vertices in %.2f seconds (%.0f vertices per second), peak "
+                    "memory %ld MB\n", numOfNodesInTree, seconds,
+            (seconds > 0) ? numOfNodesInTree / seconds : 0.0, usage.ru_maxrss / 1024);
+    return 0;
 }
 
 /**
- * @brief initializing the global tree of the program
- * @param n - the number of nodes in the graph
+ * @brief checks whether the run is the report of a tree of more than 2^31 - 1 vertices - the only
+ * thing done in memory on trees too large for the int32 columns of AllTree
+ * @param numOfArgs, args - the args given after the options
+ * @return - 1 if it is, 0 otherwise
  */
-AllTree *initTree(int n)
+int isWideRun(int numOfArgs, char *const *args, const Options *options)
 {
-    AllTree *mainTree = (AllTree *) malloc(sizeof(AllTree));
-    if (mainTree == NULL)
-    {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    mainTree->allNodesPtr = (Node *) malloc(n * sizeof(Node));
-    if (mainTree->allNodesPtr == NULL)
-    {
-        fprintf(stderr, "Memory allocation failed\n");
-        free(mainTree);
-        exit(EXIT_FAILURE);
-    }
-    mainTree->value = n;
-    for (int i = 0; i < n; i++)
-    {
-        mainTree->allNodesPtr[i].father = NULL;
-        mainTree->allNodesPtr[i].nodeSons = NULL;
-        mainTree->allNodesPtr[i].numOfSons = 0;
-        mainTree->allNodesPtr[i].previousInPath = -1;
-        mainTree->allNodesPtr[i].value = i;
-    }
-    return mainTree;
+    return numOfArgs == 3 && !options->streamMode && options->queriesFile == NULL &&
+           options->socketPath == NULL && options->eccentricityFile == NULL &&
+           options->distancesFile == NULL && options->cacheMode == CACHE_OFF &&
+           !options->incremental && options->relabelOrder == RELABEL_NONE &&
+           peekNumOfNodes(args[0]) > INT_MAX;
 }
 
 /**
- * @brief initializing a node.
- * @param value -the value of the given node to initialize
- * @param numOfSons - the number of edges referred to from the current node given.
+ * @brief prints the report of a tree of more than 2^31 - 1 vertices, read into a WideTree, the
+ * same way printTreeReport does. the BFS of the path runs on the calling thread.
+ * @param args - the graph file and the two vertices
+ * @return - the exit code of the program
  */
-int initNode(int value, int numOfSons, AllTree *mainTree)
+int runWideMode(char *const *args)
 {
-    mainTree->allNodesPtr[value].numOfSons = numOfSons;
-    if (numOfSons != 0)
+    ParseError error = {0, ""};
+    startStatsPhase("parse");
+    WideTree *tree = readWideTree(args[0], &error);
+    int valid = (tree != NULL);
+    if (valid)
+    {
+        startStatsPhase("validate");
+        valid = validateWideTree(tree, &error);
+    }
+    if (valid && (checkNodeIsValid(args[1], tree->numOfNodes) == 0 ||
+                  checkNodeIsValid(args[2], tree->numOfNodes) == 0))
+    {
+        error.line = 0;
+        snprintf(error.message, PARSE_ERROR_LENGTH, "the vertices should be between 0 and %lld",
+                 tree->numOfNodes - 1);
+        valid = 0;
+    }
+    if (!valid)
     {
-        mainTree->allNodesPtr[value].nodeSons = (Node **) malloc(numOfSons * sizeof(Node));
-        if (mainTree->allNodesPtr[value].nodeSons == NULL)
+        if (tree != NULL)
         {
-            return 0;
+            freeWideTree(tree);
         }
+        printInvalidInput(&error);
+        exit(EXIT_FAILURE);
     }
-    return 1;
+    long long u = strtoll(args[1], NULL, 10);
+    long long v = strtoll(args[2], NULL, 10);
+    StreamedMetrics metrics;
+    startStatsPhase("metrics");
+    analyzeWideTree(tree, &metrics);
+    printf("Root Vertex: %lld\n", metrics.root);
+    printf("Vertices Count: %lld\n", tree->numOfNodes);
+    printf("Edges Count: %lld\n", tree->numOfNodes - 1);
+    printf("Length of Minimal Branch: %lld\n", metrics.minBranch);
+    printf("Length of Maximal Branch: %lld\n", metrics.maxBranch);
+    printf("Diameter Length: %lld\n", metrics.diameter);
+    printf("Shortest Path Between %lld and %lld: ", u, v);
+    startStatsPhase("bfs");
+    wideBfs(tree, v);
+    startStatsPhase("output");
+    fflush(stdout);
+    OutputBuffer *out = openOutputBuffer(STDOUT_FILENO, OUTPUT_BUFFER_SIZE);
+    writeWidePath(tree, u, out);
+    closeOutputBuffer(out);
+    freeWideTree(tree);
+    return 0;
 }
 
 /**
- *  add to the given node's nodeSons pointer all the nodes that there is an edge referred to them
- *  from this node.
- * @return 1 if action successful, 0 otherwise
+ * @brief prints that the input is invalid, and what is wrong with it if known
  */
-int addToNodeSon(int fatherIndex, char sonIndex[], int sonCount, AllTree *mainTree)
+void printInvalidInput(const ParseError *error)
 {
-    int intSonIndex;
-    intSonIndex = (int) strtol(sonIndex, NULL, 10);
-    mainTree->allNodesPtr[fatherIndex].nodeSons[sonCount] = &mainTree->allNodesPtr[intSonIndex];
-    if (mainTree->allNodesPtr[intSonIndex].father == NULL)
+    fprintf(stderr, "Invalid input\n");
+    if (error->line != 0)
     {
-        mainTree->allNodesPtr[intSonIndex].father = &mainTree->allNodesPtr[fatherIndex];
-        return 1;
+        fprintf(stderr, "line %ld: %s\n", error->line, error->message);
     }
-    else
+    else if (error->message[0] != '\0')
     {
-        return 0;
+        fprintf(stderr, "%s\n", error->message);
     }
 }
 
 /********************************************************************************
 *********************************************************************************
-**************         Functions On Tree            *****************************
+*******************         validity checks            **************************
 *********************************************************************************
 ********************************************************************************/
+
 /**
- * @brief finds the root of the global tree, based on the fact that the root is the only node
- * with no father(=no edge directed to him)
- * @return - the address of the root. if no nodes, or no more than one node is in the tree,
- * returns its address.
+ * @brief - reads the options given before the graph file, each of them starting with "--".
+ * @param numOfArgs - the num of args given to the program at run
+ * @param argv - a pointer to the args given by the user in the cmd while running the program
+ * @param options - out: the options, with the defaults of those that weren't given
+ * @return - the index in argv of the first arg that isn't an option, -1 if an option is invalid
  */
-Node *findRoot(AllTree *mainTree)
+int parseOptions(int numOfArgs, char *const *argv, Options *options)
 {
-    for (int i = 0; i < mainTree->value; i++)
-    {
-        if (mainTree->allNodesPtr[i].father == NULL)
+    long numOfProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    options->numOfThreads = (numOfProcessors > 0) ? (int) numOfProcessors : 1;
+    options->threadsGiven = 0;
+    options->queriesFile = NULL;
+    options->weightsFile = NULL;
+    options->socketPath = NULL;
+    options->dynamicServer = 0;
+    options->eccentricityFile = NULL;
+    options->distancesFile = NULL;
+    options->binaryOutput = 0;
+    options->cacheMode = CACHE_OFF;
+    options->incremental = 0;
+    options->relabelOrder = RELABEL_NONE;
+    options->streamMode = 0;
+    options->memoryMegabytes = 0;
+    options->statsFormat = STATS_OFF;
+    int i = 1;
+    while (i < numOfArgs && strncmp(argv[i], "--", 2) == 0)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < numOfArgs)
+        {
+            char *end;
+            long numOfThreads = strtol(argv[i + 1], &end, 10);
+            if (*end != '\0' || numOfThreads <= 0 || numOfThreads > 1024)
+            {
+                return -1;
+            }
+            options->numOfThreads = (int) numOfThreads;
+            options->threadsGiven = 1;
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < numOfArgs)
+        {
+            options->queriesFile = argv[i + 1];
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--weights") == 0 && i + 1 < numOfArgs)
+        {
+            options->weightsFile = argv[i + 1];
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < numOfArgs)
+        {
+            options->socketPath = argv[i + 1];
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--dynamic") == 0)
+        {
+            options->dynamicServer = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--eccentricity") == 0 && i + 1 < numOfArgs)
+        {
+            options->eccentricityFile = argv[i + 1];
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--distances") == 0 && i + 1 < numOfArgs)
+        {
+            options->distancesFile = argv[i + 1];
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--binary") == 0)
         {
-            return &mainTree->allNodesPtr[i];
+            options->binaryOutput = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--cache") == 0 || strcmp(argv[i], "--verify-cache") == 0)
+        {
+            options->cacheMode = (strcmp(argv[i], "--cache") == 0) ? CACHE_ON : CACHE_VERIFIED;
+            i++;
+        }
+        else if (strcmp(argv[i], "--incremental") == 0)
+        {
+            options->incremental = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--stream") == 0)
+        {
+            options->streamMode = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < numOfArgs)
+        {
+            char *end;
+            options->memoryMegabytes = strtol(argv[i + 1], &end, 10);
+            if (*end != '\0' || options->memoryMegabytes <= 0 ||
+                options->memoryMegabytes > (1L << 20))
+            {
+                return -1;
+            }
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--stats") == 0 && i + 1 < numOfArgs &&
+                 (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "json") == 0))
+        {
+            options->statsFormat = (strcmp(argv[i + 1], "text") == 0) ? STATS_TEXT : STATS_JSON;
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--relabel") == 0 && i + 1 < numOfArgs &&
+                 (strcmp(argv[i + 1], "bfs") == 0 || strcmp(argv[i + 1], "dfs") == 0))
+        {
+            options->relabelOrder = (strcmp(argv[i + 1], "bfs") == 0) ? RELABEL_BFS : RELABEL_DFS;
+            i += 2;
+        }
+        else
+        {
+            return -1;
         }
     }
-    return mainTree->allNodesPtr;
+    int numOfModes = (options->queriesFile != NULL) + (options->socketPath != NULL) +
+                     (options->eccentricityFile != NULL) + (options->distancesFile != NULL) +
+                     options->streamMode;
+    if (numOfModes > 1 ||
+        (options->binaryOutput && options->eccentricityFile == NULL &&
+         options->distancesFile == NULL) ||
+        (options->weightsFile != NULL && options->queriesFile == NULL) ||
+        (options->dynamicServer && options->socketPath == NULL) ||
+        (options->memoryMegabytes != 0 && !options->streamMode) ||
+        (options->incremental && options->cacheMode != CACHE_OFF) ||
+        (options->streamMode && (options->cacheMode != CACHE_OFF || options->incremental ||
+                                 options->relabelOrder != RELABEL_NONE)))
+    {
+        return -1;
+    }
+    if (options->memoryMegabytes == 0)
+    {
+        options->memoryMegabytes = DEFAULT_STREAM_MEMORY_MB;
+    }
+    return i;
 }
 
 /**
- * @brief - the BFS algorithm matching to work on out current tree. given a relative root, and a
- * graph which is in this case global, it measures all the distances from this root to the nodes
- * connected to it.
- * @param root - a relative node which we want to measure distances from
+ * @brief - this is the main functions that checks the validity of the input.
+ * first - numof args is checked. then the file is parsed, or loaded from its snapshot when the
+ * cache is on, or from its state brought up to date when --incremental is given - if it can't be
+ * opened or its content is invalid the input is invalid. at last the two vertices are checked
+ * against the parsed tree.
+ * @param numOfArgs - the num of args given to the program after the options
+ * @param args - the args given after the options - the file and the two vertices, or only the
+ * file in the batch, server, eccentricity and distances modes
+ * @param options - the options given to the program
+ * @param mainTree - out: the parsed tree, NULL if the file is invalid
+ * @param metrics - out: the stats of the tree when --incremental is given, root -1 otherwise
+ * @param error - out: what is wrong with the input, if anything
+ * @return - 0 if input is invalid, -1 if input args doesn't fit the required, and 1 if the input
+ * is valid
  */
-void bfsTalsEdition(Node *root, AllTree *mainTree)
+int checkValidInput(int numOfArgs, char *const *args, const Options *options,
+                    AllTree **mainTree, TreeMetrics *metrics, ParseError *error)
 {
-    int curIndex;
-    for (int i = 0; i < mainTree->value; i++)
+    int numOfVertexArgs = (options->queriesFile != NULL || options->socketPath != NULL ||
+                           options->eccentricityFile != NULL || options->distancesFile != NULL) ?
+                          0 : 2;
+    if (numOfArgs != 1 + numOfVertexArgs) // input args are invalid
     {
-        mainTree->allNodesPtr[i].distance = -1;
+        return -1;
+    }
+    *mainTree = NULL;
+    metrics->root = -1;
+    if (options->cacheMode != CACHE_OFF)
+    {
+        startStatsPhase("load cache");
+        *mainTree = loadTreeCache(args[0], options->cacheMode == CACHE_VERIFIED);
     }
-    Queue *q = allocQueue();
-    root->distance = 0;
-    enqueue(q, root->value);
-    while (!queueIsEmpty(q))
+    if (options->incremental)
     {
-        curIndex = (int) dequeue(q);
-        for (int i = 0; i < mainTree->allNodesPtr[curIndex].numOfSons; i++)
+        startStatsPhase("incremental");
+        *mainTree = updateTreeState(args[0], metrics);
+    }
+    if (*mainTree == NULL)
+    {
+        startStatsPhase("parse");
+        *mainTree = readGraphFile(args[0], options->numOfThreads, error);
+        if (*mainTree == NULL)
         {
-            if (mainTree->allNodesPtr[curIndex].nodeSons[i]->distance == -1)
-            {
-                enqueue(q, mainTree->allNodesPtr[curIndex].nodeSons[i]->value);
-                mainTree->allNodesPtr[curIndex].nodeSons[i]->distance =
-                        mainTree->allNodesPtr[curIndex].distance + 1;
-                mainTree->allNodesPtr[curIndex].nodeSons[i]->previousInPath =
-                        mainTree->allNodesPtr[curIndex]
-                                .value;
-            }
+            return 0;
         }
-        if (mainTree->allNodesPtr[curIndex].father != NULL)
+        startStatsPhase("validate");
+        if (validateTree(*mainTree, error) == 0)
         {
-            if (mainTree->allNodesPtr[curIndex].father->distance == -1)
+            return 0;
+        }
+        if (options->cacheMode != CACHE_OFF)
+        {
+            startStatsPhase("write cache");
+            if (writeTreeCache(args[0], *mainTree) == 0)
             {
-                enqueue(q, mainTree->allNodesPtr[curIndex].father->value);
-                mainTree->allNodesPtr[curIndex].father->distance = mainTree->allNodesPtr[curIndex]
-                                                                           .distance + 1;
-                mainTree->allNodesPtr[curIndex].father->previousInPath =
-                        mainTree->allNodesPtr[curIndex].value;
+                fprintf(stderr, "Warning: the snapshot of %s can't be written\n", args[0]);
             }
         }
-    }
-    freeQueue(&q);
-}
-
-/**
- * @brief this function iterates over all the nodes in our tree, and returns the one having the
- * maximum distance. recommended to run after using BFS
- * @param flag - if 1 is given, the function returns the value of the node in the maximum
- * distance place. if 0 - the the distance value.
- * @return given above.
- */
-int findMaxDist(int flag, AllTree *mainTree)
-{
-    int max = mainTree->allNodesPtr[0].distance;
-    int tempIndex = mainTree->allNodesPtr[0].value;
-    for (int i = 0; i < mainTree->value; i++)
-    {
-        if (mainTree->allNodesPtr[i].distance > max)
+        if (options->incremental)
         {
-            max = mainTree->allNodesPtr[i].distance;
-            tempIndex = mainTree->allNodesPtr[i].value;
+            startStatsPhase("write state");
+            if (writeTreeState(args[0], *mainTree, metrics) == 0)
+            {
+                fprintf(stderr, "Warning: the state of %s can't be written\n", args[0]);
+            }
         }
     }
-    if (flag == 0)
+    if (numOfVertexArgs > 0 && ((checkNodeIsValid(args[1], (*mainTree)->value) == 0) ||
+                                (checkNodeIsValid(args[2], (*mainTree)->value) == 0)))
     {
-        return max;
-    }
-    else
-    {
-        return tempIndex;
+        snprintf(error->message, PARSE_ERROR_LENGTH, "the vertices should be between 0 and %d",
+                 (*mainTree)->value - 1);
+        return 0;
     }
+    return 1;
 }
 
 /**
- * @brief in this function we iterate over all the distances of the nodes in the tree, and return
- * the distance of the lowest.
- * recommended to run after using BFS, relevant to return the minimum dist from a specific node.
- * @return - the minimum distance of an node in the tree from a node the last bfs was run on.
+ * @brief - this function checks whether when given a node value, if it is legal in the given
+ * tree - which means if it is written only with digits, and is a valid number between 0 to n-1.
+ * @param nodeValue - the node value to check on
+ * @param numOfNodesInTree - the number of nodes in the tree
+ * @return - 0 if invalid, 1 if valid
  */
-int findMinDist(AllTree *mainTree)
+int checkNodeIsValid(const char *nodeValue, long long numOfNodesInTree)
 {
-    int min = mainTree->value;
-    for (int i = 0; i < mainTree->value; i++)
+    long long intNodeIndex = 0;
+    if (nodeValue == NULL || *nodeValue == '\0')
+    {
+        return 0;
+    }
+    for (; *nodeValue != '\0'; nodeValue++)
     {
-        if (mainTree->allNodesPtr[i].distance < min && mainTree->allNodesPtr[i].numOfSons == 0)
+        if (*nodeValue < '0' || *nodeValue > '9')
         {
-            min = mainTree->allNodesPtr[i].distance;
+            return 0;
+        }
+        intNodeIndex = intNodeIndex * 10 + (*nodeValue - '0');
+        if (intNodeIndex >= numOfNodesInTree)
+        {
+            return 0;
         }
     }
-    return min;
-}
-
-/**
- * @brief find the longest route in the tree. first we run a bfs from the root. then we run a bfs
- * on the furthest node from the root. the maximum route would be given by the furthest node from
- * the furthest node from the root.
- * @param root - the root of the tree
- * @return - the distance of the longest route in the tree
- */
-int findDiameterLength(Node *root, AllTree *mainTree)
-{
-    bfsTalsEdition(root, mainTree);
-
-    int max = findMaxDist(1, mainTree);
-    bfsTalsEdition(&mainTree->allNodesPtr[max], mainTree);
-    return findMaxDist(0, mainTree);
-
+    return 1;
 }
 
 /********************************************************************************
 *********************************************************************************
-**************            Freeing Space             *****************************
+**************         Functions On Tree            *****************************
 *********************************************************************************
 ********************************************************************************/
 /**
- * @brief free all the memory kept in the heap
+ * @brief - the BFS algorithm matching to work on out current tree. given a relative root, and a
+ * graph which is in this case global, it measures all the distances from this root to the nodes
+ * connected to it.
+ * @param root - a relative node which we want to measure distances from
+ * @param scratch - the state of the BFS, reused by every call
  */
-void freeTree(AllTree *mainTree)
+void bfsTalsEdition(int root, AllTree *mainTree, BfsScratch *scratch)
 {
-    for (int i = 0; i < mainTree->value; i++)
-    {
-        free(mainTree->allNodesPtr[i].nodeSons);
-    }
-    free(mainTree->allNodesPtr);
-    free(mainTree);
+    scratchBfs(mainTree, scratch, root, mainTree->distance, mainTree->previousInPath);
 }
-
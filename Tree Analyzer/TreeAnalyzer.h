@@ -0,0 +1,1171 @@
+/**
+* @file TreeAnalyzer.h
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief the structures shared by the parts of the TreeAnalyzer, and the functions each part
+* exposes to the others.
+* @section LICENSE
+* This program is not a free software;
+*/
+#ifndef TREEANALYZER_H
+#define TREEANALYZER_H
+
+// the POSIX and GNU parts of the C library - threads and their barriers, mmap and madvise,
+// posix_fadvise, getline and the nanoseconds of stat - before any system header, which is why
+// every part of the TreeAnalyzer includes this header first
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief a file mapped read-only into memory:
+ * data - the first byte of the file
+ * size - the number of bytes in the file
+ */
+typedef struct MappedFile
+{
+    const char *data;
+    size_t size;
+} MappedFile;
+
+/**
+ * @brief the position of the parser in the mapped file:
+ * cur - the next byte to read
+ * end - one past the last byte of the file
+ */
+typedef struct Scanner
+{
+    const char *cur;
+    const char *end;
+} Scanner;
+
+/**
+ * @brief the Tree struct. the edges are kept in a compressed sparse row layout - the sons of node
+ * i are sons[sonsOffsets[i]] up to (not including) sons[sonsOffsets[i + 1]]. every other
+ * attribute of the nodes is kept in a column of its own, indexed by the number of the node:
+ * value - the number of nodes in the tree
+ * sonsOffsets - n + 1 offsets into sons
+ * sons - the sons of all the nodes, node after node
+ * father - the node directing to each node in the graph, -1 if none
+ * distance - relevant when measuring distance from other nodes in a graph
+ * previousInPath - the node which we used to get to each node when measuring distance, -1 if none
+ * cache - the snapshot sonsOffsets, sons and father are mapped from when the tree was loaded by
+ * loadTreeCache, data is NULL if they are allocated
+ * originalLabel - the number every node had in the graph file, when the nodes were renumbered by
+ * relabelTree. NULL if they weren't.
+ * internalLabel - the number every node of the graph file was given by relabelTree, NULL if none
+ */
+typedef struct AllTree
+{
+    int value;
+    int32_t *sonsOffsets;
+    int32_t *sons;
+    int32_t *father;
+    int32_t *distance;
+    int32_t *previousInPath;
+    MappedFile cache;
+    int32_t *originalLabel;
+    int32_t *internalLabel;
+} AllTree;
+
+/**
+ * @brief the number of sons of a node in the tree
+ */
+#define NUM_OF_SONS(mainTree, node) ((mainTree)->sonsOffsets[(node) + 1] - \
+                                     (mainTree)->sonsOffsets[(node)])
+
+/**
+ * @brief the number a node has in the graph file, and the number a vertex of the graph file has
+ * in the tree - the same unless the tree was relabeled
+ */
+#define ORIGINAL_LABEL(mainTree, node) (((mainTree)->originalLabel != NULL) ? \
+                                        (mainTree)->originalLabel[(node)] : (node))
+#define INTERNAL_LABEL(mainTree, vertex) (((mainTree)->internalLabel != NULL) ? \
+                                          (mainTree)->internalLabel[(vertex)] : (vertex))
+
+/**
+ * @brief the orders relabelTree may number the nodes in
+ */
+#define RELABEL_NONE 0
+#define RELABEL_BFS 1
+#define RELABEL_DFS 2
+
+/**
+ * @brief the state of a sequential BFS, kept between BFS runs so they allocate nothing:
+ * numOfNodes - the number of nodes of the trees it fits
+ * queue - room for all the nodes. every node is queued at most once in a run, so the queue never
+ * wraps around.
+ * stamp - the run that last reached every node
+ * generation - the number of the current run. a node is reached in this run if its stamp is the
+ * generation, so nothing is reset between runs.
+ * nextFrontier - room for all the nodes, for a parallel BFS to write the next level into while it
+ * reads the current one from the queue. NULL until the first parallel BFS on the scratch.
+ */
+typedef struct BfsScratch
+{
+    int numOfNodes;
+    int32_t *queue;
+    uint32_t *stamp;
+    uint32_t generation;
+    int32_t *nextFrontier;
+} BfsScratch;
+
+/**
+ * @brief the stats of a tree, as computed by analyzeTree:
+ * root - the root of the tree
+ * minBranch, maxBranch - the length of the shortest and longest route from the root to a leaf
+ * diameter - the length of the longest route in the tree
+ * diameterStart, diameterEnd - the two ends of such a longest route
+ */
+typedef struct TreeMetrics
+{
+    int root;
+    int minBranch;
+    int maxBranch;
+    int diameter;
+    int diameterStart;
+    int diameterEnd;
+} TreeMetrics;
+
+/**
+ * @brief the stats of a tree computed by streamAnalyzeTree - the fields of TreeMetrics, as 64 bit
+ * numbers since a streamed tree may have more than 2^31 nodes
+ */
+typedef struct StreamedMetrics
+{
+    long long root;
+    long long minBranch;
+    long long maxBranch;
+    long long diameter;
+    long long diameterStart;
+    long long diameterEnd;
+} StreamedMetrics;
+
+/**
+ * @brief a tree of more than 2^31 - 1 nodes, too many for the int32 columns of AllTree, read by
+ * readWideTree. its columns are laid out as in AllTree, but every id and offset in them is width
+ * bytes - 4 (uint32_t) up to 2^32 - 1 nodes and 8 (uint64_t) above it, the largest value
+ * standing for a missing father:
+ * numOfNodes - the number of nodes
+ * width - the size of the ids and the offsets, chosen when the first line is read
+ * root - the root, -1 until the tree is validated
+ * sonsOffsets, sons - the sons of every node
+ * father - the father of every node, NULL until the tree is validated
+ * previousInPath - the node every node was reached from by the last BFS, NULL until the first one
+ */
+typedef struct WideTree
+{
+    long long numOfNodes;
+    int width;
+    long long root;
+    void *sonsOffsets;
+    void *sons;
+    void *father;
+    void *previousInPath;
+} WideTree;
+
+/**
+ * @brief the center of a tree, as found by allEccentricities:
+ * radius - the least eccentricity of a node in the tree
+ * center - the first node of that eccentricity
+ * secondCenter - the other node of that eccentricity, -1 if the center is a single node
+ */
+typedef struct TreeCenter
+{
+    int radius;
+    int center;
+    int secondCenter;
+} TreeCenter;
+
+/**
+ * @brief an index over a tree for lowest common ancestor queries, built by buildLcaIndex:
+ * numOfNodes - the number of nodes in the tree
+ * father - the father column of the tree, not owned by the index
+ * depth - the depth of every node
+ * tour - the Euler tour of the tree, tourLength = 2n - 1 nodes
+ * firstInTour - the first position of every node in the tour
+ * blockTable - blockTable[k][b] is the shallowest node in the 2^k blocks of the tour starting at
+ * block b, for numOfLevels levels over numOfBlocks blocks
+ */
+typedef struct LcaIndex
+{
+    int numOfNodes;
+    const int32_t *father;
+    int32_t *depth;
+    int32_t *tour;
+    long tourLength;
+    int32_t *firstInTour;
+    int32_t **blockTable;
+    long numOfBlocks;
+    int numOfLevels;
+} LcaIndex;
+
+/**
+ * @brief an index over a tree for subtree queries, built by buildSubtreeIndex. the nodes are
+ * numbered in the order a DFS from the root enters them:
+ * numOfNodes - the number of nodes in the tree
+ * entry - the number of every node
+ * exit - the last number given in the subtree of every node
+ * depth - the depth of every node
+ */
+typedef struct SubtreeIndex
+{
+    int numOfNodes;
+    int32_t *entry;
+    int32_t *exit;
+    int32_t *depth;
+} SubtreeIndex;
+
+/**
+ * @brief the sum, min and max of the weights of some nodes. the min and max of no nodes are
+ * INT64_MAX and INT64_MIN.
+ */
+typedef struct PathAggregate
+{
+    long long sum;
+    long long min;
+    long long max;
+} PathAggregate;
+
+/**
+ * @brief a heavy-light decomposition of a tree with a segment tree over its chains, built by
+ * buildHldIndex:
+ * numOfNodes - the number of nodes in the tree
+ * father - the father column of the tree, not owned by the index
+ * depth - the depth of every node
+ * chainHead - the top node of the chain of every node
+ * position - the position of every node in the layout of the chains
+ * segments - the segment tree over the layout, segments[1] being the whole layout and the
+ * children of segments[i] being segments[2i] and segments[2i + 1]. the leaves start at
+ * numOfLeaves, the smallest power of 2 that isn't smaller than numOfNodes.
+ */
+typedef struct HldIndex
+{
+    int numOfNodes;
+    const int32_t *father;
+    int32_t *depth;
+    int32_t *chainHead;
+    int32_t *position;
+    PathAggregate *segments;
+    long numOfLeaves;
+} HldIndex;
+
+/**
+ * @brief a centroid decomposition of a tree, built by buildCentroidIndex:
+ * numOfNodes - the number of nodes in the tree
+ * centroidParent - the centroid whose removal left the component every node is the centroid of,
+ * -1 for the centroid of the whole tree
+ * within, withinLength - within[c][k] is the number of nodes of the component of c within
+ * distance k of c, for k below withinLength[c]
+ * parentWithin, parentWithinLength - the same for the distances from centroidParent[c] of the
+ * nodes of the component of c. NULL for the centroid of the whole tree.
+ * lca - an LCA index of the tree, for the distances between nodes and their centroids
+ * histogram, histogramLength - histogram[k] is the number of pairs of nodes at distance k. NULL
+ * if not asked for.
+ */
+typedef struct CentroidIndex
+{
+    int numOfNodes;
+    int32_t *centroidParent;
+    int32_t **within;
+    int32_t *withinLength;
+    int32_t **parentWithin;
+    int32_t *parentWithinLength;
+    LcaIndex *lca;
+    long long *histogram;
+    long histogramLength;
+} CentroidIndex;
+
+/**
+ * @brief a forest of rooted trees that may change, kept as link-cut trees by TreeLinkCut.c. every
+ * preferred path of the forest is a splay tree over the columns, ordered by depth:
+ * numOfNodes - the number of nodes in the forest
+ * left, right - the children of every node in its splay tree, -1 if none
+ * parent - the parent of every node in its splay tree. for the root of a splay tree, the father of
+ * the top of its path - its path-parent - or -1 at the root of a tree.
+ * size - the number of nodes in the splay subtree of every node
+ */
+typedef struct LinkCutTree
+{
+    int numOfNodes;
+    int32_t *left;
+    int32_t *right;
+    int32_t *parent;
+    int32_t *size;
+} LinkCutTree;
+
+/**
+ * @brief output written through a buffer by TreeOutput.c, flushed to fd when full or when asked
+ * to:
+ * fd - where the output is written
+ * data, capacity, length - the buffer, its size, and the output in it
+ * failed - set once a write failed, after which nothing else is written
+ */
+typedef struct OutputBuffer
+{
+    int fd;
+    char *data;
+    size_t capacity;
+    size_t length;
+    int failed;
+} OutputBuffer;
+
+#define PARSE_ERROR_LENGTH 128
+
+/**
+ * @brief the first error found in an invalid graph file:
+ * line - the line of the error, starting from 1. 0 if there is no error, or if the error isn't
+ * in a single line
+ * message - what is wrong, empty if there is no error
+ */
+typedef struct ParseError
+{
+    long line;
+    char message[PARSE_ERROR_LENGTH];
+} ParseError;
+
+#define NOSONS '-'
+#define DELIMITER ' '
+#define LINE_INVALID (-1)
+#define LINE_BLANK (-2)
+
+// the messages of the errors in the lines of a graph file, whichever way the file is read
+#define ERROR_NUM_OF_NODES "the first line should be a positive number of vertices"
+#define ERROR_INVALID_LINE "a line should be \"-\" or vertices between 0 and n-1 separated by " \
+                           "spaces"
+#define ERROR_EMPTY_LINE "empty line"
+#define ERROR_MISSING_LINES "the file has less lines than vertices"
+#define ERROR_EXTRA_CONTENT "unexpected content after the line of the last vertex"
+#define ERROR_TOO_MANY_SONS "too many sons in the file"
+#define ERROR_TOO_MANY_NODES "more than 2147483647 vertices are only read whole for the path " \
+                             "between two vertices, and otherwise need --stream"
+#define ERROR_EMPTY_FILE "the file can't be opened, or is empty"
+#define ERROR_INVALID_WEIGHT "a line should be a single integer between -2147483648 and " \
+                             "2147483647"
+
+/**
+ * @brief the state of building a tree out of the lines of a graph file fed one at a time, for
+ * content that isn't in memory all at once:
+ * mainTree - the tree being built, NULL until the first line is fed
+ * sonsCapacity - the number of sons allocated in mainTree->sons
+ * nodesCapacity - the number of nodes with room for their offsets in mainTree->sonsOffsets. the
+ * fathers, the distances and the paths are only allocated once all the lines were fed.
+ * numOfNodesInTree - the number of nodes, as read from the first line
+ * numOfNodes - the number of lines of nodes fed so far
+ * line - the number of the next line, starting from 1
+ * failed - set once an error was found. the lines fed after it are ignored.
+ */
+typedef struct LineFeed
+{
+    AllTree *mainTree;
+    int sonsCapacity;
+    int nodesCapacity;
+    int numOfNodesInTree;
+    int numOfNodes;
+    long line;
+    int failed;
+} LineFeed;
+
+/********************************************************************************
+*******************          TreeParser.c               *************************
+********************************************************************************/
+
+/**
+ * @brief maps a whole file into memory for reading.
+ * @param fileName - the path of the file
+ * @param file - out: the mapping
+ * @return - 1 for success, 0 if the file can't be opened or is empty
+ */
+int mapFile(const char *fileName, MappedFile *file);
+
+/**
+ * @brief releases a mapping made by mapFile
+ */
+void unmapFile(MappedFile *file);
+
+/**
+ * @brief finds where the content of the current line ends, ignoring the line break
+ * @param scanner - the scanner, positioned inside the line
+ * @param next - out: the start of the next line
+ * @return - one past the last char of the content
+ */
+const char *lineContentEnd(const Scanner *scanner, const char **next);
+
+/**
+ * @brief reads the content of the line of a single node - either "-", or the sons of the node
+ * separated by spaces, each of them a number between 0 to n-1. there is a reader for the sons of
+ * every width of ids - scanSons for int32_t, scanSons32 for uint32_t and scanSons64 for uint64_t.
+ * @param p - the first char of the line
+ * @param contentEnd - one past the last char of the content of the line
+ * @param numOfNodesInTree - the number of nodes in the tree, at most LLONG_MAX / 10
+ * @param sons - where to write the sons, NULL to only count them
+ * @param room - the number of sons that fit in sons. any sons beyond it are only counted.
+ * @return - the number of sons, LINE_BLANK if the line has nothing but spaces, LINE_INVALID if
+ * the line is invalid
+ */
+long long scanSons(const char *p, const char *contentEnd, long long numOfNodesInTree, int32_t *sons,
+                   long long room);
+
+long long scanSons32(const char *p, const char *contentEnd, long long numOfNodesInTree,
+                     uint32_t *sons, long long room);
+
+long long scanSons64(const char *p, const char *contentEnd, long long numOfNodesInTree,
+                     uint64_t *sons, long long room);
+
+/**
+ * @brief validates a graph file and builds the tree out of it. exits the program if memory
+ * allocation fails.
+ * @param fileName - the path of the graph file
+ * @param numOfThreads - the maximal number of threads to parse with. small files are always
+ * parsed by a single thread. the parsed graph is checked with validateTree.
+ * @param error - out: the first error in the file if it is invalid. may be NULL. the error is the
+ * same whatever the number of threads.
+ * @return - the tree, or NULL if the file can't be read or its content is invalid
+ */
+AllTree *parseTreeFile(const char *fileName, int numOfThreads, ParseError *error);
+
+/**
+ * @brief reads a graph file like parseTreeFile, without checking that the graph is a tree - the
+ * fathers aren't set. the graph should be checked with validateTree before it is used. files
+ * compressed with gzip or zstd are recognized by their first bytes, and read by
+ * readGraphFileInBuffers, and so are large files parsed by a single thread.
+ * @return - the graph, or NULL if the file can't be read or its content is invalid
+ */
+AllTree *readGraphFile(const char *fileName, int numOfThreads, ParseError *error);
+
+/**
+ * @brief reads the weights of the nodes of a tree from a file - a line per node in the order of
+ * the nodes, holding a single integer of 32 bits. only blank lines may follow.
+ * @param error - out: the first error in the file if it is invalid, may be NULL
+ * @return - the weights in the heap, or NULL if the file can't be read or is invalid
+ */
+long long *parseWeightsFile(const char *fileName, int numOfNodesInTree, ParseError *error);
+
+/**
+ * @brief starts a line feed, before the first line of the file
+ */
+void startLineFeed(LineFeed *feed);
+
+/**
+ * @brief feeds the next line of a graph file to a line feed. the lines are read exactly as
+ * readGraphFile reads them, and the errors are the same.
+ * @param p - the first char of the line
+ * @param lineEnd - the line break at the end of the line, or the end of the file
+ * @param error - out: the error in the line, if it is the first error
+ */
+void feedGraphLine(LineFeed *feed, const char *p, const char *lineEnd, ParseError *error);
+
+/**
+ * @brief reads the sons in the line of a single node of a graph file, the way readGraphFile reads
+ * them
+ * @param lineEnd - the line break at the end of the line, or the end of the file
+ * @param sons - where to write the sons, NULL to only count them
+ * @param room - the number of sons that fit in sons. any sons beyond it are only counted.
+ * @return - the number of sons, negative if the line is blank or invalid
+ */
+long long scanGraphLine(const char *p, const char *lineEnd, int numOfNodesInTree, int32_t *sons,
+                        long long room);
+
+/**
+ * @brief ends a line feed, after the last line of the file
+ * @param error - out: the error, if the lines fed are too few
+ * @return - the graph, without its fathers set, or NULL if an error was found
+ */
+AllTree *finishLineFeed(LineFeed *feed, ParseError *error);
+
+/**
+ * @brief initializing the tree of the program, with n nodes without any edges
+ * @param n - the number of nodes in the graph
+ * @param sonsCapacity - the number of sons to allocate room for
+ */
+AllTree *initTree(int n, int sonsCapacity);
+
+/**
+ * @brief finds the root of a valid tree - the only node without a father
+ * @return - the root. if no node is without a father, returns the first node.
+ */
+int findRoot(AllTree *mainTree);
+
+/**
+ * @brief free all the memory kept in the heap for the tree
+ */
+void freeTree(AllTree *mainTree);
+
+/**
+ * @brief allocates memory, and exits the program if the allocation fails
+ */
+void *checkedMalloc(size_t size);
+
+/**
+ * @brief resizes memory allocated by checkedMalloc, and exits the program if it fails
+ */
+void *checkedRealloc(void *memory, size_t size);
+
+/**
+ * @brief allocates zeroed memory for a number of items, and exits the program if it fails
+ */
+void *checkedCalloc(size_t numOfItems, size_t size);
+
+/**
+ * @brief allocates memory starting on a multiple of alignment, a power of two multiple of
+ * sizeof(void *), and exits the program if it fails. freed by free.
+ */
+void *checkedAlignedAlloc(size_t alignment, size_t size);
+
+/********************************************************************************
+*******************          TreeReader.c               *************************
+********************************************************************************/
+
+/**
+ * @brief the formats a graph file may be compressed in
+ */
+#define COMPRESSION_NONE 0
+#define COMPRESSION_GZIP 1
+#define COMPRESSION_ZSTD 2
+
+/**
+ * @brief finds the format of a file by its first bytes
+ * @return - one of the COMPRESSION_ constants
+ */
+int compressionOf(const char *data, size_t size);
+
+/**
+ * @brief reads a graph file in a single pass, like readGraphFile. the file is read - and
+ * decompressed - by another thread, a buffer at a time, while the lines of the buffers before are
+ * parsed. a format the program was built without - gzip needs HAVE_ZLIB, zstd needs HAVE_ZSTD -
+ * is an error.
+ * @param format - one of the COMPRESSION_ constants
+ * @return - the graph, without its fathers set, or NULL if the file can't be read or is invalid
+ */
+AllTree *readGraphFileInBuffers(const char *fileName, int format, ParseError *error);
+
+/********************************************************************************
+*******************          TreeCache.c                *************************
+********************************************************************************/
+
+/**
+ * @brief loads the tree of a graph file from its binary snapshot, written by writeTreeCache. the
+ * snapshot is mapped, not read, so only the pages that are used are ever read from the disk.
+ * @param fileName - the path of the graph file - the snapshot is next to it, with a .cache suffix
+ * @param verify - if not 0, the checksum of the whole snapshot is checked as well. otherwise only
+ * its header checksum is, and the columns are only checked to hold vertices of the tree.
+ * @return - the tree, or NULL if there is no snapshot, or it is invalid or older than the file
+ */
+AllTree *loadTreeCache(const char *fileName, int verify);
+
+/**
+ * @brief writes the binary snapshot of a tree parsed from a graph file, for loadTreeCache.
+ * the snapshot is written to a temporary file and renamed, so it is never seen half written.
+ * @return - 1 for success, 0 otherwise
+ */
+int writeTreeCache(const char *fileName, const AllTree *mainTree);
+
+/**
+ * @brief continues a checksum over more bytes
+ */
+uint64_t checksumBytes(uint64_t checksum, const void *data, size_t length);
+
+/**
+ * @brief writes a column, followed by zeros up to the next 64 bytes boundary
+ * @return - 1 for success, 0 otherwise
+ */
+int writeAlignedColumn(FILE *file, const void *data, size_t length);
+
+/**
+ * @brief the path of a file kept next to a graph file, with a suffix added to its name. in the
+ * heap.
+ */
+char *cachePathOf(const char *fileName, const char *suffix);
+
+/********************************************************************************
+*******************          TreeIncremental.c          *************************
+********************************************************************************/
+
+/**
+ * @brief brings the state kept next to a graph file by the last run up to date with the file, and
+ * loads the tree out of it. only the lines that changed are parsed, and only the changed nodes and
+ * their ancestors are checked and analyzed again, so a small change costs little more than
+ * hashing the lines of the file.
+ * @param fileName - the path of the graph file - the state is next to it, with a .state suffix
+ * @param metrics - out: the stats of the tree
+ * @return - the tree, or NULL if there is no state, or the file has to be parsed as a whole - the
+ * first line or the number of lines changed, too many lines changed, or the file isn't a valid
+ * tree anymore
+ */
+AllTree *updateTreeState(const char *fileName, TreeMetrics *metrics);
+
+/**
+ * @brief analyzes a tree parsed as a whole from a graph file, and keeps the state
+ * updateTreeState needs next to the file. the state is written to a temporary file and renamed,
+ * so it is never seen half written.
+ * @param mainTree - a valid tree, not relabeled
+ * @param metrics - out: the stats of the tree, even if the state can't be written
+ * @return - 1 for success, 0 otherwise
+ */
+int writeTreeState(const char *fileName, const AllTree *mainTree, TreeMetrics *metrics);
+
+/********************************************************************************
+*******************          TreeRelabel.c              *************************
+********************************************************************************/
+
+/**
+ * @brief renumbers the nodes of a tree in the order a traversal from the root visits them, so
+ * nodes that are visited together are next to each other in memory. the sons of every node keep
+ * their order. the root becomes node 0. exits the program if memory allocation fails.
+ * @param mainTree - a valid tree, not relabeled yet
+ * @param root - the root of the tree
+ * @param order - RELABEL_BFS for BFS order, RELABEL_DFS for DFS preorder
+ */
+void relabelTree(AllTree *mainTree, int root, int order);
+
+/**
+ * @brief puts values indexed by the vertices of the graph file in the order of the nodes of a
+ * relabeled tree. does nothing if the tree wasn't relabeled.
+ */
+void toInternalOrder(const AllTree *mainTree, long long *values);
+
+/**
+ * @brief puts values indexed by the nodes of a relabeled tree back in the order of the vertices
+ * of the graph file. does nothing if the tree wasn't relabeled.
+ */
+void toOriginalOrder(const AllTree *mainTree, int32_t *values);
+
+/********************************************************************************
+*******************          TreeStream.c               *************************
+********************************************************************************/
+
+/**
+ * @brief computes the stats of the tree in a graph file without reading it into memory, from
+ * sequential passes over temporary files in $TMPDIR (or /tmp). the file is checked the same way
+ * parseTreeFile and validateTree check it. exits the program if the temporary files can't be
+ * written or read.
+ * @param memoryBudget - about the number of bytes of memory to use
+ * @param numOfNodesInTree - out: the number of nodes in the tree, which unlike the trees read
+ * into memory may be 2^31 or more
+ * @param metrics - out: the stats of the tree
+ * @param error - out: the first error in the file if it is invalid, may be NULL
+ * @return - 1 if the file is a valid tree, 0 otherwise
+ */
+int streamAnalyzeTree(const char *fileName, size_t memoryBudget, long long *numOfNodesInTree,
+                      StreamedMetrics *metrics, ParseError *error);
+
+/********************************************************************************
+*******************          TreeWide.c                 *************************
+********************************************************************************/
+
+/**
+ * @brief reads the number of vertices in the first line of a graph file, without reading the rest
+ * of it
+ * @return - the number of vertices, which may be 2^31 or more. 0 if the file can't be read, is
+ * compressed, or its first line isn't a valid number of vertices.
+ */
+long long peekNumOfNodes(const char *fileName);
+
+/**
+ * @brief reads a graph file of any number of vertices into a WideTree, checking its lines the same
+ * way readGraphFile does. exits the program if memory allocation fails.
+ * @param error - out: the first error in the file if it is invalid, may be NULL
+ * @return - the graph, without its fathers set, or NULL if an error was found
+ */
+WideTree *readWideTree(const char *fileName, ParseError *error);
+
+/**
+ * @brief checks that a graph read by readWideTree is a tree, the same way validateTree does, and
+ * sets its fathers and root on the way
+ * @param error - out: the first problem found, may be NULL
+ * @return - 1 if the graph is a tree, 0 otherwise
+ */
+int validateWideTree(WideTree *tree, ParseError *error);
+
+/**
+ * @brief computes the depth of the leaves and the diameter of a valid wide tree from its root,
+ * the same way analyzeTree does. exits the program if memory allocation fails.
+ * @param metrics - out: the stats of the tree
+ */
+void analyzeWideTree(const WideTree *tree, StreamedMetrics *metrics);
+
+/**
+ * @brief a BFS over a valid wide tree from a node, which sets the previousInPath column. exits the
+ * program if memory allocation fails.
+ */
+void wideBfs(WideTree *tree, long long from);
+
+/**
+ * @brief writes the vertices of the path from u to the node of the last wideBfs, separated by
+ * spaces and followed by a line break
+ */
+void writeWidePath(const WideTree *tree, long long u, OutputBuffer *out);
+
+/**
+ * @brief frees a wide tree
+ */
+void freeWideTree(WideTree *tree);
+
+/********************************************************************************
+*******************          TreeValidator.c            *************************
+********************************************************************************/
+
+/**
+ * @brief checks that a parsed graph is a tree - no vertex appears twice among the sons of a node,
+ * every vertex but one has exactly one father, and all the vertices are reachable from the one
+ * without a father. sets the father of every node on the way. runs in O(n) time.
+ * @param mainTree - the graph, with its sons set
+ * @param error - out: the first problem found, may be NULL
+ * @return - 1 if the graph is a tree, 0 otherwise
+ */
+int validateTree(AllTree *mainTree, ParseError *error);
+
+/**
+ * @brief the check of validateTree over the columns of a graph of any width of ids -
+ * validateColumns for int32_t, validateColumns32 for uint32_t and validateColumns64 for uint64_t.
+ * exits the program if memory allocation fails.
+ * @param sonsOffsets, sons - the columns of the sons of the graph
+ * @param father - out: the father of every node, (Id) -1 for the root
+ * @param n - the number of nodes
+ * @param root - out: the root, if the graph is a tree
+ * @param error - out: the first problem found, may be NULL
+ * @return - 1 if the graph is a tree, 0 otherwise
+ */
+int validateColumns(const int32_t *sonsOffsets, const int32_t *sons, int32_t *father, int32_t n,
+                    long long *root, ParseError *error);
+
+int validateColumns32(const uint32_t *sonsOffsets, const uint32_t *sons, uint32_t *father,
+                      uint32_t n, long long *root, ParseError *error);
+
+int validateColumns64(const uint64_t *sonsOffsets, const uint64_t *sons, uint64_t *father,
+                      uint64_t n, long long *root, ParseError *error);
+
+/********************************************************************************
+*******************          TreeMetrics.c              *************************
+********************************************************************************/
+
+/**
+ * @brief computes the depth of the leaves and the diameter of a tree in one pass over it, without
+ * recursion. exits the program if memory allocation fails.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param metrics - out: the stats of the tree
+ */
+void analyzeTree(const AllTree *mainTree, int root, TreeMetrics *metrics);
+
+/**
+ * @brief the computation of analyzeTree over the columns of a tree of any width of ids -
+ * analyzeColumns for int32_t, analyzeColumns32 for uint32_t and analyzeColumns64 for uint64_t.
+ * exits the program if memory allocation fails.
+ * @param sonsOffsets, sons - the columns of the sons of a valid tree
+ * @param n - the number of nodes
+ * @param root - the root of the tree
+ * @param metrics - out: the stats of the tree
+ */
+void analyzeColumns(const int32_t *sonsOffsets, const int32_t *sons, int32_t n, int32_t root,
+                    StreamedMetrics *metrics);
+
+void analyzeColumns32(const uint32_t *sonsOffsets, const uint32_t *sons, uint32_t n,
+                      uint32_t root, StreamedMetrics *metrics);
+
+void analyzeColumns64(const uint64_t *sonsOffsets, const uint64_t *sons, uint64_t n,
+                      uint64_t root, StreamedMetrics *metrics);
+
+/********************************************************************************
+*******************          TreeBfs.c                  *************************
+********************************************************************************/
+
+/**
+ * @brief measures the distance of all the nodes from a node, expanding every level of the BFS on
+ * several threads. writes the distance and previousInPath columns, like a sequential BFS would.
+ * exits the program if memory allocation or thread creation fails. experimental - it hasn't been
+ * measured to be faster than scratchBfs on several cores yet.
+ * @param mainTree - a valid tree
+ * @param scratch - the scratch of the tree, its arrays are reused as the frontiers
+ * @param root - the node to measure the distances from
+ * @param numOfThreads - the maximal number of threads to use. levels too small to be worth
+ * splitting are expanded by the calling thread alone.
+ */
+void parallelBfs(AllTree *mainTree, BfsScratch *scratch, int root, int numOfThreads);
+
+/**
+ * @brief a level of the BFS of parallelBfs over the columns of a tree of any width of ids -
+ * expandFrontier for int32_t, expandFrontier32 for uint32_t and expandFrontier64 for uint64_t.
+ * writes the neighbours of frontier[from..to) that are a level further into out. a neighbour is
+ * a level further unless it is the node its neighbour was reached from, so the previousInPath of
+ * the frontier must be set.
+ * @param sonsOffsets, sons, father - the columns of a valid tree, (Id) -1 for a missing father
+ * @param distance, previousInPath - out: the distance and the node every node written is reached
+ * from. distance may be NULL, for only previousInPath to be written.
+ * @param numOfEdges - the number of edges scanned is added to it
+ * @return - the number of nodes written
+ */
+int32_t expandFrontier(const int32_t *sonsOffsets, const int32_t *sons, const int32_t *father,
+                       int32_t *distance, int32_t *previousInPath, const int32_t *frontier,
+                       int32_t from, int32_t to, int32_t *out, long long *numOfEdges);
+
+uint32_t expandFrontier32(const uint32_t *sonsOffsets, const uint32_t *sons,
+                          const uint32_t *father, uint32_t *distance, uint32_t *previousInPath,
+                          const uint32_t *frontier, uint32_t from, uint32_t to, uint32_t *out,
+                          long long *numOfEdges);
+
+uint64_t expandFrontier64(const uint64_t *sonsOffsets, const uint64_t *sons,
+                          const uint64_t *father, uint64_t *distance, uint64_t *previousInPath,
+                          const uint64_t *frontier, uint64_t from, uint64_t to, uint64_t *out,
+                          long long *numOfEdges);
+
+/**
+ * @brief allocates the state of a sequential BFS over trees of numOfNodes nodes. exits the
+ * program if memory allocation fails.
+ */
+BfsScratch *allocBfsScratch(int numOfNodes);
+
+/**
+ * @brief measures the distance of the nodes from a node, on the calling thread, in a single pass
+ * without allocating or resetting anything.
+ * @param mainTree - a tree of at most scratch->numOfNodes nodes
+ * @param root - the node to measure the distances from
+ * @param distance, previousInPath - out: the distance of every node reached, and the node it was
+ * reached from, -1 for the root. the values of the nodes that aren't reached are left as they
+ * are - bfsReached tells them apart.
+ * @return - the number of nodes reached
+ */
+int scratchBfs(const AllTree *mainTree, BfsScratch *scratch, int root, int32_t *distance,
+               int32_t *previousInPath);
+
+/**
+ * @brief whether a node was reached by the last scratchBfs run on the scratch
+ * @return - 1 if it was, 0 otherwise
+ */
+int bfsReached(const BfsScratch *scratch, int node);
+
+/**
+ * @brief frees the state of a sequential BFS
+ */
+void freeBfsScratch(BfsScratch *scratch);
+
+/********************************************************************************
+*******************          TreeEccentricity.c         *************************
+********************************************************************************/
+
+/**
+ * @brief computes the eccentricity of every node - its distance to the node farthest from it -
+ * in O(n) time, without recursion. exits the program if memory allocation fails.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param center - out: the radius and center of the tree
+ * @return - the eccentricities, indexed by node, in the heap
+ */
+int32_t *allEccentricities(const AllTree *mainTree, int root, TreeCenter *center);
+
+/**
+ * @brief writes the eccentricities of all the nodes
+ * @param binary - if 0, a CSV of "vertex,eccentricity" lines under a header line. otherwise the
+ * 4 bytes "ECC1", the number of nodes as a uint32 and the eccentricities as int32, in the byte
+ * order of the machine.
+ * @return - 1 for success, 0 if writing failed
+ */
+int writeEccentricities(const int32_t *eccentricity, int n, OutputBuffer *out, int binary);
+
+/********************************************************************************
+*******************          TreeLca.c                  *************************
+********************************************************************************/
+
+/**
+ * @brief builds an index for LCA queries over a tree, in O(n) time and memory. the index keeps
+ * using the father column of the tree, so it must not outlive it.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ */
+LcaIndex *buildLcaIndex(const AllTree *mainTree, int root);
+
+/**
+ * @brief the lowest common ancestor of two nodes
+ */
+int findLca(const LcaIndex *index, int u, int v);
+
+/**
+ * @brief the length of the shortest path between two nodes
+ */
+int treeDistance(const LcaIndex *index, int u, int v);
+
+/**
+ * @brief writes the nodes along the shortest path between two nodes, in O(length of the path)
+ * @param path - out: the nodes, from u to v. has to have room for the whole path.
+ * @return - the number of nodes written
+ */
+int findPath(const LcaIndex *index, int u, int v, int32_t *path);
+
+/**
+ * @brief frees the index
+ */
+void freeLcaIndex(LcaIndex *index);
+
+/********************************************************************************
+*******************          TreeLinkCut.c              *************************
+********************************************************************************/
+
+/**
+ * @brief builds a forest of link-cut trees holding a single tree, in O(n). the queries and
+ * updates of the forest all change it, so it may not be used by two threads at once.
+ * @param mainTree - a valid tree
+ */
+LinkCutTree *buildLinkCutTree(const AllTree *mainTree);
+
+/**
+ * @brief the root of the tree of x in the forest, in O(log n) amortized
+ */
+int linkCutRoot(LinkCutTree *forest, int x);
+
+/**
+ * @brief the depth of x in its tree, 0 for a root, in O(log n) amortized
+ */
+int linkCutDepth(LinkCutTree *forest, int x);
+
+/**
+ * @brief the lowest common ancestor of two nodes, in O(log n) amortized
+ * @return - the LCA, -1 if the nodes are in different trees
+ */
+int linkCutLca(LinkCutTree *forest, int u, int v);
+
+/**
+ * @brief the length of the path between two nodes, in O(log n) amortized
+ * @return - the length, -1 if the nodes are in different trees
+ */
+int linkCutDistance(LinkCutTree *forest, int u, int v);
+
+/**
+ * @brief cuts x and its subtree from its father, making x the root of a tree of its own, in
+ * O(log n) amortized
+ * @return - 1 for success, 0 if x is already a root
+ */
+int linkCutCut(LinkCutTree *forest, int x);
+
+/**
+ * @brief makes y the father of x, in O(log n) amortized
+ * @param x - the root of a tree
+ * @param y - a node of another tree
+ * @return - 1 for success, 0 if x isn't a root or y is in the tree of x
+ */
+int linkCutLink(LinkCutTree *forest, int x, int y);
+
+/**
+ * @brief frees the forest
+ */
+void freeLinkCutTree(LinkCutTree *forest);
+
+/********************************************************************************
+*******************          TreeSubtree.c              *************************
+********************************************************************************/
+
+/**
+ * @brief builds an index for subtree queries over a tree, in a single DFS without recursion.
+ * exits the program if memory allocation fails.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ */
+SubtreeIndex *buildSubtreeIndex(const AllTree *mainTree, int root);
+
+/**
+ * @brief checks in O(1) whether x is an ancestor of y. a node is an ancestor of itself.
+ * @return - 1 if it is, 0 otherwise
+ */
+int isAncestor(const SubtreeIndex *index, int x, int y);
+
+/**
+ * @brief the number of nodes in the subtree of x, x included, in O(1)
+ */
+int subtreeSize(const SubtreeIndex *index, int x);
+
+/**
+ * @brief the depth of x, 0 for the root, in O(1)
+ */
+int nodeDepth(const SubtreeIndex *index, int x);
+
+/**
+ * @brief frees the index
+ */
+void freeSubtreeIndex(SubtreeIndex *index);
+
+/********************************************************************************
+*******************          TreeHld.c                  *************************
+********************************************************************************/
+
+/**
+ * @brief builds a heavy-light decomposition of a tree, in O(n) time and memory. the index keeps
+ * using the father column of the tree, so it must not outlive it.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param weights - the weights of the nodes, NULL for all of them to be 0
+ */
+HldIndex *buildHldIndex(const AllTree *mainTree, int root, const long long *weights);
+
+/**
+ * @brief the sum, min and max of the weights along the path between two nodes, both included,
+ * in O(log^2 n)
+ */
+PathAggregate hldPathQuery(const HldIndex *index, int u, int v);
+
+/**
+ * @brief sets the weight of a node, in O(log n)
+ */
+void hldSetWeight(HldIndex *index, int x, long long weight);
+
+/**
+ * @brief frees the index
+ */
+void freeHldIndex(HldIndex *index);
+
+/********************************************************************************
+*******************          TreeCentroid.c             *************************
+********************************************************************************/
+
+/**
+ * @brief builds a centroid decomposition of a tree, decomposing independent components on
+ * several threads, in O(n log n) time. exits the program if memory allocation or thread creation
+ * fails.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param numOfThreads - the number of threads to decompose on
+ * @param withHistogram - if not 0, the number of pairs of nodes at every distance is counted too,
+ * in O(n log^2 n) time
+ */
+CentroidIndex *buildCentroidIndex(const AllTree *mainTree, int root, int numOfThreads,
+                                  int withHistogram);
+
+/**
+ * @brief the number of nodes within a distance of x, x included, in O(log n) LCA queries
+ */
+long long countWithinDistance(const CentroidIndex *index, int x, long distance);
+
+/**
+ * @brief frees the index
+ */
+void freeCentroidIndex(CentroidIndex *index);
+
+/********************************************************************************
+*******************          TreeBatch.c                *************************
+********************************************************************************/
+
+/**
+ * @brief answers a stream of path, ancestor, subtree, depth, path weight and radius queries on a
+ * tree, see TreeBatch.c for the format
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param weights - the weights of the nodes, NULL for all of them to be 0 until they are set
+ * @param numOfThreads - the number of threads to build the indexes on
+ * @param queries - the queries to answer, read until the end
+ * @param out - where the answers are written. flushed after every answer if it is a terminal.
+ * @return - the number of invalid queries
+ */
+int runBatchQueries(const AllTree *mainTree, int root, const long long *weights, int numOfThreads,
+                    FILE *queries, OutputBuffer *out);
+
+/********************************************************************************
+*******************          TreeServer.c               *************************
+********************************************************************************/
+
+/**
+ * @brief keeps the tree in memory and answers queries on it until stopped by SIGINT or SIGTERM,
+ * see TreeServer.c for the protocol. the tree is only read, so it may be shared by the workers.
+ * the link-cut trees of the dynamic mode are used by a single worker at a time.
+ * @param mainTree - a valid tree
+ * @param root - the root of the tree
+ * @param socketPath - the path of the UNIX socket to listen on, or "-" to answer the queries
+ * read from the standard input on the standard output, until it ends
+ * @param numOfWorkers - the number of threads serving connections
+ * @param dynamic - if not 0, the tree may be changed by link and cut requests, and is kept as
+ * link-cut trees instead of the static indexes
+ * @return - the exit code of the program
+ */
+int runServer(const AllTree *mainTree, int root, const char *socketPath, int numOfWorkers,
+              int dynamic);
+
+/********************************************************************************
+*******************          TreeOutput.c               *************************
+********************************************************************************/
+
+/**
+ * @brief the size of the buffer of output written to a file or the standard output
+ */
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief starts buffering the output to a file descriptor, which stays open when the output is
+ * closed. exits the program if memory allocation fails.
+ * @param capacity - the size of the buffer
+ */
+OutputBuffer *openOutputBuffer(int fd, size_t capacity);
+
+/**
+ * @brief adds a string, a character, a number in decimal or raw bytes to the output, flushing it
+ * if it is full
+ */
+void appendOutput(OutputBuffer *out, const char *text);
+
+void appendChar(OutputBuffer *out, char c);
+
+void appendNumber(OutputBuffer *out, long long number);
+
+void appendBytes(OutputBuffer *out, const void *data, size_t length);
+
+/**
+ * @brief writes all the buffered output
+ * @return - 1 if all the output so far was written, 0 if writing failed
+ */
+int flushOutput(OutputBuffer *out);
+
+/**
+ * @brief writes all the buffered output and frees the buffer
+ * @return - 1 if all the output was written, 0 if writing failed
+ */
+int closeOutputBuffer(OutputBuffer *out);
+
+/********************************************************************************
+*******************          TreeStats.c                *************************
+********************************************************************************/
+
+/**
+ * @brief the formats the stats of a run may be printed in by printStats
+ */
+#define STATS_OFF 0
+#define STATS_TEXT 1
+#define STATS_JSON 2
+
+/**
+ * @brief turns the stats of the run on, to be printed in the given format when the program exits,
+ * on success or failure. all the other functions of the stats do nothing while they are off.
+ */
+void enableStats(int format);
+
+/**
+ * @brief ends the current phase of the run, if any, and starts a new one
+ * @param name - the name of the phase, kept until the stats are printed
+ */
+void startStatsPhase(const char *name);
+
+/**
+ * @brief ends the current phase of the run, if any
+ */
+void endStatsPhase(void);
+
+/**
+ * @brief counts an allocation of size bytes. may be called by any thread.
+ */
+void countAllocation(size_t size);
+
+/**
+ * @brief counts a BFS that reached numOfNodes nodes and scanned numOfEdges edges - an edge is
+ * counted once from each of its ends that was reached. may be called by any thread.
+ */
+void countBfs(long long numOfNodes, long long numOfEdges);
+
+/**
+ * @brief ends the current phase, and prints the wall and CPU time, the allocations, the peak
+ * resident memory and the BFS runs of every phase, and their total, to the standard error.
+ * called at exit once the stats are enabled.
+ */
+void printStats(void);
+
+#endif //TREEANALYZER_H
@@ -0,0 +1,307 @@
+/**
+* @file TreeBatch.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief answering many queries on the same tree
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, and a stream of queries - a line per query, which is one of:
+*   <u> <v>             - the shortest path between u and v
+*   ancestor <x> <y>    - whether x is an ancestor of y (or y itself)
+*   subtree <x>         - the number of vertices in the subtree of x, x included
+*   depth <x>           - the distance of x from the root
+*   sum|min|max <u> <v> - the sum, min or max of the weights of the vertices on the path between u
+*                         and v, both included
+*   set <x> <weight>    - sets the weight of x, a 32 bit integer
+*   within <x> <d>      - the number of vertices within distance d of x, x included
+* Process: an LcaIndex is built once, and every path query is answered from it without a BFS.
+* a SubtreeIndex is built at the first query that needs it, and answers the others in O(1).
+* an HldIndex is built at the first weight query, and answers the weight queries in O(log^2 n).
+* a CentroidIndex is built at the first within query, and answers them in O(log n) LCA queries.
+* Output : a line per query - for a path, its length, a colon, and the vertices along it. "Yes" or
+* "No" for an ancestor query, "OK" for a set, and a number for the others. "Invalid query" for
+* invalid lines.
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define QUERY_INVALID 0
+#define QUERY_PATH 1
+#define QUERY_ANCESTOR 2
+#define QUERY_SUBTREE 3
+#define QUERY_DEPTH 4
+#define QUERY_SUM 5
+#define QUERY_MIN 6
+#define QUERY_MAX 7
+#define QUERY_SET 8
+#define QUERY_WITHIN 9
+
+/**
+ * @brief reads a vertex from a query line
+ * @param p - the position in the line, advanced past the vertex
+ * @param numOfNodesInTree - the number of nodes in the tree
+ * @return - the vertex, -1 if there is no valid vertex there
+ */
+int scanQueryVertex(const char **p, int numOfNodesInTree);
+
+/**
+ * @brief reads a weight from a query line
+ * @param p - the position in the line, advanced past the weight
+ * @return - 1 if there is a valid weight there, 0 otherwise
+ */
+int scanQueryWeight(const char **p, long long *weight);
+
+/**
+ * @brief reads a query line
+ * @param u, v - out: the vertices of the query, v is -1 for queries of a single vertex
+ * @param weight - out: the weight of a set query, or the distance of a within query
+ * @return - the kind of the query, QUERY_INVALID if the line isn't a valid query
+ */
+int parseQuery(const char *line, int numOfNodesInTree, int *u, int *v, long long *weight);
+
+/**
+ * @brief prints the answer of a weight query
+ */
+void answerWeightQuery(HldIndex *weightIndex, int kind, int u, int v, long long weight,
+                       OutputBuffer *out);
+
+/**
+ * @brief reads the word a query line may start with
+ * @param p - the position in the line, advanced past the word
+ * @return - the kind of the query the word starts, QUERY_INVALID for an unknown word, and
+ * QUERY_PATH if there is no word
+ */
+int scanQueryKind(const char **p);
+
+int runBatchQueries(const AllTree *mainTree, int root, const long long *weights, int numOfThreads,
+                    FILE *queries, OutputBuffer *out)
+{
+    LcaIndex *index = buildLcaIndex(mainTree, root);
+    SubtreeIndex *subtrees = NULL;
+    HldIndex *weightIndex = NULL;
+    CentroidIndex *centroids = NULL;
+    int32_t *path = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    size_t countedCapacity = 0;
+    int numOfInvalid = 0;
+    int interactive = isatty(out->fd);
+    int u;
+    int v;
+    long long weight;
+    // on a terminal the answers are shown before the next query is waited for
+    while ((interactive ? flushOutput(out) : 1) && getline(&line, &lineCapacity, queries) != -1)
+    {
+        if (lineCapacity != countedCapacity) // getline allocated the line, so it is counted here
+        {
+            countAllocation(lineCapacity);
+            countedCapacity = lineCapacity;
+        }
+        int kind = parseQuery(line, mainTree->value, &u, &v, &weight);
+        if (kind == QUERY_INVALID)
+        {
+            appendOutput(out, "Invalid query\n");
+            numOfInvalid++;
+            continue;
+        }
+        u = INTERNAL_LABEL(mainTree, u);
+        v = (v != -1) ? INTERNAL_LABEL(mainTree, v) : -1;
+        if (kind == QUERY_WITHIN)
+        {
+            if (centroids == NULL)
+            {
+                centroids = buildCentroidIndex(mainTree, root, numOfThreads, 0);
+            }
+            appendNumber(out, countWithinDistance(centroids, u, (long) weight));
+            appendChar(out, '\n');
+            continue;
+        }
+        if (kind >= QUERY_SUM)
+        {
+            if (weightIndex == NULL)
+            {
+                weightIndex = buildHldIndex(mainTree, root, weights);
+            }
+            answerWeightQuery(weightIndex, kind, u, v, weight, out);
+            continue;
+        }
+        if (kind != QUERY_PATH && subtrees == NULL)
+        {
+            subtrees = buildSubtreeIndex(mainTree, root);
+        }
+        if (kind == QUERY_ANCESTOR)
+        {
+            appendOutput(out, isAncestor(subtrees, u, v) ? "Yes\n" : "No\n");
+            continue;
+        }
+        if (kind == QUERY_SUBTREE || kind == QUERY_DEPTH)
+        {
+            appendNumber(out, (kind == QUERY_SUBTREE) ? subtreeSize(subtrees, u) :
+                              nodeDepth(subtrees, u));
+            appendChar(out, '\n');
+            continue;
+        }
+        int numOfVertices = findPath(index, u, v, path); // already in order, from u to v
+        appendNumber(out, numOfVertices - 1);
+        appendChar(out, ':');
+        for (int i = 0; i < numOfVertices; i++)
+        {
+            appendChar(out, ' ');
+            appendNumber(out, ORIGINAL_LABEL(mainTree, path[i]));
+        }
+        appendChar(out, '\n');
+    }
+    free(line);
+    free(path);
+    freeLcaIndex(index);
+    if (subtrees != NULL)
+    {
+        freeSubtreeIndex(subtrees);
+    }
+    if (weightIndex != NULL)
+    {
+        freeHldIndex(weightIndex);
+    }
+    if (centroids != NULL)
+    {
+        freeCentroidIndex(centroids);
+    }
+    return numOfInvalid;
+}
+
+void answerWeightQuery(HldIndex *weightIndex, int kind, int u, int v, long long weight,
+                       OutputBuffer *out)
+{
+    if (kind == QUERY_SET)
+    {
+        hldSetWeight(weightIndex, u, weight);
+        appendOutput(out, "OK\n");
+        return;
+    }
+    PathAggregate aggregate = hldPathQuery(weightIndex, u, v);
+    if (kind == QUERY_SUM)
+    {
+        appendNumber(out, aggregate.sum);
+    }
+    else
+    {
+        appendNumber(out, (kind == QUERY_MIN) ? aggregate.min : aggregate.max);
+    }
+    appendChar(out, '\n');
+}
+
+int parseQuery(const char *line, int numOfNodesInTree, int *u, int *v, long long *weight)
+{
+    const char *p = line;
+    int kind = scanQueryKind(&p);
+    *u = scanQueryVertex(&p, numOfNodesInTree);
+    *v = -1;
+    if ((kind == QUERY_SET || kind == QUERY_WITHIN) && (scanQueryWeight(&p, weight) == 0 ||
+                                                        (kind == QUERY_WITHIN && *weight < 0)))
+    {
+        return QUERY_INVALID;
+    }
+    if (kind == QUERY_PATH || kind == QUERY_ANCESTOR || kind == QUERY_SUM || kind == QUERY_MIN ||
+        kind == QUERY_MAX)
+    {
+        *v = scanQueryVertex(&p, numOfNodesInTree);
+        if (*v == -1)
+        {
+            return QUERY_INVALID;
+        }
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+    {
+        p++;
+    }
+    return (*u != -1 && *p == '\0') ? kind : QUERY_INVALID;
+}
+
+int scanQueryKind(const char **p)
+{
+    static const char *const words[] = {"ancestor", "subtree", "depth", "sum", "min", "max",
+                                        "set", "within"};
+    static const int kinds[] = {QUERY_ANCESTOR, QUERY_SUBTREE, QUERY_DEPTH, QUERY_SUM, QUERY_MIN,
+                                QUERY_MAX, QUERY_SET, QUERY_WITHIN};
+    const char *cur = *p;
+    while (*cur == ' ' || *cur == '\t')
+    {
+        cur++;
+    }
+    if (*cur >= '0' && *cur <= '9')
+    {
+        *p = cur;
+        return QUERY_PATH;
+    }
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+    {
+        size_t length = strlen(words[i]);
+        if (strncmp(cur, words[i], length) == 0 && (cur[length] == ' ' || cur[length] == '\t'))
+        {
+            *p = cur + length;
+            return kinds[i];
+        }
+    }
+    return QUERY_INVALID;
+}
+
+int scanQueryVertex(const char **p, int numOfNodesInTree)
+{
+    const char *cur = *p;
+    long long vertex = 0;
+    while (*cur == ' ' || *cur == '\t')
+    {
+        cur++;
+    }
+    if (*cur < '0' || *cur > '9')
+    {
+        return -1;
+    }
+    for (; *cur >= '0' && *cur <= '9'; cur++)
+    {
+        vertex = vertex * 10 + (*cur - '0');
+        if (vertex >= numOfNodesInTree)
+        {
+            return -1;
+        }
+    }
+    *p = cur;
+    return (int) vertex;
+}
+
+int scanQueryWeight(const char **p, long long *weight)
+{
+    const char *cur = *p;
+    long long num = 0;
+    while (*cur == ' ' || *cur == '\t')
+    {
+        cur++;
+    }
+    int negative = (*cur == '-');
+    if (negative)
+    {
+        cur++;
+    }
+    if (*cur < '0' || *cur > '9')
+    {
+        return 0;
+    }
+    for (; *cur >= '0' && *cur <= '9'; cur++)
+    {
+        num = num * 10 + (*cur - '0');
+        if (num > (long long) INT32_MAX + negative)
+        {
+            return 0;
+        }
+    }
+    *weight = negative ? -num : num;
+    *p = cur;
+    return 1;
+}
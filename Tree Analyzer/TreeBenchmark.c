@@ -0,0 +1,379 @@
+/**
+* @file TreeBenchmark.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief a benchmark of the phases of the TreeAnalyzer on synthetic trees - a program of its own,
+* with its own main, linked with all the parts of the TreeAnalyzer but TreeAnalyzer.c
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : the path of the TreeGenerator program, the CSV file to append the results to, and
+* optionally the shapes and sizes of the trees, the number of threads, and the arity and seed
+* given to the generator
+* Process: for every shape and size, the generator writes a graph file into a temporary file, and
+* the phases of the TreeAnalyzer run on it one after the other - reading the file, validating the
+* tree, a BFS from the root, measuring the branches and the diameter, and finding the path between
+* the two ends of the diameter. the wall time of every phase is measured, and so is the peak of
+* the resident memory while it runs - the peak is reset through /proc/self/clear_refs before every
+* phase, and is the peak of the whole run where that isn't supported. the length of the path is
+* checked against the diameter, so a broken phase isn't mistaken for a fast one.
+* Output : a CSV line per phase - the shape, the number of vertices, the phase, the number of
+* threads, the seconds, the peak resident memory in MB, and the vertices per second. the header
+* is written when the file is empty, so the results of several runs can be kept in one file.
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define USAGE "Usage: TreeBenchmark <Generator Path> <CSV Path> [--shapes <Shape,...>] " \
+              "[--sizes <N,...>] [--threads <N>] [--arity <K>] [--seed <S>]\n"
+#define CSV_HEADER "shape,vertices,phase,threads,seconds,peak_mb,vertices_per_second\n"
+#define DEFAULT_SHAPES "path,star,kary,random,caterpillar"
+#define DEFAULT_SIZES "1000000"
+#define MAX_ARGUMENT_LENGTH 32
+#define MAX_VERTICES 1000000000L
+#define STATUS_LINE_LENGTH 256
+#define MAX_FILE_NAME_LENGTH 4096
+
+/**
+ * @brief what a run of the benchmark measures:
+ * generatorPath - the TreeGenerator program
+ * csv - the file the results are appended to
+ * numOfThreads - the number of threads the phases may use
+ * arity, seed - given to the generator
+ */
+typedef struct BenchmarkRun
+{
+    const char *generatorPath;
+    FILE *csv;
+    int numOfThreads;
+    long arity;
+    long seed;
+} BenchmarkRun;
+
+/**
+ * @brief runs all the phases on a tree of a shape and size, and records them
+ * @return - 1 for success, 0 if the tree couldn't be generated or a phase failed
+ */
+int benchmarkTree(const BenchmarkRun *run, const char *shape, long numOfVertices);
+
+/**
+ * @brief writes the graph file of a tree by running the generator
+ * @return - 1 for success, 0 on failure
+ */
+int generateTree(const BenchmarkRun *run, const char *shape, long numOfVertices,
+                 const char *fileName);
+
+/**
+ * @brief a BFS from a node, writing the distance and previousInPath columns of the tree - on
+ * several threads if the run has them, as the TreeAnalyzer does
+ * @param scratch - the state of a sequential BFS
+ */
+void runBfs(const BenchmarkRun *run, AllTree *mainTree, BfsScratch *scratch, int root);
+
+/**
+ * @brief starts measuring a phase
+ * @return - the current time, in nanoseconds
+ */
+long long startPhase(void);
+
+/**
+ * @brief records a phase that started at start, as a line of the CSV
+ */
+void recordPhase(const BenchmarkRun *run, const char *shape, long numOfVertices,
+                 const char *phase, long long start);
+
+/**
+ * @brief the current monotonic time, in nanoseconds
+ */
+long long nowNanoseconds(void);
+
+/**
+ * @brief the peak resident memory since it was last reset, in KB
+ */
+long peakMemoryKilobytes(void);
+
+/**
+ * @brief reads a positive number argument
+ * @return - the number, -1 if it isn't a positive number up to MAX_VERTICES
+ */
+long parsePositive(const char *arg);
+
+int main(int argc, char *argv[])
+{
+    BenchmarkRun run = {NULL, NULL, 1, 2, 1};
+    const char *shapes = DEFAULT_SHAPES;
+    const char *sizes = DEFAULT_SIZES;
+    int valid = (argc >= 3 && argc % 2 == 1);
+    for (int i = 3; i + 1 < argc && valid; i += 2)
+    {
+        long number = parsePositive(argv[i + 1]);
+        if (strcmp(argv[i], "--shapes") == 0)
+        {
+            shapes = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--sizes") == 0)
+        {
+            sizes = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && number > 0 && number <= 1024)
+        {
+            run.numOfThreads = (int) number;
+        }
+        else if (strcmp(argv[i], "--arity") == 0 && number > 0)
+        {
+            run.arity = number;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && number > 0)
+        {
+            run.seed = number;
+        }
+        else
+        {
+            valid = 0;
+        }
+    }
+    if (!valid)
+    {
+        fprintf(stderr, USAGE);
+        return EXIT_FAILURE;
+    }
+    run.generatorPath = argv[1];
+    run.csv = fopen(argv[2], "a");
+    if (run.csv == NULL)
+    {
+        fprintf(stderr, "the CSV file can't be opened\n");
+        return EXIT_FAILURE;
+    }
+    if (ftell(run.csv) == 0)
+    {
+        fprintf(run.csv, CSV_HEADER);
+    }
+
+    int failed = 0;
+    char *sizesCopy = (char *) checkedMalloc(strlen(sizes) + 1);
+    char *shapesCopy = (char *) checkedMalloc(strlen(shapes) + 1);
+    strcpy(sizesCopy, sizes);
+    char *sizesEnd = NULL;
+    for (char *size = strtok_r(sizesCopy, ",", &sizesEnd); size != NULL && !failed;
+         size = strtok_r(NULL, ",", &sizesEnd))
+    {
+        long numOfVertices = parsePositive(size);
+        if (numOfVertices <= 0)
+        {
+            fprintf(stderr, USAGE);
+            failed = 1;
+            break;
+        }
+        strcpy(shapesCopy, shapes); // strtok_r writes into the list
+        char *shapesEnd = NULL;
+        for (char *shape = strtok_r(shapesCopy, ",", &shapesEnd); shape != NULL && !failed;
+             shape = strtok_r(NULL, ",", &shapesEnd))
+        {
+            failed = !benchmarkTree(&run, shape, numOfVertices);
+        }
+    }
+    free(sizesCopy);
+    free(shapesCopy);
+    if (fclose(run.csv) != 0)
+    {
+        fprintf(stderr, "the CSV file can't be written\n");
+        failed = 1;
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int benchmarkTree(const BenchmarkRun *run, const char *shape, long numOfVertices)
+{
+    const char *directory = getenv("TMPDIR");
+    char fileName[MAX_FILE_NAME_LENGTH];
+    snprintf(fileName, sizeof(fileName), "%s/TreeBenchmarkXXXXXX",
+             (directory != NULL && directory[0] != '\0') ? directory : "/tmp");
+    int fd = mkstemp(fileName);
+    if (fd == -1)
+    {
+        fprintf(stderr, "a temporary file can't be created\n");
+        return 0;
+    }
+    close(fd);
+    if (generateTree(run, shape, numOfVertices, fileName) == 0)
+    {
+        unlink(fileName);
+        fprintf(stderr, "the generator failed on a %s of %ld vertices\n", shape, numOfVertices);
+        return 0;
+    }
+
+    ParseError error = {0, ""};
+    long long start = startPhase();
+    AllTree *mainTree = readGraphFile(fileName, run->numOfThreads, &error);
+    recordPhase(run, shape, numOfVertices, "parse", start);
+    unlink(fileName);
+    if (mainTree == NULL)
+    {
+        fprintf(stderr, "the generated %s can't be read: %s\n", shape, error.message);
+        return 0;
+    }
+    start = startPhase();
+    int valid = validateTree(mainTree, &error);
+    recordPhase(run, shape, numOfVertices, "validate", start);
+    if (!valid)
+    {
+        fprintf(stderr, "the generated %s isn't a tree: %s\n", shape, error.message);
+        freeTree(mainTree);
+        return 0;
+    }
+
+    int root = findRoot(mainTree);
+    BfsScratch *scratch = allocBfsScratch(mainTree->value);
+    for (int i = 0; i < mainTree->value; i++)
+    {
+        mainTree->distance[i] = -1;
+    }
+    start = startPhase();
+    runBfs(run, mainTree, scratch, root);
+    recordPhase(run, shape, numOfVertices, "bfs", start);
+    int numOfReached = 0;
+    for (int i = 0; i < mainTree->value; i++)
+    {
+        numOfReached += (mainTree->distance[i] >= 0);
+    }
+
+    TreeMetrics metrics;
+    start = startPhase();
+    analyzeTree(mainTree, root, &metrics);
+    recordPhase(run, shape, numOfVertices, "diameter", start);
+
+    start = startPhase();
+    runBfs(run, mainTree, scratch, metrics.diameterEnd);
+    int pathLength = 0;
+    for (int cur = metrics.diameterStart; cur != metrics.diameterEnd && pathLength < numOfVertices;
+         cur = mainTree->previousInPath[cur])
+    {
+        pathLength++;
+    }
+    recordPhase(run, shape, numOfVertices, "path", start);
+    freeBfsScratch(scratch);
+    freeTree(mainTree);
+    if (numOfReached != numOfVertices || pathLength != metrics.diameter)
+    {
+        fprintf(stderr, "the phases disagree on the generated %s\n", shape);
+        return 0;
+    }
+    return 1;
+}
+
+int generateTree(const BenchmarkRun *run, const char *shape, long numOfVertices,
+                 const char *fileName)
+{
+    char size[MAX_ARGUMENT_LENGTH];
+    char arity[MAX_ARGUMENT_LENGTH];
+    char seed[MAX_ARGUMENT_LENGTH];
+    snprintf(size, sizeof(size), "%ld", numOfVertices);
+    snprintf(arity, sizeof(arity), "%ld", run->arity);
+    snprintf(seed, sizeof(seed), "%ld", run->seed);
+    fflush(run->csv); // the child would write what is buffered again
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        return 0;
+    }
+    if (pid == 0)
+    {
+        execl(run->generatorPath, run->generatorPath, shape, size, "--arity", arity, "--seed",
+              seed, "--output", fileName, (char *) NULL);
+        _exit(EXIT_FAILURE);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) != pid)
+    {
+        return 0;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+void runBfs(const BenchmarkRun *run, AllTree *mainTree, BfsScratch *scratch, int root)
+{
+    if (run->numOfThreads > 1)
+    {
+        parallelBfs(mainTree, scratch, root, run->numOfThreads);
+    }
+    else
+    {
+        scratchBfs(mainTree, scratch, root, mainTree->distance, mainTree->previousInPath);
+    }
+}
+
+long long startPhase(void)
+{
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+    if (clearRefs != NULL)
+    {
+        fputs("5", clearRefs); // resets the peak resident memory to the current one
+        fclose(clearRefs);
+    }
+    return nowNanoseconds();
+}
+
+void recordPhase(const BenchmarkRun *run, const char *shape, long numOfVertices,
+                 const char *phase, long long start)
+{
+    double seconds = (double) (nowNanoseconds() - start) / 1e9;
+    double peakMegabytes = (double) peakMemoryKilobytes() / 1024;
+    double verticesPerSecond = (seconds > 0) ? (double) numOfVertices / seconds : 0;
+    fprintf(run->csv, "%s,%ld,%s,%d,%.6f,%.1f,%.0f\n", shape, numOfVertices, phase,
+            run->numOfThreads, seconds, peakMegabytes, verticesPerSecond);
+    printf("%-12s %11ld %-9s %10.3f s %9.1f MB %14.0f vertices/s\n", shape, numOfVertices, phase,
+           seconds, peakMegabytes, verticesPerSecond);
+}
+
+long long nowNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+long peakMemoryKilobytes(void)
+{
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status != NULL)
+    {
+        char line[STATUS_LINE_LENGTH];
+        long kilobytes = -1;
+        while (kilobytes == -1 && fgets(line, sizeof(line), status) != NULL)
+        {
+            if (sscanf(line, "VmHWM: %ld kB", &kilobytes) != 1)
+            {
+                kilobytes = -1;
+            }
+        }
+        fclose(status);
+        if (kilobytes != -1)
+        {
+            return kilobytes;
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+long parsePositive(const char *arg)
+{
+    char *end;
+    long number = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || number <= 0 || number > MAX_VERTICES)
+    {
+        return -1;
+    }
+    return number;
+}
@@ -0,0 +1,375 @@
+/**
+* @file TreeBfs.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief measuring the distance of all the nodes of a tree from one node, level by level on
+* several threads
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, the node to measure from and the number of threads
+* Process: a sequential BFS runs on a BfsScratch that is allocated once and reused - a plain array
+* of n nodes is the queue, and a node is reached if its stamp is the number of the current run, so
+* a run costs only the nodes it reaches.
+* a parallel BFS is done level by level - the nodes at distance d form the frontier of level d.
+* the frontier is split between the threads, and every thread writes the neighbours of its part
+* into a next frontier of its own. a prefix sum over the sizes of these gives every thread where to
+* copy its part into the next frontier. in a tree every node but the first has exactly one
+* neighbour a level closer - the one it is reached from - so every node is reached exactly once,
+* and its distance and previousInPath are written by a single thread without any atomics or
+* visited checks. small frontiers, such as most of the levels of a deep narrow tree, are expanded
+* by the calling thread alone. the frontiers live in the BfsScratch too - the queue is the first
+* one, and the second is allocated by the first parallel run and kept for the next ones.
+* the expansion of a level is defined once by a macro, and specialized for the columns of WideTree
+* as well, whose BFS runs it on a single thread.
+* the parallel BFS is experimental - its speedup over the sequential one hasn't been measured on a
+* machine with several cores yet, so the path is only measured with it when --threads is given.
+* Output : the distance and previousInPath of the nodes
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define MAX_BFS_THREADS 64
+#define MIN_PARALLEL_FRONTIER 8192
+#define INITIAL_LOCAL_CAPACITY 4096
+
+/**
+ * @brief the state shared by the threads of a parallel BFS:
+ * mainTree - the tree, its distance and previousInPath columns are written
+ * frontier, frontierSize - the nodes of the current level
+ * next, nextSize - the nodes of the next level
+ * numOfThreads - the number of threads, the calling thread included
+ * workers - all the threads
+ * done - set when there are no more levels, for the other threads to return
+ * barrier - where the threads meet between the steps of a level
+ */
+typedef struct BfsShared
+{
+    AllTree *mainTree;
+    const int32_t *frontier;
+    int frontierSize;
+    int32_t *next;
+    int nextSize;
+    int numOfThreads;
+    struct BfsWorker *workers;
+    int done;
+    pthread_barrier_t barrier;
+} BfsShared;
+
+/**
+ * @brief a thread of a parallel BFS:
+ * id - the index of the thread, 0 for the calling thread
+ * shared - the state shared by all the threads
+ * local, localSize, localCapacity - the part of the next frontier found by this thread
+ * offset - where the part of this thread starts in the next frontier
+ * numOfEdges - the edges scanned by this thread so far
+ */
+typedef struct BfsWorker
+{
+    int id;
+    BfsShared *shared;
+    int32_t *local;
+    int localSize;
+    int localCapacity;
+    int offset;
+    long long numOfEdges;
+} BfsWorker;
+
+/**
+ * @brief the routine of the threads other than the calling thread - runs levels until done
+ * @param arg - the BfsWorker
+ */
+void *bfsWorker(void *arg);
+
+/**
+ * @brief the part of a parallel level done by every thread: expands its part of the frontier,
+ * and after thread 0 computed the offsets, copies it into the next frontier.
+ */
+void runBfsLevel(BfsWorker *worker);
+
+/**
+ * @brief the number of neighbours of frontier[from..to) that are a level further
+ */
+long countNextLevel(const AllTree *mainTree, const int32_t *frontier, int from, int to);
+
+/**
+ * @brief defines expandFrontier for the ids and offsets of a given type
+ * @param name - the name of the expansion
+ * @param Id - the type of the ids and the offsets. (Id) -1 marks a missing father.
+ */
+#define DEFINE_EXPAND_FRONTIER(name, Id) \
+Id name(const Id *sonsOffsets, const Id *sons, const Id *father, Id *distance, \
+        Id *previousInPath, const Id *frontier, Id from, Id to, Id *out, long long *numOfEdges) \
+{ \
+    Id numOfOut = 0; \
+    for (Id i = from; i < to; i++) \
+    { \
+        Id cur = frontier[i]; \
+        Id cameFrom = previousInPath[cur]; \
+        Id nextDistance = (distance != NULL) ? distance[cur] + 1 : 0; \
+        for (Id j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++) \
+        { \
+            Id son = sons[j]; \
+            if (son != cameFrom) \
+            { \
+                if (distance != NULL) \
+                { \
+                    distance[son] = nextDistance; \
+                } \
+                previousInPath[son] = cur; \
+                out[numOfOut++] = son; \
+            } \
+        } \
+        Id fatherIndex = father[cur]; \
+        *numOfEdges += (long long) (sonsOffsets[cur + 1] - sonsOffsets[cur]) + \
+                       (fatherIndex != (Id) -1); \
+        if (fatherIndex != (Id) -1 && fatherIndex != cameFrom) \
+        { \
+            if (distance != NULL) \
+            { \
+                distance[fatherIndex] = nextDistance; \
+            } \
+            previousInPath[fatherIndex] = cur; \
+            out[numOfOut++] = fatherIndex; \
+        } \
+    } \
+    return numOfOut; \
+}
+
+DEFINE_EXPAND_FRONTIER(expandFrontier, int32_t)
+
+DEFINE_EXPAND_FRONTIER(expandFrontier32, uint32_t)
+
+DEFINE_EXPAND_FRONTIER(expandFrontier64, uint64_t)
+
+BfsScratch *allocBfsScratch(int numOfNodes)
+{
+    BfsScratch *scratch = (BfsScratch *) checkedMalloc(sizeof(BfsScratch));
+    scratch->numOfNodes = numOfNodes;
+    scratch->queue = (int32_t *) checkedMalloc(numOfNodes * sizeof(int32_t));
+    scratch->stamp = (uint32_t *) checkedMalloc(numOfNodes * sizeof(uint32_t));
+    memset(scratch->stamp, 0, numOfNodes * sizeof(uint32_t));
+    scratch->generation = 0;
+    scratch->nextFrontier = NULL;
+    return scratch;
+}
+
+int scratchBfs(const AllTree *mainTree, BfsScratch *scratch, int root, int32_t *distance,
+               int32_t *previousInPath)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    const int32_t *father = mainTree->father;
+    int32_t *queue = scratch->queue;
+    uint32_t *stamp = scratch->stamp;
+    if (++scratch->generation == 0) // the stamps wrapped around, so the old ones may match again
+    {
+        memset(stamp, 0, scratch->numOfNodes * sizeof(uint32_t));
+        scratch->generation = 1;
+    }
+    uint32_t generation = scratch->generation;
+    int head = 0;
+    int tail = 0;
+    long long numOfEdges = 0;
+    queue[tail++] = root;
+    stamp[root] = generation;
+    distance[root] = 0;
+    previousInPath[root] = -1;
+    while (head < tail)
+    {
+        int32_t cur = queue[head++];
+        int32_t nextDistance = distance[cur] + 1;
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            int32_t son = sons[j];
+            if (stamp[son] != generation)
+            {
+                stamp[son] = generation;
+                distance[son] = nextDistance;
+                previousInPath[son] = cur;
+                queue[tail++] = son;
+            }
+        }
+        int32_t fatherIndex = father[cur];
+        numOfEdges += sonsOffsets[cur + 1] - sonsOffsets[cur] + (fatherIndex != -1);
+        if (fatherIndex != -1 && stamp[fatherIndex] != generation)
+        {
+            stamp[fatherIndex] = generation;
+            distance[fatherIndex] = nextDistance;
+            previousInPath[fatherIndex] = cur;
+            queue[tail++] = fatherIndex;
+        }
+    }
+    countBfs(tail, numOfEdges);
+    return tail;
+}
+
+int bfsReached(const BfsScratch *scratch, int node)
+{
+    return scratch->stamp[node] == scratch->generation;
+}
+
+void freeBfsScratch(BfsScratch *scratch)
+{
+    free(scratch->queue);
+    free(scratch->stamp);
+    free(scratch->nextFrontier);
+    free(scratch);
+}
+
+void parallelBfs(AllTree *mainTree, BfsScratch *scratch, int root, int numOfThreads)
+{
+    if (scratch->nextFrontier == NULL)
+    {
+        scratch->nextFrontier = (int32_t *) checkedMalloc((size_t) scratch->numOfNodes *
+                                                          sizeof(int32_t));
+    }
+    int32_t *frontier = scratch->queue;
+    int32_t *next = scratch->nextFrontier;
+    if (numOfThreads > MAX_BFS_THREADS)
+    {
+        numOfThreads = MAX_BFS_THREADS;
+    }
+    if (numOfThreads < 1)
+    {
+        numOfThreads = 1;
+    }
+    BfsWorker workers[MAX_BFS_THREADS];
+    pthread_t threads[MAX_BFS_THREADS];
+    BfsShared shared;
+    shared.mainTree = mainTree;
+    shared.numOfThreads = numOfThreads;
+    shared.workers = workers;
+    shared.done = 0;
+    int threadsStarted = 0;
+
+    mainTree->distance[root] = 0;
+    mainTree->previousInPath[root] = -1;
+    frontier[0] = root;
+    int frontierSize = 1;
+    long long numOfReached = 0;
+    long long numOfEdges = 0;
+    while (frontierSize > 0)
+    {
+        numOfReached += frontierSize;
+        if (numOfThreads == 1 || frontierSize < MIN_PARALLEL_FRONTIER)
+        {
+            shared.nextSize = expandFrontier(mainTree->sonsOffsets, mainTree->sons,
+                                             mainTree->father, mainTree->distance,
+                                             mainTree->previousInPath, frontier, 0, frontierSize,
+                                             next, &numOfEdges);
+        }
+        else
+        {
+            if (!threadsStarted) // the threads are only started once a frontier is large enough
+            {
+                pthread_barrier_init(&shared.barrier, NULL, (unsigned int) numOfThreads);
+                for (int i = 0; i < numOfThreads; i++)
+                {
+                    workers[i].id = i;
+                    workers[i].shared = &shared;
+                    workers[i].localCapacity = INITIAL_LOCAL_CAPACITY;
+                    workers[i].numOfEdges = 0;
+                    workers[i].local = (int32_t *) checkedMalloc(INITIAL_LOCAL_CAPACITY *
+                                                                 sizeof(int32_t));
+                    if (i > 0 && pthread_create(&threads[i], NULL, bfsWorker, &workers[i]) != 0)
+                    {
+                        fprintf(stderr, "Thread creation failed\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                threadsStarted = 1;
+            }
+            shared.frontier = frontier;
+            shared.frontierSize = frontierSize;
+            shared.next = next;
+            pthread_barrier_wait(&shared.barrier); // start the level
+            runBfsLevel(&workers[0]);
+        }
+        int32_t *temp = frontier;
+        frontier = next;
+        next = temp;
+        frontierSize = shared.nextSize;
+    }
+
+    if (threadsStarted)
+    {
+        shared.done = 1;
+        pthread_barrier_wait(&shared.barrier);
+        for (int i = 0; i < numOfThreads; i++)
+        {
+            if (i > 0)
+            {
+                pthread_join(threads[i], NULL);
+            }
+            numOfEdges += workers[i].numOfEdges;
+            free(workers[i].local);
+        }
+        pthread_barrier_destroy(&shared.barrier);
+    }
+    countBfs(numOfReached, numOfEdges);
+}
+
+void *bfsWorker(void *arg)
+{
+    BfsWorker *worker = (BfsWorker *) arg;
+    while (1)
+    {
+        pthread_barrier_wait(&worker->shared->barrier);
+        if (worker->shared->done)
+        {
+            return NULL;
+        }
+        runBfsLevel(worker);
+    }
+}
+
+void runBfsLevel(BfsWorker *worker)
+{
+    BfsShared *shared = worker->shared;
+    int from = (int) ((long) shared->frontierSize * worker->id / shared->numOfThreads);
+    int to = (int) ((long) shared->frontierSize * (worker->id + 1) / shared->numOfThreads);
+    long required = countNextLevel(shared->mainTree, shared->frontier, from, to);
+    if (required > worker->localCapacity)
+    {
+        free(worker->local);
+        worker->localCapacity = (int) required;
+        worker->local = (int32_t *) checkedMalloc(required * sizeof(int32_t));
+    }
+    AllTree *mainTree = shared->mainTree;
+    worker->localSize = expandFrontier(mainTree->sonsOffsets, mainTree->sons, mainTree->father,
+                                       mainTree->distance, mainTree->previousInPath,
+                                       shared->frontier, from, to, worker->local,
+                                       &worker->numOfEdges);
+    pthread_barrier_wait(&shared->barrier);
+    if (worker->id == 0) // the prefix sum of the parts gives every thread its offset
+    {
+        int offset = 0;
+        for (int i = 0; i < shared->numOfThreads; i++)
+        {
+            shared->workers[i].offset = offset;
+            offset += shared->workers[i].localSize;
+        }
+        shared->nextSize = offset;
+    }
+    pthread_barrier_wait(&shared->barrier);
+    memcpy(shared->next + worker->offset, worker->local, worker->localSize * sizeof(int32_t));
+    pthread_barrier_wait(&shared->barrier);
+}
+
+long countNextLevel(const AllTree *mainTree, const int32_t *frontier, int from, int to)
+{
+    long count = 0;
+    for (int i = from; i < to; i++)
+    {
+        int32_t cur = frontier[i];
+        count += NUM_OF_SONS(mainTree, cur) + 1; // the sons and the father, less the one before
+    }
+    return count;
+}
@@ -0,0 +1,304 @@
+/**
+* @file TreeCache.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief saving a parsed tree in a binary snapshot next to its graph file, and loading it back
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph file, and the tree parsed out of it
+* Process: the snapshot is a header followed by the sonsOffsets, sons and father columns of the
+* tree exactly as they are kept in memory, each starting on a CACHE_ALIGNMENT boundary. the header
+* records the size and modification time of the graph file, so a snapshot of an older version of
+* the file is never used, along with a checksum of itself and a checksum of the columns. loading
+* maps the snapshot and points the columns of the tree into the mapping - nothing is parsed or
+* copied. the mapping is private, so writing to the columns never changes the snapshot. every
+* load makes one pass over the columns to check that each vertex they hold is in the tree, so
+* a damaged snapshot is never indexed out of bounds - the checksum is only for --verify-cache.
+* Output : the tree, as if it was parsed from the graph file
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_SUFFIX ".cache"
+#define CACHE_MAGIC "TRCACHE"
+#define CACHE_VERSION 1
+#define CACHE_BYTE_ORDER 0x01020304u
+#define CACHE_ALIGNMENT 64
+#define CHECKSUM_MULTIPLIER 0x9E3779B97F4A7C15ull
+
+/**
+ * @brief the first bytes of a snapshot:
+ * magic, version, byteOrder - identify a snapshot this program can read on this machine
+ * numOfNodes, numOfSons - the size of the tree
+ * sourceSize, sourceSeconds, sourceNanoseconds - the size and modification time of the graph file
+ * offsetsStart, sonsStart, fatherStart - where each column starts in the snapshot
+ * fileSize - the size of the whole snapshot
+ * dataChecksum - the checksum of the three columns
+ * headerChecksum - the checksum of all the fields above
+ */
+typedef struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    int64_t numOfNodes;
+    int64_t numOfSons;
+    int64_t sourceSize;
+    int64_t sourceSeconds;
+    int64_t sourceNanoseconds;
+    uint64_t offsetsStart;
+    uint64_t sonsStart;
+    uint64_t fatherStart;
+    uint64_t fileSize;
+    uint64_t dataChecksum;
+    uint64_t headerChecksum;
+} CacheHeader;
+
+/**
+ * @brief fills the size of the tree, the graph file stats and the layout fields of a header
+ */
+void fillCacheLayout(CacheHeader *header, int numOfNodes, const struct stat *sourceStat);
+
+/**
+ * @brief checks the header of a mapped snapshot against the graph file and the snapshot size
+ * @return - 1 if the snapshot can be used, 0 otherwise
+ */
+int checkCacheHeader(const CacheHeader *header, const struct stat *sourceStat, size_t fileSize);
+
+/**
+ * @brief checks that the columns of a mapped snapshot hold a tree of numOfNodes vertices: the
+ * offsets start at 0, never go down and end at numOfNodes - 1, every son is a vertex whose father
+ * is the vertex it is listed under, and every father is a vertex or -1.
+ * @return - 1 if the columns can be indexed, 0 otherwise
+ */
+int checkCacheColumns(const int32_t *sonsOffsets, const int32_t *sons, const int32_t *father,
+                      int numOfNodes);
+
+/**
+ * @brief the checksum of the three columns of a tree
+ */
+uint64_t columnsChecksum(const int32_t *sonsOffsets, const int32_t *sons, const int32_t *father,
+                         int numOfNodes);
+
+AllTree *loadTreeCache(const char *fileName, int verify)
+{
+    struct stat sourceStat;
+    struct stat cacheStat;
+    if (stat(fileName, &sourceStat) != 0)
+    {
+        return NULL;
+    }
+    char *cachePath = cachePathOf(fileName, CACHE_SUFFIX);
+    int fd = open(cachePath, O_RDONLY);
+    free(cachePath);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(fd, &cacheStat) != 0 || cacheStat.st_size < (off_t) sizeof(CacheHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    size_t fileSize = (size_t) cacheStat.st_size;
+    void *data = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return NULL;
+    }
+    const CacheHeader *header = (const CacheHeader *) data;
+    char *base = (char *) data;
+    int numOfNodes = (int) header->numOfNodes;
+    int32_t *sonsOffsets = (int32_t *) (base + header->offsetsStart);
+    int32_t *sons = (int32_t *) (base + header->sonsStart);
+    int32_t *father = (int32_t *) (base + header->fatherStart);
+    if (checkCacheHeader(header, &sourceStat, fileSize) == 0 ||
+        checkCacheColumns(sonsOffsets, sons, father, numOfNodes) == 0 ||
+        (verify && columnsChecksum(sonsOffsets, sons, father, numOfNodes) != header->dataChecksum))
+    {
+        munmap(data, fileSize);
+        return NULL;
+    }
+
+    AllTree *mainTree = (AllTree *) checkedMalloc(sizeof(AllTree));
+    mainTree->value = numOfNodes;
+    mainTree->sonsOffsets = sonsOffsets;
+    mainTree->sons = sons;
+    mainTree->father = father;
+    mainTree->cache.data = (const char *) data;
+    mainTree->cache.size = fileSize;
+    mainTree->originalLabel = NULL;
+    mainTree->internalLabel = NULL;
+    mainTree->distance = (int32_t *) checkedMalloc(numOfNodes * sizeof(int32_t));
+    mainTree->previousInPath = (int32_t *) checkedMalloc(numOfNodes * sizeof(int32_t));
+    for (int i = 0; i < numOfNodes; i++)
+    {
+        mainTree->previousInPath[i] = -1;
+    }
+    return mainTree;
+}
+
+int writeTreeCache(const char *fileName, const AllTree *mainTree)
+{
+    struct stat sourceStat;
+    CacheHeader header;
+    if (stat(fileName, &sourceStat) != 0)
+    {
+        return 0;
+    }
+    fillCacheLayout(&header, mainTree->value, &sourceStat);
+    header.dataChecksum = columnsChecksum(mainTree->sonsOffsets, mainTree->sons, mainTree->father,
+                                          mainTree->value);
+    header.headerChecksum = checksumBytes(0, &header, offsetof(CacheHeader, headerChecksum));
+
+    char *cachePath = cachePathOf(fileName, CACHE_SUFFIX);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), CACHE_SUFFIX ".%ld.tmp", (long) getpid());
+    char *tempPath = cachePathOf(fileName, suffix);
+    FILE *file = fopen(tempPath, "wb");
+    int written = file != NULL &&
+                  writeAlignedColumn(file, &header, sizeof(header)) &&
+                  writeAlignedColumn(file, mainTree->sonsOffsets,
+                                     ((size_t) mainTree->value + 1) * sizeof(int32_t)) &&
+                  writeAlignedColumn(file, mainTree->sons, header.numOfSons * sizeof(int32_t)) &&
+                  writeAlignedColumn(file, mainTree->father, mainTree->value * sizeof(int32_t));
+    if (file != NULL && fclose(file) != 0)
+    {
+        written = 0;
+    }
+    if (written && rename(tempPath, cachePath) != 0)
+    {
+        written = 0;
+    }
+    if (!written && file != NULL)
+    {
+        unlink(tempPath);
+    }
+    free(cachePath);
+    free(tempPath);
+    return written;
+}
+
+void fillCacheLayout(CacheHeader *header, int numOfNodes, const struct stat *sourceStat)
+{
+    memset(header, 0, sizeof(CacheHeader));
+    memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+    header->version = CACHE_VERSION;
+    header->byteOrder = CACHE_BYTE_ORDER;
+    header->numOfNodes = numOfNodes;
+    header->numOfSons = numOfNodes - 1;
+    header->sourceSize = (int64_t) sourceStat->st_size;
+    header->sourceSeconds = (int64_t) sourceStat->st_mtim.tv_sec;
+    header->sourceNanoseconds = (int64_t) sourceStat->st_mtim.tv_nsec;
+    uint64_t position = sizeof(CacheHeader);
+    position = (position + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    header->offsetsStart = position;
+    position += ((uint64_t) numOfNodes + 1) * sizeof(int32_t);
+    position = (position + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    header->sonsStart = position;
+    position += (uint64_t) header->numOfSons * sizeof(int32_t);
+    position = (position + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    header->fatherStart = position;
+    position += (uint64_t) numOfNodes * sizeof(int32_t);
+    header->fileSize = (position + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+int checkCacheHeader(const CacheHeader *header, const struct stat *sourceStat, size_t fileSize)
+{
+    CacheHeader expected;
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CACHE_VERSION || header->byteOrder != CACHE_BYTE_ORDER ||
+        header->headerChecksum != checksumBytes(0, header, offsetof(CacheHeader, headerChecksum)) ||
+        header->numOfNodes <= 0 || header->numOfNodes > INT_MAX)
+    {
+        return 0;
+    }
+    fillCacheLayout(&expected, (int) header->numOfNodes, sourceStat);
+    return header->numOfSons == expected.numOfSons &&
+           header->sourceSize == expected.sourceSize &&
+           header->sourceSeconds == expected.sourceSeconds &&
+           header->sourceNanoseconds == expected.sourceNanoseconds &&
+           header->offsetsStart == expected.offsetsStart &&
+           header->sonsStart == expected.sonsStart &&
+           header->fatherStart == expected.fatherStart &&
+           header->fileSize == expected.fileSize && header->fileSize == fileSize;
+}
+
+int checkCacheColumns(const int32_t *sonsOffsets, const int32_t *sons, const int32_t *father,
+                      int numOfNodes)
+{
+    if (sonsOffsets[0] != 0 || sonsOffsets[numOfNodes] != numOfNodes - 1)
+    {
+        return 0;
+    }
+    for (int i = 0; i < numOfNodes; i++)
+    {
+        if (sonsOffsets[i + 1] < sonsOffsets[i] || father[i] < -1 || father[i] >= numOfNodes)
+        {
+            return 0;
+        }
+        for (int j = sonsOffsets[i]; j < sonsOffsets[i + 1]; j++)
+        {
+            if (sons[j] < 0 || sons[j] >= numOfNodes || father[sons[j]] != i)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+uint64_t columnsChecksum(const int32_t *sonsOffsets, const int32_t *sons, const int32_t *father,
+                         int numOfNodes)
+{
+    uint64_t checksum = checksumBytes(0, sonsOffsets, ((size_t) numOfNodes + 1) * sizeof(int32_t));
+    checksum = checksumBytes(checksum, sons, (numOfNodes - 1) * sizeof(int32_t));
+    return checksumBytes(checksum, father, numOfNodes * sizeof(int32_t));
+}
+
+uint64_t checksumBytes(uint64_t checksum, const void *data, size_t length)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        checksum = (checksum ^ word) * CHECKSUM_MULTIPLIER;
+        checksum ^= checksum >> 32;
+    }
+    for (; i < length; i++)
+    {
+        checksum = (checksum ^ bytes[i]) * CHECKSUM_MULTIPLIER;
+        checksum ^= checksum >> 32;
+    }
+    return checksum;
+}
+
+int writeAlignedColumn(FILE *file, const void *data, size_t length)
+{
+    static const char zeros[CACHE_ALIGNMENT] = {0};
+    size_t padding = (CACHE_ALIGNMENT - length % CACHE_ALIGNMENT) % CACHE_ALIGNMENT;
+    return fwrite(data, 1, length, file) == length && fwrite(zeros, 1, padding, file) == padding;
+}
+
+char *cachePathOf(const char *fileName, const char *suffix)
+{
+    size_t length = strlen(fileName);
+    char *path = (char *) checkedMalloc(length + strlen(suffix) + 1);
+    memcpy(path, fileName, length);
+    strcpy(path + length, suffix);
+    return path;
+}
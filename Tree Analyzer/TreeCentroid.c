@@ -0,0 +1,831 @@
+/**
+* @file TreeCentroid.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief centroid decomposition of a tree - counting the pairs of nodes at every distance, and the
+* nodes within a distance of a node
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, and the number of threads to decompose it on
+* Process: the centroid of a component is a node whose removal leaves parts of at most half of
+* the component. the tree is decomposed by taking the centroid of the whole tree, and then of
+* every part left, and so on - so every node is in O(log n) components. the parts are independent,
+* so they are taken from a shared stack by a pool of threads. every part is copied into a compact
+* graph of its own, numbered in BFS order, so a thread only touches the memory of its part and
+* the parts left waiting take O(n) memory together.
+* for every centroid c the number of nodes of its component within every distance of c is kept,
+* and for every part it leaves the number of nodes of the part within every distance of c. a query
+* climbs the centroids above a node and adds the nodes within the distance left through every
+* centroid, less those already counted through the part the node is in.
+* the pairs of a component whose path passes through its centroid are counted by squaring the
+* polynomial of the number of nodes at every distance from the centroid, less the squares of its
+* parts - each squared by a number theoretic transform modulo one or two primes, joined by the
+* chinese remainder theorem, so the counts are exact.
+* Output : a CentroidIndex to query, and the distance histogram if asked for
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define MAX_CENTROID_THREADS 64
+#define NAIVE_SQUARE_LENGTH 64
+#define FIRST_PRIME 167772161u
+#define SECOND_PRIME 469762049u
+#define PRIMITIVE_ROOT 3u
+#define NUM_OF_SCRATCH_COLUMNS 8
+
+/**
+ * @brief a component left to decompose, as a graph of its own. the local number of a node is
+ * its place in a BFS over the component from local node 0:
+ * size - the number of nodes in the component
+ * globalId - the node in the tree of every local node
+ * bfsParent - the local node every local node is reached from in that BFS, -1 for node 0
+ * adjacencyOffsets, adjacency - the neighbours of every local node in the component, in the
+ * layout of the sons of AllTree
+ * parentCentroid - the centroid whose removal left the component, -1 for the whole tree
+ * parentWithin, parentWithinLength - the number of nodes of the component within every distance
+ * of parentCentroid, for the centroid of the component to keep. NULL for the whole tree.
+ */
+typedef struct CentroidTask
+{
+    int32_t size;
+    int32_t *globalId;
+    int32_t *bfsParent;
+    int32_t *adjacencyOffsets;
+    int32_t *adjacency;
+    int32_t parentCentroid;
+    int32_t *parentWithin;
+    int32_t parentWithinLength;
+} CentroidTask;
+
+/**
+ * @brief the state shared by the threads decomposing a tree:
+ * index - the index being built. every centroid is written by a single thread.
+ * tasks, numOfTasks, tasksCapacity - the stack of the components left
+ * numOfBusy - the number of threads decomposing a component, that may add more
+ * withHistogram - 1 if the pairs at every distance are counted
+ */
+typedef struct CentroidShared
+{
+    CentroidIndex *index;
+    CentroidTask *tasks;
+    long numOfTasks;
+    long tasksCapacity;
+    int numOfBusy;
+    int withHistogram;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} CentroidShared;
+
+/**
+ * @brief a thread decomposing a tree:
+ * shared - the state shared by all the threads
+ * scratch, scratchCapacity - NUM_OF_SCRATCH_COLUMNS columns of scratchCapacity local nodes each
+ * counts, countsCapacity - room for the number of nodes at every distance
+ * histogram, histogramLength - the ordered pairs counted by this thread at every distance
+ */
+typedef struct CentroidWorker
+{
+    CentroidShared *shared;
+    int32_t *scratch;
+    long scratchCapacity;
+    long long *counts;
+    long countsCapacity;
+    long long *histogram;
+    long histogramLength;
+} CentroidWorker;
+
+/**
+ * @brief a prime for Montgomery multiplication, where x is kept as x * 2^32 modulo the prime:
+ * prime - the prime, below 2^30
+ * negativeInverse - minus the inverse of the prime modulo 2^32
+ * rSquared - 2^64 modulo the prime
+ */
+typedef struct Modulus
+{
+    uint32_t prime;
+    uint32_t negativeInverse;
+    uint32_t rSquared;
+} Modulus;
+
+/**
+ * @brief the routine of the threads - decomposes components until none are left
+ * @param arg - the CentroidWorker
+ */
+void *centroidWorker(void *arg);
+
+/**
+ * @brief takes the centroid of a component, records its counts, and adds the parts it leaves
+ * as new tasks. frees the component.
+ */
+void decomposeComponent(CentroidWorker *worker, CentroidTask *task);
+
+/**
+ * @brief finds a centroid of a component, from the sizes of the subtrees of its BFS
+ * @return - the local centroid
+ */
+int32_t findCentroid(const CentroidTask *task, int32_t *subtreeSize, int32_t *largestPart);
+
+/**
+ * @brief copies a part left by the centroid into a task of its own
+ * @param nodes - the local nodes of the part, in BFS order from the centroid
+ * @param from - the node every node was reached from in the BFS from the centroid
+ * @param newId - the local number of every node in the part
+ */
+void extractPart(const CentroidTask *task, int32_t centroid, const int32_t *nodes, int32_t size,
+                 const int32_t *from, const int32_t *newId, CentroidTask *part);
+
+/**
+ * @brief the task of the whole tree, numbered in BFS order from the root
+ */
+void initTreeTask(const AllTree *mainTree, int root, CentroidTask *task);
+
+/**
+ * @brief adds a task to the shared stack. the caller holds the lock.
+ */
+void pushTask(CentroidShared *shared, const CentroidTask *task);
+
+/**
+ * @brief the number of nodes within every distance, in the heap
+ * @param counts - the number of nodes at every distance, 0..maxDistance
+ */
+int32_t *cumulativeCounts(const long long *counts, long maxDistance);
+
+/**
+ * @brief adds, or subtracts, the square of the polynomial of counts to the worker histogram
+ * @param sign - 1 to add, -1 to subtract
+ */
+void addSquare(CentroidWorker *worker, const long long *counts, long maxDistance, int sign);
+
+/**
+ * @brief squares a polynomial with exact coefficients
+ * @param total - the sum of the coefficients, which bounds those of the square
+ * @param squared - out: the 2 * length - 1 coefficients of the square
+ */
+void squarePolynomial(const long long *polynomial, long length, long long total,
+                      long long *squared);
+
+/**
+ * @brief squares a polynomial modulo a prime with a number theoretic transform
+ * @param values - the coefficients, replaced by those of the square. has room for size of them,
+ * a power of 2 at least twice the length of the polynomial.
+ */
+void squareModulo(uint32_t *values, long size, const Modulus *modulus);
+
+/**
+ * @brief a number theoretic transform in place, of values in Montgomery form
+ * @param twiddles - the powers of the root of unity of order size, in Montgomery form
+ */
+void transform(uint32_t *values, long size, const Modulus *modulus, const uint32_t *twiddles);
+
+void initModulus(Modulus *modulus, uint32_t prime);
+
+/**
+ * @brief x / 2^32 modulo the prime, for x below prime * 2^32
+ */
+uint32_t montgomeryReduce(const Modulus *modulus, uint64_t x);
+
+/**
+ * @brief the product of two numbers in Montgomery form
+ */
+uint32_t montgomeryMultiply(const Modulus *modulus, uint32_t first, uint32_t second);
+
+/**
+ * @brief base to the power of exponent, modulo a prime
+ */
+uint64_t powerModulo(uint64_t base, uint64_t exponent, uint64_t prime);
+
+/**
+ * @brief the number of counted nodes within a distance, from an array made by cumulativeCounts
+ */
+long long countWithin(const int32_t *within, int32_t length, long distance);
+
+/**
+ * @brief makes room in a buffer, which keeps its content
+ */
+void *growBuffer(void *buffer, long *capacity, long required, size_t elementSize);
+
+/********************************************************************************
+*********************************************************************************
+*************             Decomposing the Tree           ************************
+*********************************************************************************
+********************************************************************************/
+
+CentroidIndex *buildCentroidIndex(const AllTree *mainTree, int root, int numOfThreads,
+                                  int withHistogram)
+{
+    int n = mainTree->value;
+    CentroidIndex *index = (CentroidIndex *) checkedMalloc(sizeof(CentroidIndex));
+    index->numOfNodes = n;
+    index->centroidParent = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->within = (int32_t **) checkedMalloc(n * sizeof(int32_t *));
+    index->withinLength = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->parentWithin = (int32_t **) checkedMalloc(n * sizeof(int32_t *));
+    index->parentWithinLength = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->lca = buildLcaIndex(mainTree, root);
+    index->histogram = NULL;
+    index->histogramLength = 0;
+
+    CentroidShared shared;
+    shared.index = index;
+    shared.tasksCapacity = 0;
+    shared.tasks = NULL;
+    shared.numOfTasks = 0;
+    shared.numOfBusy = 0;
+    shared.withHistogram = withHistogram;
+    pthread_mutex_init(&shared.lock, NULL);
+    pthread_cond_init(&shared.changed, NULL);
+    CentroidTask treeTask;
+    initTreeTask(mainTree, root, &treeTask);
+    pushTask(&shared, &treeTask);
+
+    if (numOfThreads > MAX_CENTROID_THREADS)
+    {
+        numOfThreads = MAX_CENTROID_THREADS;
+    }
+    if (numOfThreads < 1)
+    {
+        numOfThreads = 1;
+    }
+    CentroidWorker workers[MAX_CENTROID_THREADS];
+    pthread_t threads[MAX_CENTROID_THREADS];
+    for (int i = 0; i < numOfThreads; i++)
+    {
+        memset(&workers[i], 0, sizeof(CentroidWorker));
+        workers[i].shared = &shared;
+        if (i > 0 && pthread_create(&threads[i], NULL, centroidWorker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "Thread creation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    centroidWorker(&workers[0]);
+
+    long histogramLength = 1;
+    for (int i = 0; i < numOfThreads; i++)
+    {
+        if (i > 0)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        if (workers[i].histogramLength > histogramLength)
+        {
+            histogramLength = workers[i].histogramLength;
+        }
+    }
+    if (withHistogram)
+    {
+        index->histogram = (long long *) checkedMalloc(histogramLength * sizeof(long long));
+        memset(index->histogram, 0, histogramLength * sizeof(long long));
+        for (int i = 0; i < numOfThreads; i++)
+        {
+            for (long k = 0; k < workers[i].histogramLength; k++)
+            {
+                index->histogram[k] += workers[i].histogram[k];
+            }
+        }
+        for (long k = 0; k < histogramLength; k++) // every pair was counted both ways
+        {
+            index->histogram[k] /= 2;
+        }
+        index->histogram[0] = 0;
+        while (histogramLength > 1 && index->histogram[histogramLength - 1] == 0)
+        {
+            histogramLength--;
+        }
+        index->histogramLength = histogramLength;
+    }
+    for (int i = 0; i < numOfThreads; i++)
+    {
+        free(workers[i].scratch);
+        free(workers[i].counts);
+        free(workers[i].histogram);
+    }
+    pthread_mutex_destroy(&shared.lock);
+    pthread_cond_destroy(&shared.changed);
+    free(shared.tasks);
+    return index;
+}
+
+void *centroidWorker(void *arg)
+{
+    CentroidWorker *worker = (CentroidWorker *) arg;
+    CentroidShared *shared = worker->shared;
+    pthread_mutex_lock(&shared->lock);
+    while (1)
+    {
+        while (shared->numOfTasks == 0 && shared->numOfBusy > 0)
+        {
+            pthread_cond_wait(&shared->changed, &shared->lock);
+        }
+        if (shared->numOfTasks == 0) // nothing left, and no one to add more
+        {
+            pthread_cond_broadcast(&shared->changed);
+            break;
+        }
+        CentroidTask task = shared->tasks[--shared->numOfTasks];
+        shared->numOfBusy++;
+        pthread_mutex_unlock(&shared->lock);
+        decomposeComponent(worker, &task);
+        pthread_mutex_lock(&shared->lock);
+        shared->numOfBusy--;
+        pthread_cond_broadcast(&shared->changed);
+    }
+    pthread_mutex_unlock(&shared->lock);
+    return NULL;
+}
+
+void decomposeComponent(CentroidWorker *worker, CentroidTask *task)
+{
+    CentroidShared *shared = worker->shared;
+    CentroidIndex *index = shared->index;
+    int32_t size = task->size;
+    worker->scratch = (int32_t *) growBuffer(worker->scratch, &worker->scratchCapacity,
+                                             NUM_OF_SCRATCH_COLUMNS * ((long) size + 1),
+                                             sizeof(int32_t));
+    long columnLength = worker->scratchCapacity / NUM_OF_SCRATCH_COLUMNS;
+    int32_t *subtreeSize = worker->scratch;
+    int32_t *from = worker->scratch + columnLength; // the largest part, until the BFS
+    int32_t *order = worker->scratch + 2 * columnLength;
+    int32_t *distance = worker->scratch + 3 * columnLength;
+    int32_t *branch = worker->scratch + 4 * columnLength;
+    int32_t *grouped = worker->scratch + 5 * columnLength;
+    int32_t *newId = worker->scratch + 6 * columnLength;
+    int32_t *branchEnd = worker->scratch + 7 * columnLength;
+
+    int32_t centroid = findCentroid(task, subtreeSize, from);
+    int32_t globalCentroid = task->globalId[centroid];
+    index->centroidParent[globalCentroid] = task->parentCentroid;
+    index->parentWithin[globalCentroid] = task->parentWithin;
+    index->parentWithinLength[globalCentroid] = task->parentWithinLength;
+
+    // a BFS from the centroid, marking every node with the part it is in
+    int numOfParts = 0;
+    int numOfOrdered = 1;
+    order[0] = centroid;
+    from[centroid] = -1;
+    distance[centroid] = 0;
+    for (int i = 0; i < numOfOrdered; i++)
+    {
+        int32_t cur = order[i];
+        for (int32_t j = task->adjacencyOffsets[cur]; j < task->adjacencyOffsets[cur + 1]; j++)
+        {
+            int32_t next = task->adjacency[j];
+            if (next != from[cur])
+            {
+                from[next] = cur;
+                distance[next] = distance[cur] + 1;
+                branch[next] = (cur == centroid) ? numOfParts++ : branch[cur];
+                order[numOfOrdered++] = next;
+            }
+        }
+    }
+    long maxDistance = distance[order[size - 1]];
+    worker->counts = (long long *) growBuffer(worker->counts, &worker->countsCapacity,
+                                              maxDistance + 1, sizeof(long long));
+    memset(worker->counts, 0, (maxDistance + 1) * sizeof(long long));
+    for (int i = 0; i < size; i++)
+    {
+        worker->counts[distance[i]]++;
+    }
+    index->within[globalCentroid] = cumulativeCounts(worker->counts, maxDistance);
+    index->withinLength[globalCentroid] = (int32_t) maxDistance + 1;
+    if (shared->withHistogram)
+    {
+        addSquare(worker, worker->counts, maxDistance, 1);
+    }
+
+    // group the nodes by part, keeping the BFS order - which is a BFS order from the part's root
+    int32_t *partStart = subtreeSize;
+    memset(partStart, 0, (numOfParts + 1) * sizeof(int32_t));
+    for (int i = 1; i < size; i++)
+    {
+        partStart[branch[order[i]] + 1]++;
+    }
+    for (int p = 0; p < numOfParts; p++)
+    {
+        partStart[p + 1] += partStart[p];
+        branchEnd[p] = partStart[p];
+    }
+    for (int i = 1; i < size; i++)
+    {
+        int32_t cur = order[i];
+        int32_t p = branch[cur];
+        newId[cur] = branchEnd[p] - partStart[p];
+        grouped[branchEnd[p]++] = cur;
+    }
+
+    CentroidTask *parts = (CentroidTask *) checkedMalloc(numOfParts * sizeof(CentroidTask));
+    for (int p = 0; p < numOfParts; p++)
+    {
+        const int32_t *nodes = grouped + partStart[p];
+        int32_t partSize = partStart[p + 1] - partStart[p];
+        extractPart(task, centroid, nodes, partSize, from, newId, &parts[p]);
+        parts[p].parentCentroid = globalCentroid;
+        long partDistance = distance[nodes[partSize - 1]];
+        memset(worker->counts, 0, (partDistance + 1) * sizeof(long long));
+        for (int i = 0; i < partSize; i++)
+        {
+            worker->counts[distance[nodes[i]]]++;
+        }
+        parts[p].parentWithin = cumulativeCounts(worker->counts, partDistance);
+        parts[p].parentWithinLength = (int32_t) partDistance + 1;
+        if (shared->withHistogram)
+        {
+            addSquare(worker, worker->counts, partDistance, -1);
+        }
+    }
+    free(task->globalId);
+    free(task->bfsParent);
+    free(task->adjacencyOffsets);
+    free(task->adjacency);
+
+    pthread_mutex_lock(&shared->lock);
+    for (int p = 0; p < numOfParts; p++)
+    {
+        pushTask(shared, &parts[p]);
+    }
+    pthread_cond_broadcast(&shared->changed);
+    pthread_mutex_unlock(&shared->lock);
+    free(parts);
+}
+
+int32_t findCentroid(const CentroidTask *task, int32_t *subtreeSize, int32_t *largestPart)
+{
+    int32_t size = task->size;
+    for (int32_t i = 0; i < size; i++)
+    {
+        subtreeSize[i] = 1;
+        largestPart[i] = 0;
+    }
+    for (int32_t i = size - 1; i > 0; i--) // every node comes after its BFS parent
+    {
+        int32_t parent = task->bfsParent[i];
+        subtreeSize[parent] += subtreeSize[i];
+        if (subtreeSize[i] > largestPart[parent])
+        {
+            largestPart[parent] = subtreeSize[i];
+        }
+    }
+    for (int32_t i = 0; i < size; i++)
+    {
+        int32_t above = size - subtreeSize[i];
+        if (largestPart[i] <= size / 2 && above <= size / 2)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void extractPart(const CentroidTask *task, int32_t centroid, const int32_t *nodes, int32_t size,
+                 const int32_t *from, const int32_t *newId, CentroidTask *part)
+{
+    part->size = size;
+    part->globalId = (int32_t *) checkedMalloc(size * sizeof(int32_t));
+    part->bfsParent = (int32_t *) checkedMalloc(size * sizeof(int32_t));
+    part->adjacencyOffsets = (int32_t *) checkedMalloc((size + 1) * sizeof(int32_t));
+    part->adjacency = (int32_t *) checkedMalloc((2 * (long) size - 1) * sizeof(int32_t));
+    int32_t numOfEdges = 0;
+    for (int32_t k = 0; k < size; k++)
+    {
+        int32_t cur = nodes[k];
+        part->globalId[k] = task->globalId[cur];
+        part->bfsParent[k] = (k == 0) ? -1 : newId[from[cur]];
+        part->adjacencyOffsets[k] = numOfEdges;
+        for (int32_t j = task->adjacencyOffsets[cur]; j < task->adjacencyOffsets[cur + 1]; j++)
+        {
+            if (task->adjacency[j] != centroid)
+            {
+                part->adjacency[numOfEdges++] = newId[task->adjacency[j]];
+            }
+        }
+    }
+    part->adjacencyOffsets[size] = numOfEdges;
+}
+
+void initTreeTask(const AllTree *mainTree, int root, CentroidTask *task)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int n = mainTree->value;
+    int32_t *localId = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    task->size = n;
+    task->globalId = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    task->bfsParent = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    task->adjacencyOffsets = (int32_t *) checkedMalloc(((size_t) n + 1) * sizeof(int32_t));
+    task->adjacency = (int32_t *) checkedMalloc((2 * (long) n - 1) * sizeof(int32_t));
+    task->parentCentroid = -1;
+    task->parentWithin = NULL;
+    task->parentWithinLength = 0;
+
+    int numOfOrdered = 1;
+    task->globalId[0] = root;
+    task->bfsParent[0] = -1;
+    localId[root] = 0;
+    int32_t numOfEdges = 0;
+    for (int i = 0; i < numOfOrdered; i++)
+    {
+        int32_t cur = task->globalId[i];
+        task->adjacencyOffsets[i] = numOfEdges;
+        if (i > 0)
+        {
+            task->adjacency[numOfEdges++] = task->bfsParent[i];
+        }
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            localId[sons[j]] = numOfOrdered;
+            task->globalId[numOfOrdered] = sons[j];
+            task->bfsParent[numOfOrdered] = i;
+            task->adjacency[numOfEdges++] = numOfOrdered++;
+        }
+    }
+    task->adjacencyOffsets[n] = numOfEdges;
+    free(localId);
+}
+
+void pushTask(CentroidShared *shared, const CentroidTask *task)
+{
+    shared->tasks = (CentroidTask *) growBuffer(shared->tasks, &shared->tasksCapacity,
+                                                shared->numOfTasks + 1, sizeof(CentroidTask));
+    shared->tasks[shared->numOfTasks++] = *task;
+}
+
+int32_t *cumulativeCounts(const long long *counts, long maxDistance)
+{
+    int32_t *within = (int32_t *) checkedMalloc((maxDistance + 1) * sizeof(int32_t));
+    long long total = 0;
+    for (long k = 0; k <= maxDistance; k++)
+    {
+        total += counts[k];
+        within[k] = (int32_t) total;
+    }
+    return within;
+}
+
+void *growBuffer(void *buffer, long *capacity, long required, size_t elementSize)
+{
+    if (required <= *capacity)
+    {
+        return buffer;
+    }
+    long newCapacity = (*capacity > 0) ? *capacity : 1;
+    while (newCapacity < required)
+    {
+        newCapacity *= 2;
+    }
+    *capacity = newCapacity;
+    return checkedRealloc(buffer, newCapacity * elementSize);
+}
+
+/********************************************************************************
+*********************************************************************************
+*************           Counting the Pairs               ************************
+*********************************************************************************
+********************************************************************************/
+
+void addSquare(CentroidWorker *worker, const long long *counts, long maxDistance, int sign)
+{
+    long squareLength = 2 * maxDistance + 1;
+    if (squareLength > worker->histogramLength)
+    {
+        long oldLength = worker->histogramLength;
+        worker->histogram = (long long *) growBuffer(worker->histogram, &worker->histogramLength,
+                                                     squareLength, sizeof(long long));
+        memset(worker->histogram + oldLength, 0,
+               (worker->histogramLength - oldLength) * sizeof(long long));
+    }
+    long long total = 0;
+    for (long k = 0; k <= maxDistance; k++)
+    {
+        total += counts[k];
+    }
+    long long *squared = (long long *) checkedMalloc(squareLength * sizeof(long long));
+    squarePolynomial(counts, maxDistance + 1, total, squared);
+    for (long k = 0; k < squareLength; k++)
+    {
+        worker->histogram[k] += sign * squared[k];
+    }
+    free(squared);
+}
+
+void squarePolynomial(const long long *polynomial, long length, long long total,
+                      long long *squared)
+{
+    long squareLength = 2 * length - 1;
+    if (length <= NAIVE_SQUARE_LENGTH)
+    {
+        memset(squared, 0, squareLength * sizeof(long long));
+        for (long i = 0; i < length; i++)
+        {
+            for (long j = 0; j < length; j++)
+            {
+                squared[i + j] += polynomial[i] * polynomial[j];
+            }
+        }
+        return;
+    }
+    long size = 1;
+    while (size < squareLength)
+    {
+        size *= 2;
+    }
+    // a single prime is enough when no coefficient of the square can reach it
+    int numOfPrimes = (total * total < (long long) SECOND_PRIME) ? 1 : 2;
+    uint32_t primes[2] = {SECOND_PRIME, FIRST_PRIME};
+    uint32_t *values[2] = {NULL, NULL};
+    Modulus moduli[2];
+    for (int m = 0; m < numOfPrimes; m++)
+    {
+        initModulus(&moduli[m], primes[m]);
+        values[m] = (uint32_t *) checkedMalloc(size * sizeof(uint32_t));
+        for (long i = 0; i < size; i++)
+        {
+            uint32_t value = (i < length) ? (uint32_t) (polynomial[i] % primes[m]) : 0;
+            values[m][i] = montgomeryMultiply(&moduli[m], value, moduli[m].rSquared);
+        }
+        squareModulo(values[m], size, &moduli[m]);
+    }
+    if (numOfPrimes == 1)
+    {
+        for (long i = 0; i < squareLength; i++)
+        {
+            squared[i] = values[0][i];
+        }
+    }
+    else // x = second + SECOND_PRIME * t, where t is chosen for x to be first modulo FIRST_PRIME
+    {
+        uint64_t inverse = powerModulo(SECOND_PRIME % FIRST_PRIME, FIRST_PRIME - 2, FIRST_PRIME);
+        for (long i = 0; i < squareLength; i++)
+        {
+            uint64_t difference = ((uint64_t) values[1][i] + FIRST_PRIME -
+                                   values[0][i] % FIRST_PRIME) % FIRST_PRIME;
+            uint64_t t = difference * inverse % FIRST_PRIME;
+            squared[i] = (long long) (values[0][i] + (uint64_t) SECOND_PRIME * t);
+        }
+    }
+    free(values[0]);
+    free(values[1]);
+}
+
+void squareModulo(uint32_t *values, long size, const Modulus *modulus)
+{
+    uint32_t prime = modulus->prime;
+    uint32_t *twiddles = (uint32_t *) checkedMalloc((size / 2 + 1) * sizeof(uint32_t));
+    uint32_t root = (uint32_t) powerModulo(PRIMITIVE_ROOT, (prime - 1) / size, prime);
+    root = montgomeryMultiply(modulus, root, modulus->rSquared);
+    twiddles[0] = montgomeryMultiply(modulus, 1, modulus->rSquared);
+    for (long i = 1; i < size / 2; i++)
+    {
+        twiddles[i] = montgomeryMultiply(modulus, twiddles[i - 1], root);
+    }
+    transform(values, size, modulus, twiddles);
+    for (long i = 0; i < size; i++)
+    {
+        values[i] = montgomeryMultiply(modulus, values[i], values[i]);
+    }
+    // the inverse transform is the transform, with all the values but the first reversed
+    transform(values, size, modulus, twiddles);
+    for (long i = 1, j = size - 1; i < j; i++, j--)
+    {
+        uint32_t temp = values[i];
+        values[i] = values[j];
+        values[j] = temp;
+    }
+    uint32_t sizeInverse = (uint32_t) powerModulo((uint64_t) size, prime - 2, prime);
+    for (long i = 0; i < size; i++) // x * sizeInverse * 2^32 / 2^32, out of Montgomery form
+    {
+        values[i] = montgomeryMultiply(modulus, values[i], sizeInverse);
+    }
+    free(twiddles);
+}
+
+void transform(uint32_t *values, long size, const Modulus *modulus, const uint32_t *twiddles)
+{
+    uint32_t prime = modulus->prime;
+    for (long i = 1, j = 0; i < size; i++) // the bit reversal permutation
+    {
+        long bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            uint32_t temp = values[i];
+            values[i] = values[j];
+            values[j] = temp;
+        }
+    }
+    for (long length = 2; length <= size; length <<= 1)
+    {
+        long half = length / 2;
+        long step = size / length;
+        for (long i = 0; i < size; i += length)
+        {
+            for (long j = 0; j < half; j++)
+            {
+                uint32_t even = values[i + j];
+                uint32_t odd = montgomeryMultiply(modulus, values[i + j + half],
+                                                  twiddles[j * step]);
+                uint32_t sum = even + odd;
+                values[i + j] = (sum >= prime) ? sum - prime : sum;
+                values[i + j + half] = (even >= odd) ? even - odd : even + prime - odd;
+            }
+        }
+    }
+}
+
+void initModulus(Modulus *modulus, uint32_t prime)
+{
+    uint32_t inverse = prime; // correct to 3 bits, and every step doubles that
+    for (int i = 0; i < 4; i++)
+    {
+        inverse *= 2 - prime * inverse;
+    }
+    modulus->prime = prime;
+    modulus->negativeInverse = 0u - inverse;
+    modulus->rSquared = (uint32_t) ((0ull - prime) % prime);
+}
+
+uint32_t montgomeryReduce(const Modulus *modulus, uint64_t x)
+{
+    uint32_t m = (uint32_t) x * modulus->negativeInverse;
+    uint64_t reduced = (x + (uint64_t) m * modulus->prime) >> 32;
+    return (uint32_t) ((reduced >= modulus->prime) ? reduced - modulus->prime : reduced);
+}
+
+uint32_t montgomeryMultiply(const Modulus *modulus, uint32_t first, uint32_t second)
+{
+    return montgomeryReduce(modulus, (uint64_t) first * second);
+}
+
+uint64_t powerModulo(uint64_t base, uint64_t exponent, uint64_t prime)
+{
+    uint64_t result = 1;
+    base %= prime;
+    while (exponent > 0)
+    {
+        if (exponent & 1)
+        {
+            result = result * base % prime;
+        }
+        base = base * base % prime;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************               Radius Queries               ************************
+*********************************************************************************
+********************************************************************************/
+
+long long countWithin(const int32_t *within, int32_t length, long distance)
+{
+    if (distance < 0 || within == NULL)
+    {
+        return 0;
+    }
+    return within[(distance < length) ? distance : length - 1];
+}
+
+long long countWithinDistance(const CentroidIndex *index, int x, long distance)
+{
+    long long count = countWithin(index->within[x], index->withinLength[x], distance);
+    int32_t part = x;
+    for (int32_t centroid = index->centroidParent[x]; centroid != -1;
+         centroid = index->centroidParent[centroid])
+    {
+        long left = distance - treeDistance(index->lca, x, centroid);
+        count += countWithin(index->within[centroid], index->withinLength[centroid], left) -
+                 countWithin(index->parentWithin[part], index->parentWithinLength[part], left);
+        part = centroid;
+    }
+    return count;
+}
+
+void freeCentroidIndex(CentroidIndex *index)
+{
+    for (int i = 0; i < index->numOfNodes; i++)
+    {
+        free(index->within[i]);
+        free(index->parentWithin[i]);
+    }
+    free(index->within);
+    free(index->withinLength);
+    free(index->parentWithin);
+    free(index->parentWithinLength);
+    free(index->centroidParent);
+    freeLcaIndex(index->lca);
+    free(index->histogram);
+    free(index);
+}
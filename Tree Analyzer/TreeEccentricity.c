@@ -0,0 +1,134 @@
+/**
+* @file TreeEccentricity.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief computing the eccentricity of every node of a tree, and the center of the tree
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree and its root
+* Process: the eccentricity of a node is the longest route from it, which either goes down into
+* its subtree or up through its father. the nodes are put in BFS order from the root. the first
+* pass runs the order in reverse and computes the two highest routes down from every node, and
+* the son the highest one goes through. the second pass runs the order forwards and computes the
+* longest route up from every node out of the route up from its father and the highest route down
+* from its father that doesn't go through the node itself. the center is the node with the least
+* eccentricity - there are at most two, and if two they are neighbours.
+* Output : the eccentricity of every node, the radius and the center of the tree
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ECCENTRICITY_MAGIC "ECC1"
+
+int32_t *allEccentricities(const AllTree *mainTree, int root, TreeCenter *center)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int n = mainTree->value;
+    int32_t *order = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *highest = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *secondHighest = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *highestSon = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *eccentricity = (int32_t *) checkedMalloc(n * sizeof(int32_t)); // the route up, first
+
+    int numOfOrdered = 1;
+    order[0] = root;
+    for (int i = 0; i < numOfOrdered; i++)
+    {
+        int32_t cur = order[i];
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            order[numOfOrdered++] = sons[j];
+        }
+    }
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        int32_t cur = order[i];
+        highest[cur] = 0;
+        secondHighest[cur] = 0;
+        highestSon[cur] = -1;
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            int32_t son = sons[j];
+            int32_t sonHeight = highest[son] + 1;
+            if (sonHeight > highest[cur])
+            {
+                secondHighest[cur] = highest[cur];
+                highest[cur] = sonHeight;
+                highestSon[cur] = son;
+            }
+            else if (sonHeight > secondHighest[cur])
+            {
+                secondHighest[cur] = sonHeight;
+            }
+        }
+    }
+
+    eccentricity[root] = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int32_t cur = order[i];
+        int32_t up = eccentricity[cur];
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            int32_t son = sons[j];
+            int32_t down = (son == highestSon[cur]) ? secondHighest[cur] : highest[cur];
+            eccentricity[son] = 1 + ((up > down) ? up : down);
+        }
+        if (highest[cur] > up) // the route up of cur is no longer needed
+        {
+            eccentricity[cur] = highest[cur];
+        }
+    }
+
+    center->radius = n;
+    center->center = -1;
+    center->secondCenter = -1;
+    for (int i = 0; i < n; i++)
+    {
+        if (eccentricity[i] < center->radius)
+        {
+            center->radius = eccentricity[i];
+            center->center = i;
+            center->secondCenter = -1;
+        }
+        else if (eccentricity[i] == center->radius)
+        {
+            center->secondCenter = i;
+        }
+    }
+    free(order);
+    free(highest);
+    free(secondHighest);
+    free(highestSon);
+    return eccentricity;
+}
+
+int writeEccentricities(const int32_t *eccentricity, int n, OutputBuffer *out, int binary)
+{
+    if (binary)
+    {
+        uint32_t numOfNodes = (uint32_t) n;
+        appendBytes(out, ECCENTRICITY_MAGIC, 4);
+        appendBytes(out, &numOfNodes, sizeof(numOfNodes));
+        appendBytes(out, eccentricity, (size_t) n * sizeof(int32_t));
+    }
+    else
+    {
+        appendOutput(out, "vertex,eccentricity\n");
+        for (int i = 0; i < n; i++)
+        {
+            appendNumber(out, i);
+            appendChar(out, ',');
+            appendNumber(out, eccentricity[i]);
+            appendChar(out, '\n');
+        }
+    }
+    return flushOutput(out);
+}
@@ -0,0 +1,370 @@
+/**
+* @file TreeGenerator.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief a generator of graph files of synthetic trees - a program of its own, with its own main
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : the shape of the tree, its number of vertices, and optionally the arity of a k-ary tree,
+* the seed of the random choices and the file to write
+* Process: the nodes are first numbered in the order they are added to the tree, so the father
+* of every node is a node added before it - the previous node in a path, the first node in a
+* star, node (i - 1) / k in a complete k-ary tree, a random earlier node in a random recursive
+* tree, and in a caterpillar the first half of the nodes is a path and every other node is a leg
+* of one of them, round robin. the sons of every node are counted and then laid out in a single
+* array. then the numbers of the nodes are shuffled into random labels, so that nothing in the
+* file is in order, and the lines are written in the order of the labels. the random fathers are
+* drawn twice from the same seed, once for counting and once for laying out, instead of being
+* kept. it takes 16 bytes per vertex.
+* Output : a graph file in the format the TreeAnalyzer reads - the number of vertices, then a line
+* per vertex holding its sons, or "-" if it has none
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define USAGE "Usage: TreeGenerator <path|star|kary|random|caterpillar> <Number Of Vertices> " \
+              "[--arity <K>] [--seed <S>] [--output <File Path>]\n"
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define MAX_LINE_NUMBER_LENGTH 12
+#define MAX_VERTICES 1000000000L
+#define LABELS_SEED_MIX 0x9e3779b97f4a7c15ULL
+
+#define SHAPE_PATH 0
+#define SHAPE_STAR 1
+#define SHAPE_KARY 2
+#define SHAPE_RANDOM 3
+#define SHAPE_CATERPILLAR 4
+
+/**
+ * @brief the tree to generate:
+ * kind - one of the SHAPE_ constants
+ * numOfVertices - the number of vertices in the tree
+ * arity - the number of sons of every inner node of a k-ary tree
+ * spineLength - the number of nodes on the path of a caterpillar
+ * seed - the seed of the random choices
+ */
+typedef struct TreeShape
+{
+    int kind;
+    int32_t numOfVertices;
+    int32_t arity;
+    int32_t spineLength;
+    uint64_t seed;
+} TreeShape;
+
+/**
+ * @brief the output of the generator, written a buffer at a time:
+ * file - the file written
+ * buffer, length - the bytes not written yet
+ * failed - set if a write failed
+ */
+typedef struct GraphWriter
+{
+    FILE *file;
+    char *buffer;
+    size_t length;
+    int failed;
+} GraphWriter;
+
+/**
+ * @brief the next number of a splitmix64 sequence
+ * @param state - in/out: the state of the sequence
+ */
+uint64_t nextRandom(uint64_t *state);
+
+/**
+ * @brief a random number in 0..bound-1
+ */
+uint32_t randomBelow(uint64_t *state, uint32_t bound);
+
+/**
+ * @brief the father of node i of the tree, numbered in the order the nodes are added
+ * @param i - a node other than the first
+ * @param state - in/out: the random sequence the fathers of a random tree are drawn from
+ */
+int32_t fatherOf(const TreeShape *shape, int32_t i, uint64_t *state);
+
+/**
+ * @brief lays out the sons of every node, numbered in the order the nodes are added
+ * @param sonsEnd - out: the end of the sons of every node in sons. the sons of node i start at
+ * the end of the sons of node i - 1.
+ * @param sons - out: the sons of all the nodes, node after node
+ */
+void layOutSons(const TreeShape *shape, int32_t *sonsEnd, int32_t *sons);
+
+/**
+ * @brief draws a random label for every node
+ * @param label - out: the label of every node
+ * @param node - out: the node of every label
+ */
+void shuffleLabels(const TreeShape *shape, int32_t *label, int32_t *node);
+
+/**
+ * @brief writes the graph file of the tree
+ * @return - 1 for success, 0 if writing failed
+ */
+int writeGraph(FILE *file, int32_t numOfVertices, const int32_t *sonsEnd, const int32_t *sons,
+               const int32_t *label, const int32_t *node);
+
+/**
+ * @brief appends a number to the output
+ */
+void writeNumber(GraphWriter *writer, uint32_t number);
+
+/**
+ * @brief writes the buffered bytes to the file
+ */
+void flushWriter(GraphWriter *writer);
+
+/**
+ * @brief reads a positive number argument
+ * @return - the number, -1 if it isn't a positive number up to MAX_VERTICES
+ */
+long parsePositive(const char *arg);
+
+int main(int argc, char *argv[])
+{
+    const char *shapes[] = {"path", "star", "kary", "random", "caterpillar"};
+    TreeShape shape = {-1, 0, 2, 0, 1};
+    const char *outputFile = NULL;
+    if (argc < 3 || argc % 2 == 0)
+    {
+        fprintf(stderr, USAGE);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < (int) (sizeof(shapes) / sizeof(shapes[0])); i++)
+    {
+        if (strcmp(argv[1], shapes[i]) == 0)
+        {
+            shape.kind = i;
+        }
+    }
+    long numOfVertices = parsePositive(argv[2]);
+    for (int i = 3; i + 1 < argc && numOfVertices > 0; i += 2)
+    {
+        long number = parsePositive(argv[i + 1]);
+        if (strcmp(argv[i], "--arity") == 0 && number > 0)
+        {
+            shape.arity = (int32_t) number;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && number > 0)
+        {
+            shape.seed = (uint64_t) number;
+        }
+        else if (strcmp(argv[i], "--output") == 0)
+        {
+            outputFile = argv[i + 1];
+        }
+        else
+        {
+            numOfVertices = -1;
+        }
+    }
+    if (shape.kind == -1 || numOfVertices <= 0)
+    {
+        fprintf(stderr, USAGE);
+        return EXIT_FAILURE;
+    }
+    shape.numOfVertices = (int32_t) numOfVertices;
+    shape.spineLength = (shape.numOfVertices + 1) / 2;
+
+    size_t n = (size_t) shape.numOfVertices;
+    int32_t *sonsEnd = (int32_t *) malloc(n * sizeof(int32_t));
+    int32_t *sons = (int32_t *) malloc((n > 1 ? n - 1 : 1) * sizeof(int32_t));
+    int32_t *label = (int32_t *) malloc(n * sizeof(int32_t));
+    int32_t *node = (int32_t *) malloc(n * sizeof(int32_t));
+    if (sonsEnd == NULL || sons == NULL || label == NULL || node == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    layOutSons(&shape, sonsEnd, sons);
+    shuffleLabels(&shape, label, node);
+
+    FILE *file = stdout;
+    if (outputFile != NULL && strcmp(outputFile, "-") != 0)
+    {
+        file = fopen(outputFile, "w");
+        if (file == NULL)
+        {
+            fprintf(stderr, "the output file can't be opened\n");
+            return EXIT_FAILURE;
+        }
+    }
+    int written = writeGraph(file, shape.numOfVertices, sonsEnd, sons, label, node);
+    if ((file != stdout && fclose(file) != 0) || (file == stdout && fflush(stdout) != 0))
+    {
+        written = 0;
+    }
+    free(sonsEnd);
+    free(sons);
+    free(label);
+    free(node);
+    if (!written)
+    {
+        fprintf(stderr, "the output can't be written\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint32_t randomBelow(uint64_t *state, uint32_t bound)
+{
+    return (uint32_t) (((nextRandom(state) >> 32) * bound) >> 32);
+}
+
+int32_t fatherOf(const TreeShape *shape, int32_t i, uint64_t *state)
+{
+    switch (shape->kind)
+    {
+        case SHAPE_PATH:
+            return i - 1;
+        case SHAPE_STAR:
+            return 0;
+        case SHAPE_KARY:
+            return (i - 1) / shape->arity;
+        case SHAPE_RANDOM:
+            return (int32_t) randomBelow(state, (uint32_t) i);
+        default: // a caterpillar
+            return (i < shape->spineLength) ? i - 1 : (i - shape->spineLength) % shape->spineLength;
+    }
+}
+
+void layOutSons(const TreeShape *shape, int32_t *sonsEnd, int32_t *sons)
+{
+    int32_t n = shape->numOfVertices;
+    uint64_t state = shape->seed;
+    for (int32_t i = 0; i < n; i++)
+    {
+        sonsEnd[i] = 0;
+    }
+    for (int32_t i = 1; i < n; i++)
+    {
+        sonsEnd[fatherOf(shape, i, &state)]++;
+    }
+    int32_t numOfSons = 0;
+    for (int32_t i = 0; i < n; i++) // every node starts out at the start of its sons
+    {
+        int32_t count = sonsEnd[i];
+        sonsEnd[i] = numOfSons;
+        numOfSons += count;
+    }
+    state = shape->seed; // the same fathers again
+    for (int32_t i = 1; i < n; i++)
+    {
+        sons[sonsEnd[fatherOf(shape, i, &state)]++] = i;
+    }
+}
+
+void shuffleLabels(const TreeShape *shape, int32_t *label, int32_t *node)
+{
+    int32_t n = shape->numOfVertices;
+    uint64_t state = shape->seed ^ LABELS_SEED_MIX;
+    for (int32_t i = 0; i < n; i++)
+    {
+        label[i] = i;
+    }
+    for (int32_t i = n - 1; i > 0; i--)
+    {
+        int32_t j = (int32_t) randomBelow(&state, (uint32_t) i + 1);
+        int32_t temp = label[i];
+        label[i] = label[j];
+        label[j] = temp;
+    }
+    for (int32_t i = 0; i < n; i++)
+    {
+        node[label[i]] = i;
+    }
+}
+
+int writeGraph(FILE *file, int32_t numOfVertices, const int32_t *sonsEnd, const int32_t *sons,
+               const int32_t *label, const int32_t *node)
+{
+    GraphWriter writer = {file, (char *) malloc(OUTPUT_BUFFER_SIZE), 0, 0};
+    if (writer.buffer == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    writeNumber(&writer, (uint32_t) numOfVertices);
+    writer.buffer[writer.length++] = '\n';
+    for (int32_t i = 0; i < numOfVertices && !writer.failed; i++)
+    {
+        if (writer.length + MAX_LINE_NUMBER_LENGTH > OUTPUT_BUFFER_SIZE) // room for "-\n"
+        {
+            flushWriter(&writer);
+        }
+        int32_t cur = node[i];
+        int32_t first = (cur == 0) ? 0 : sonsEnd[cur - 1];
+        if (first == sonsEnd[cur])
+        {
+            writer.buffer[writer.length++] = '-';
+        }
+        for (int32_t j = first; j < sonsEnd[cur]; j++)
+        {
+            if (j != first)
+            {
+                writer.buffer[writer.length++] = ' ';
+            }
+            writeNumber(&writer, (uint32_t) label[sons[j]]);
+        }
+        writer.buffer[writer.length++] = '\n';
+    }
+    flushWriter(&writer);
+    free(writer.buffer);
+    return !writer.failed;
+}
+
+void writeNumber(GraphWriter *writer, uint32_t number)
+{
+    if (writer->length + MAX_LINE_NUMBER_LENGTH > OUTPUT_BUFFER_SIZE)
+    {
+        flushWriter(writer);
+    }
+    char digits[MAX_LINE_NUMBER_LENGTH];
+    int numOfDigits = 0;
+    do
+    {
+        digits[numOfDigits++] = (char) ('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    while (numOfDigits > 0)
+    {
+        writer->buffer[writer->length++] = digits[--numOfDigits];
+    }
+}
+
+void flushWriter(GraphWriter *writer)
+{
+    if (writer->length > 0 && fwrite(writer->buffer, 1, writer->length, writer->file) !=
+                              writer->length)
+    {
+        writer->failed = 1;
+    }
+    writer->length = 0;
+}
+
+long parsePositive(const char *arg)
+{
+    char *end;
+    long number = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || number <= 0 || number > MAX_VERTICES)
+    {
+        return -1;
+    }
+    return number;
+}
@@ -0,0 +1,239 @@
+/**
+* @file TreeHld.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief answering sum, min and max queries over the weights along paths of a tree, while the
+* weights change
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, its root and the weights of its nodes
+* Process: heavy-light decomposition - the heavy son of a node is its son with the largest
+* subtree, and following heavy sons splits the tree into chains. the nodes are laid out chain
+* after chain, so every chain is a contiguous range, and any path from a node up to the root
+* crosses O(log n) chains. a segment tree over the layout holds the sum, min and max of every
+* range. a path query climbs from both ends chain by chain, taking one range of the segment tree
+* per chain, until both ends are on the same chain. setting a weight updates a single leaf and the
+* O(log n) ranges above it. nothing is recursive, so deep trees are fine.
+* Output : an HldIndex to query and update
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief orders the nodes from the root in BFS order, and computes their depths and heavy sons
+ * @param order - out: the nodes in BFS order
+ * @param heavySon - out: the heavy son of every node, -1 for a leaf
+ */
+void findHeavySons(const AllTree *mainTree, int root, HldIndex *index, int32_t *order,
+                   int32_t *heavySon);
+
+/**
+ * @brief lays out the chains, and sets the chain head and position of every node
+ */
+void layOutChains(const AllTree *mainTree, int root, HldIndex *index, const int32_t *heavySon);
+
+/**
+ * @brief combines two aggregates
+ */
+PathAggregate combineAggregates(PathAggregate first, PathAggregate second);
+
+/**
+ * @brief the aggregate of the positions from..to of the layout, both included
+ */
+PathAggregate rangeAggregate(const HldIndex *index, int from, int to);
+
+/**
+ * @brief the aggregate of a single weight
+ */
+PathAggregate singleAggregate(long long weight);
+
+HldIndex *buildHldIndex(const AllTree *mainTree, int root, const long long *weights)
+{
+    int n = mainTree->value;
+    HldIndex *index = (HldIndex *) checkedMalloc(sizeof(HldIndex));
+    index->numOfNodes = n;
+    index->father = mainTree->father;
+    index->depth = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->chainHead = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->position = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *order = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *heavySon = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    findHeavySons(mainTree, root, index, order, heavySon);
+    layOutChains(mainTree, root, index, heavySon);
+    free(order);
+    free(heavySon);
+
+    index->numOfLeaves = 1;
+    while (index->numOfLeaves < n)
+    {
+        index->numOfLeaves *= 2;
+    }
+    index->segments = (PathAggregate *) checkedMalloc(2 * index->numOfLeaves *
+                                                      sizeof(PathAggregate));
+    PathAggregate empty = {0, INT64_MAX, INT64_MIN};
+    for (long i = n; i < index->numOfLeaves; i++) // the leaves past the last node
+    {
+        index->segments[index->numOfLeaves + i] = empty;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        index->segments[index->numOfLeaves + index->position[i]] =
+                singleAggregate((weights != NULL) ? weights[i] : 0);
+    }
+    for (long i = index->numOfLeaves - 1; i >= 1; i--)
+    {
+        index->segments[i] = combineAggregates(index->segments[2 * i], index->segments[2 * i + 1]);
+    }
+    return index;
+}
+
+void findHeavySons(const AllTree *mainTree, int root, HldIndex *index, int32_t *order,
+                   int32_t *heavySon)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int n = mainTree->value;
+    int32_t *size = index->position; // free until the chains are laid out
+    int numOfOrdered = 1;
+    order[0] = root;
+    index->depth[root] = 0;
+    for (int i = 0; i < numOfOrdered; i++)
+    {
+        int32_t cur = order[i];
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            index->depth[sons[j]] = index->depth[cur] + 1;
+            order[numOfOrdered++] = sons[j];
+        }
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        int32_t cur = order[i];
+        size[cur] = 1;
+        heavySon[cur] = -1;
+        for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+        {
+            int32_t son = sons[j];
+            size[cur] += size[son];
+            if (heavySon[cur] == -1 || size[son] > size[heavySon[cur]])
+            {
+                heavySon[cur] = son;
+            }
+        }
+    }
+}
+
+void layOutChains(const AllTree *mainTree, int root, HldIndex *index, const int32_t *heavySon)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int32_t *chainHeads = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+    int numOfHeads = 0;
+    int32_t nextPosition = 0;
+    chainHeads[numOfHeads++] = root;
+    while (numOfHeads > 0)
+    {
+        int32_t head = chainHeads[--numOfHeads];
+        for (int32_t cur = head; cur != -1; cur = heavySon[cur]) // the whole chain, in order
+        {
+            index->chainHead[cur] = head;
+            index->position[cur] = nextPosition++;
+            for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+            {
+                if (sons[j] != heavySon[cur]) // every light son starts a chain of its own
+                {
+                    chainHeads[numOfHeads++] = sons[j];
+                }
+            }
+        }
+    }
+    free(chainHeads);
+}
+
+PathAggregate hldPathQuery(const HldIndex *index, int u, int v)
+{
+    PathAggregate result = {0, INT64_MAX, INT64_MIN};
+    while (index->chainHead[u] != index->chainHead[v])
+    {
+        if (index->depth[index->chainHead[u]] < index->depth[index->chainHead[v]])
+        {
+            int temp = u;
+            u = v;
+            v = temp;
+        }
+        int32_t head = index->chainHead[u];
+        result = combineAggregates(result, rangeAggregate(index, index->position[head],
+                                                          index->position[u]));
+        u = index->father[head];
+    }
+    int from = index->position[u];
+    int to = index->position[v];
+    if (from > to)
+    {
+        int temp = from;
+        from = to;
+        to = temp;
+    }
+    return combineAggregates(result, rangeAggregate(index, from, to));
+}
+
+void hldSetWeight(HldIndex *index, int x, long long weight)
+{
+    long i = index->numOfLeaves + index->position[x];
+    index->segments[i] = singleAggregate(weight);
+    for (i /= 2; i >= 1; i /= 2)
+    {
+        index->segments[i] = combineAggregates(index->segments[2 * i], index->segments[2 * i + 1]);
+    }
+}
+
+PathAggregate rangeAggregate(const HldIndex *index, int from, int to)
+{
+    PathAggregate result = {0, INT64_MAX, INT64_MIN};
+    long left = from + index->numOfLeaves;
+    long right = to + index->numOfLeaves + 1;
+    while (left < right)
+    {
+        if (left & 1)
+        {
+            result = combineAggregates(result, index->segments[left++]);
+        }
+        if (right & 1)
+        {
+            result = combineAggregates(result, index->segments[--right]);
+        }
+        left /= 2;
+        right /= 2;
+    }
+    return result;
+}
+
+PathAggregate combineAggregates(PathAggregate first, PathAggregate second)
+{
+    PathAggregate result;
+    result.sum = first.sum + second.sum;
+    result.min = (second.min < first.min) ? second.min : first.min;
+    result.max = (second.max > first.max) ? second.max : first.max;
+    return result;
+}
+
+PathAggregate singleAggregate(long long weight)
+{
+    PathAggregate result = {weight, weight, weight};
+    return result;
+}
+
+void freeHldIndex(HldIndex *index)
+{
+    free(index->depth);
+    free(index->chainHead);
+    free(index->position);
+    free(index->segments);
+    free(index);
+}
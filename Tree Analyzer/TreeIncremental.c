@@ -0,0 +1,786 @@
+/**
+* @file TreeIncremental.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief re-analyzing a tree when only a few lines of its graph file changed since the last run
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph file, and the state kept next to it by the last run with --incremental
+* Process: the state holds a hash of every line of the file, the columns of the tree, and a
+* summary of the subtree of every node - its height, the depth of its shallowest leaf and its
+* longest route, with their ends. the file is hashed line by line against the hashes of the
+* state, which finds the changed lines without parsing the others. only the changed lines are
+* parsed - the old sons of their nodes lose their father and the new sons get it - and the tree is
+* checked only where it changed: a single node is left without a father, no node gets two, and no
+* cycle goes through a changed node. the summaries of the changed nodes and their ancestors are
+* then computed again, sons before fathers, and the stats of the tree are the summaries of the
+* root. the state is mapped shared and changed in place, so only the pages that changed are
+* written back. a state is kept only for plain files. a changed first line, a changed number of
+* lines, too many changed lines or a change that makes the graph invalid gives up, and the file is
+* then parsed as a whole.
+* Output : the tree and its stats, as if the file was parsed and analyzed
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STATE_SUFFIX ".state"
+#define STATE_MAGIC "TRSTATE"
+#define STATE_VERSION 1
+#define STATE_BYTE_ORDER 0x01020304u
+#define STATE_ALIGNMENT 64 // the alignment writeAlignedColumn pads the columns to
+#define MIN_CHANGES_TO_GIVE_UP 1024
+#define CHANGES_FRACTION_TO_GIVE_UP 8
+
+/**
+ * @brief the first bytes of a state:
+ * magic, version, byteOrder - identify a state this program can read on this machine
+ * numOfNodes - the size of the tree
+ * numOfLines - the number of lines of the graph file, the first one and any blank ones after the
+ * lines of the nodes included
+ * root - the root of the tree
+ * hashesStart, offsetsStart, sonsStart, fatherStart - where each column starts in the state
+ * summariesStart - where the column of the summaries starts
+ * fileSize - the size of the whole state
+ * headerChecksum - the checksum of all the fields above
+ * updating - set while the state is changed in place, so a state left half changed is never used
+ */
+typedef struct StateHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    int64_t numOfNodes;
+    int64_t numOfLines;
+    int64_t root;
+    uint64_t hashesStart;
+    uint64_t offsetsStart;
+    uint64_t sonsStart;
+    uint64_t fatherStart;
+    uint64_t summariesStart;
+    uint64_t fileSize;
+    uint64_t headerChecksum;
+    uint64_t updating;
+} StateHeader;
+
+/**
+ * @brief the summary of the subtree of a node. the summaries of all the nodes are kept in a single
+ * column, so summarizing a node reads a single cache line of each of its sons:
+ * height, deepest - the length of the longest route down from the node to a leaf, and that leaf
+ * shallowest - the length of the shortest route down from the node to a leaf
+ * longest, longestStart, longestEnd - the length of the longest route inside the subtree, and
+ * its two ends
+ */
+typedef struct SubtreeSummary
+{
+    int32_t height;
+    int32_t deepest;
+    int32_t shallowest;
+    int32_t longest;
+    int32_t longestStart;
+    int32_t longestEnd;
+} SubtreeSummary;
+
+/**
+ * @brief the columns of a mapped state
+ */
+typedef struct TreeState
+{
+    StateHeader *header;
+    int numOfNodes;
+    uint64_t *hashes;
+    int32_t *sonsOffsets;
+    int32_t *sons;
+    int32_t *father;
+    SubtreeSummary *summaries;
+} TreeState;
+
+/**
+ * @brief the lines of the graph file that changed since the state was kept:
+ * lines, hashes - the number of every changed line, starting from 0, and its new hash
+ * begins, ends - the content of every changed line in the mapped file, without its line break
+ * numOfLines, capacity - the number of changed lines, and the room in the arrays
+ * newOffsets, newSons - the new sons of the node of every changed line, the sons of the i-th
+ * change are newSons[newOffsets[i]] up to (not including) newSons[newOffsets[i + 1]]
+ */
+typedef struct LineChanges
+{
+    long *lines;
+    uint64_t *hashes;
+    const char **begins;
+    const char **ends;
+    long numOfLines;
+    long capacity;
+    int64_t *newOffsets;
+    int32_t *newSons;
+} LineChanges;
+
+/**
+ * @brief fills the size of the tree and the layout fields of a header
+ */
+void fillStateLayout(StateHeader *header, int numOfNodes, long numOfLines);
+
+/**
+ * @brief checks the header of a mapped state against the size of the state
+ * @return - 1 if the state can be used, 0 otherwise
+ */
+int checkStateHeader(const StateHeader *header, size_t fileSize);
+
+/**
+ * @brief points the columns of a state into its mapping
+ */
+void openStateColumns(TreeState *state, char *base);
+
+/**
+ * @brief the hash of a line of the graph file, without its line break
+ */
+uint64_t lineHash(const char *p, const char *lineEnd);
+
+/**
+ * @brief hashes all the lines of a graph file
+ * @param numOfLines - out: the number of lines
+ * @return - the hashes in the heap
+ */
+uint64_t *hashAllLines(const MappedFile *file, long *numOfLines);
+
+/**
+ * @brief finds the lines of the graph file that changed since the state was kept, and parses the
+ * new sons of their nodes
+ * @return - 1 if the changes can be applied to the state, 0 if the file has to be parsed as a
+ * whole
+ */
+int findChangedLines(const TreeState *state, const MappedFile *file, LineChanges *changes);
+
+/**
+ * @brief moves the sons of the changed nodes to their new fathers, and checks that the graph is
+ * still a tree. changes only the father column.
+ * @param changedNodes - out: the nodes whose summaries are out of date, in an order where every
+ * node comes before its father. in the heap.
+ * @param numOfChanged - out: the number of those nodes
+ * @return - the new root, -1 if the graph isn't a tree anymore
+ */
+int relinkChangedNodes(TreeState *state, const LineChanges *changes, int32_t **changedNodes,
+                       long *numOfChanged);
+
+/**
+ * @brief writes the new sons of the changed nodes into the sons and sonsOffsets columns. only the
+ * part of the columns between the first and last nodes whose number of sons changed moves.
+ */
+void rewriteSons(TreeState *state, const LineChanges *changes);
+
+/**
+ * @brief computes the summary of the subtree of a node from the summaries of its sons
+ */
+void summarizeNode(const int32_t *sonsOffsets, const int32_t *sons, SubtreeSummary *summaries,
+                   int32_t node);
+
+/**
+ * @brief the stats of the tree, out of the summary of its root
+ */
+void metricsOfSummaries(const SubtreeSummary *summaries, int root, TreeMetrics *metrics);
+
+/**
+ * @brief releases the changed lines
+ */
+void freeLineChanges(LineChanges *changes);
+
+AllTree *updateTreeState(const char *fileName, TreeMetrics *metrics)
+{
+    struct stat stateStat;
+    char *statePath = cachePathOf(fileName, STATE_SUFFIX);
+    int fd = open(statePath, O_RDWR);
+    free(statePath);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(fd, &stateStat) != 0 || stateStat.st_size < (off_t) sizeof(StateHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    size_t stateSize = (size_t) stateStat.st_size;
+    void *data = mmap(NULL, stateSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    MappedFile file = {NULL, 0};
+    if (data == MAP_FAILED || checkStateHeader((const StateHeader *) data, stateSize) == 0 ||
+        mapFile(fileName, &file) == 0 || compressionOf(file.data, file.size) != COMPRESSION_NONE)
+    {
+        unmapFile(&file);
+        if (data != MAP_FAILED)
+        {
+            munmap(data, stateSize);
+        }
+        close(fd);
+        return NULL;
+    }
+    TreeState state;
+    openStateColumns(&state, (char *) data);
+    LineChanges changes;
+    int root = -1;
+    if (findChangedLines(&state, &file, &changes))
+    {
+        // from here on the state is changed in place, so it is marked until it is whole again
+        state.header->updating = 1;
+        msync(data, sizeof(StateHeader), MS_SYNC);
+        int32_t *changedNodes;
+        long numOfChanged;
+        root = relinkChangedNodes(&state, &changes, &changedNodes, &numOfChanged);
+        if (root != -1)
+        {
+            rewriteSons(&state, &changes);
+            for (long i = 0; i < numOfChanged; i++)
+            {
+                summarizeNode(state.sonsOffsets, state.sons, state.summaries, changedNodes[i]);
+            }
+            for (long i = 0; i < changes.numOfLines; i++)
+            {
+                state.hashes[changes.lines[i]] = changes.hashes[i];
+            }
+            metricsOfSummaries(state.summaries, root, metrics);
+            state.header->root = root;
+            state.header->headerChecksum = checksumBytes(0, state.header,
+                                                         offsetof(StateHeader, headerChecksum));
+            msync(data, stateSize, MS_SYNC);
+            state.header->updating = 0;
+            msync(data, sizeof(StateHeader), MS_SYNC);
+        }
+        free(changedNodes);
+        freeLineChanges(&changes);
+    }
+    unmapFile(&file);
+    munmap(data, stateSize);
+    if (root == -1)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // the tree gets a private mapping, so nothing done to it later reaches the state
+    data = mmap(NULL, stateSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return NULL;
+    }
+    openStateColumns(&state, (char *) data);
+    int numOfNodes = state.numOfNodes;
+    AllTree *mainTree = (AllTree *) checkedMalloc(sizeof(AllTree));
+    mainTree->value = numOfNodes;
+    mainTree->sonsOffsets = state.sonsOffsets;
+    mainTree->sons = state.sons;
+    mainTree->father = state.father;
+    mainTree->cache.data = (const char *) data;
+    mainTree->cache.size = stateSize;
+    mainTree->originalLabel = NULL;
+    mainTree->internalLabel = NULL;
+    mainTree->distance = (int32_t *) checkedMalloc(numOfNodes * sizeof(int32_t));
+    mainTree->previousInPath = (int32_t *) checkedMalloc(numOfNodes * sizeof(int32_t));
+    for (int i = 0; i < numOfNodes; i++)
+    {
+        mainTree->previousInPath[i] = -1;
+    }
+    return mainTree;
+}
+
+int writeTreeState(const char *fileName, const AllTree *mainTree, TreeMetrics *metrics)
+{
+    int n = mainTree->value;
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int root = findRoot((AllTree *) mainTree);
+    SubtreeSummary *summaries = (SubtreeSummary *) checkedMalloc(n * sizeof(SubtreeSummary));
+    int32_t *order = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int numOfOrdered = 1;
+    order[0] = root;
+    for (int i = 0; i < numOfOrdered; i++)
+    {
+        for (int32_t j = sonsOffsets[order[i]]; j < sonsOffsets[order[i] + 1]; j++)
+        {
+            order[numOfOrdered++] = sons[j];
+        }
+    }
+    for (int i = n - 1; i >= 0; i--) // every node after all of its sons
+    {
+        summarizeNode(sonsOffsets, sons, summaries, order[i]);
+    }
+    free(order);
+    metricsOfSummaries(summaries, root, metrics);
+
+    MappedFile file = {NULL, 0};
+    if (mapFile(fileName, &file) == 0 || compressionOf(file.data, file.size) != COMPRESSION_NONE)
+    {
+        unmapFile(&file); // the lines of a compressed file are only known once it is decompressed
+        free(summaries);
+        return 0;
+    }
+    long numOfLines;
+    uint64_t *hashes = hashAllLines(&file, &numOfLines);
+    unmapFile(&file);
+    StateHeader header;
+    fillStateLayout(&header, n, numOfLines);
+    header.root = root;
+    header.headerChecksum = checksumBytes(0, &header, offsetof(StateHeader, headerChecksum));
+
+    char *statePath = cachePathOf(fileName, STATE_SUFFIX);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), STATE_SUFFIX ".%ld.tmp", (long) getpid());
+    char *tempPath = cachePathOf(fileName, suffix);
+    FILE *out = fopen(tempPath, "wb");
+    int written = out != NULL &&
+                  writeAlignedColumn(out, &header, sizeof(header)) &&
+                  writeAlignedColumn(out, hashes, numOfLines * sizeof(uint64_t)) &&
+                  writeAlignedColumn(out, sonsOffsets, ((size_t) n + 1) * sizeof(int32_t)) &&
+                  writeAlignedColumn(out, sons, (n - 1) * sizeof(int32_t)) &&
+                  writeAlignedColumn(out, mainTree->father, n * sizeof(int32_t)) &&
+                  writeAlignedColumn(out, summaries, n * sizeof(SubtreeSummary));
+    if (out != NULL && fclose(out) != 0)
+    {
+        written = 0;
+    }
+    if (written && rename(tempPath, statePath) != 0)
+    {
+        written = 0;
+    }
+    if (!written && out != NULL)
+    {
+        unlink(tempPath);
+    }
+    free(statePath);
+    free(tempPath);
+    free(hashes);
+    free(summaries);
+    return written;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************            Finding the Changes             ************************
+*********************************************************************************
+********************************************************************************/
+
+uint64_t lineHash(const char *p, const char *lineEnd)
+{
+    return checksumBytes((uint64_t) (lineEnd - p), p, (size_t) (lineEnd - p));
+}
+
+uint64_t *hashAllLines(const MappedFile *file, long *numOfLines)
+{
+    long capacity = 1024;
+    uint64_t *hashes = (uint64_t *) checkedMalloc(capacity * sizeof(uint64_t));
+    const char *p = file->data;
+    const char *end = file->data + file->size;
+    *numOfLines = 0;
+    while (p < end)
+    {
+        const char *lineEnd = (const char *) memchr(p, '\n', (size_t) (end - p));
+        if (lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        if (*numOfLines == capacity)
+        {
+            capacity *= 2;
+            hashes = (uint64_t *) checkedRealloc(hashes, capacity * sizeof(uint64_t));
+        }
+        hashes[(*numOfLines)++] = lineHash(p, lineEnd);
+        p = lineEnd + 1;
+    }
+    return hashes;
+}
+
+int findChangedLines(const TreeState *state, const MappedFile *file, LineChanges *changes)
+{
+    memset(changes, 0, sizeof(LineChanges));
+    long numOfLines = (long) state->header->numOfLines;
+    long maxChanges = MIN_CHANGES_TO_GIVE_UP + state->numOfNodes / CHANGES_FRACTION_TO_GIVE_UP;
+    const char *p = file->data;
+    const char *end = file->data + file->size;
+    long line = 0;
+    for (; p < end; line++)
+    {
+        const char *lineEnd = (const char *) memchr(p, '\n', (size_t) (end - p));
+        if (lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        uint64_t hash = lineHash(p, lineEnd);
+        if (line == numOfLines || (hash != state->hashes[line] && line == 0))
+        {
+            break;
+        }
+        if (hash != state->hashes[line])
+        {
+            if (changes->numOfLines == maxChanges || line > state->numOfNodes)
+            {
+                break; // too different to be worth it, or a blank line at the end changed
+            }
+            if (changes->numOfLines == changes->capacity)
+            {
+                changes->capacity = (changes->capacity == 0) ? 64 : 2 * changes->capacity;
+                size_t capacity = (size_t) changes->capacity;
+                changes->lines = (long *) checkedRealloc(changes->lines, capacity * sizeof(long));
+                changes->hashes = (uint64_t *) checkedRealloc(changes->hashes,
+                                                              capacity * sizeof(uint64_t));
+                changes->begins = (const char **) checkedRealloc(changes->begins,
+                                                                 capacity * sizeof(char *));
+                changes->ends = (const char **) checkedRealloc(changes->ends,
+                                                               capacity * sizeof(char *));
+            }
+            changes->lines[changes->numOfLines] = line;
+            changes->hashes[changes->numOfLines] = hash;
+            changes->begins[changes->numOfLines] = p;
+            changes->ends[changes->numOfLines] = lineEnd;
+            changes->numOfLines++;
+        }
+        p = lineEnd + 1;
+    }
+    if (p < end || line != numOfLines)
+    {
+        freeLineChanges(changes);
+        return 0;
+    }
+
+    // the new sons are counted first, and then written into a single array
+    changes->newOffsets = (int64_t *) checkedMalloc((changes->numOfLines + 1) * sizeof(int64_t));
+    changes->newOffsets[0] = 0;
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        long long numOfSons = scanGraphLine(changes->begins[i], changes->ends[i],
+                                            state->numOfNodes, NULL, 0);
+        if (numOfSons < 0 || numOfSons >= state->numOfNodes)
+        {
+            freeLineChanges(changes);
+            return 0;
+        }
+        changes->newOffsets[i + 1] = changes->newOffsets[i] + numOfSons;
+    }
+    changes->newSons = (int32_t *) checkedMalloc(changes->newOffsets[changes->numOfLines] *
+                                                 sizeof(int32_t));
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        scanGraphLine(changes->begins[i], changes->ends[i], state->numOfNodes,
+                      &changes->newSons[changes->newOffsets[i]],
+                      changes->newOffsets[i + 1] - changes->newOffsets[i]);
+    }
+    return 1;
+}
+
+void freeLineChanges(LineChanges *changes)
+{
+    free(changes->lines);
+    free(changes->hashes);
+    free(changes->begins);
+    free(changes->ends);
+    free(changes->newOffsets);
+    free(changes->newSons);
+    memset(changes, 0, sizeof(LineChanges));
+}
+
+/********************************************************************************
+*********************************************************************************
+*************            Applying the Changes            ************************
+*********************************************************************************
+********************************************************************************/
+
+int relinkChangedNodes(TreeState *state, const LineChanges *changes, int32_t **changedNodes,
+                       long *numOfChanged)
+{
+    int32_t *father = state->father;
+    const int32_t *sonsOffsets = state->sonsOffsets;
+    const int32_t *sons = state->sons;
+    int root = (int) state->header->root;
+    *changedNodes = NULL;
+    *numOfChanged = 0;
+
+    // the old sons lose their father first, so a son moved between two changed nodes is free
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        int32_t node = (int32_t) (changes->lines[i] - 1);
+        for (int32_t j = sonsOffsets[node]; j < sonsOffsets[node + 1]; j++)
+        {
+            father[sons[j]] = -1;
+        }
+    }
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        int32_t node = (int32_t) (changes->lines[i] - 1);
+        for (int64_t j = changes->newOffsets[i]; j < changes->newOffsets[i + 1]; j++)
+        {
+            if (father[changes->newSons[j]] != -1) // a second father, or a son written twice
+            {
+                return -1;
+            }
+            father[changes->newSons[j]] = node;
+        }
+    }
+    // only the old root and the old sons of the changed nodes may be left without a father
+    int numOfRoots = (father[root] == -1);
+    int newRoot = (father[root] == -1) ? root : -1;
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        int32_t node = (int32_t) (changes->lines[i] - 1);
+        for (int32_t j = sonsOffsets[node]; j < sonsOffsets[node + 1]; j++)
+        {
+            if (father[sons[j]] == -1)
+            {
+                numOfRoots++;
+                newRoot = sons[j];
+            }
+        }
+    }
+    if (numOfRoots != 1)
+    {
+        return -1;
+    }
+
+    // every changed node and its ancestors need new summaries. the route up from every changed
+    // node is marked with its own walk, and stops at the first node marked by an earlier walk -
+    // which already leads to the root. meeting a node of the same walk is a cycle. each node
+    // counts its sons on the routes, so they can be summarized sons first.
+    int n = state->numOfNodes;
+    int32_t *walk = (int32_t *) checkedCalloc((size_t) n, sizeof(int32_t));
+    int32_t *waitingSons = (int32_t *) checkedCalloc((size_t) n, sizeof(int32_t));
+    long capacity = 64;
+    int32_t *marked = (int32_t *) checkedMalloc(capacity * sizeof(int32_t));
+    long numOfMarked = 0;
+    int isTree = 1;
+    for (long i = 0; i < changes->numOfLines && isTree; i++)
+    {
+        int32_t cur = (int32_t) (changes->lines[i] - 1);
+        int32_t walkId = (int32_t) (i + 1);
+        while (walk[cur] == 0)
+        {
+            walk[cur] = walkId;
+            if (numOfMarked == capacity)
+            {
+                capacity *= 2;
+                marked = (int32_t *) checkedRealloc(marked, capacity * sizeof(int32_t));
+            }
+            marked[numOfMarked++] = cur;
+            if (father[cur] == -1)
+            {
+                break;
+            }
+            cur = father[cur];
+            waitingSons[cur]++;
+            if (walk[cur] == walkId)
+            {
+                isTree = 0;
+            }
+        }
+    }
+    // the nodes are summarized as soon as all of their marked sons were
+    long numOfReady = 0;
+    int32_t *order = (int32_t *) checkedMalloc((numOfMarked + 1) * sizeof(int32_t));
+    for (long i = 0; i < numOfMarked && isTree; i++)
+    {
+        if (waitingSons[marked[i]] == 0)
+        {
+            order[numOfReady++] = marked[i];
+        }
+    }
+    for (long i = 0; i < numOfReady; i++)
+    {
+        int32_t up = father[order[i]];
+        if (up != -1 && --waitingSons[up] == 0)
+        {
+            order[numOfReady++] = up;
+        }
+    }
+    free(walk);
+    free(waitingSons);
+    free(marked);
+    *changedNodes = order;
+    *numOfChanged = numOfReady;
+    return isTree ? newRoot : -1;
+}
+
+void rewriteSons(TreeState *state, const LineChanges *changes)
+{
+    int32_t *sonsOffsets = state->sonsOffsets;
+    int32_t *sons = state->sons;
+    long first = -1;
+    long last = -1;
+    for (long i = 0; i < changes->numOfLines; i++)
+    {
+        int32_t node = (int32_t) (changes->lines[i] - 1);
+        int64_t numOfSons = changes->newOffsets[i + 1] - changes->newOffsets[i];
+        if (numOfSons != sonsOffsets[node + 1] - sonsOffsets[node])
+        {
+            first = (first == -1) ? i : first;
+            last = i;
+        }
+        else // the same room, written in place
+        {
+            memcpy(&sons[sonsOffsets[node]], &changes->newSons[changes->newOffsets[i]],
+                   numOfSons * sizeof(int32_t));
+        }
+    }
+    if (first == -1)
+    {
+        return;
+    }
+    // the sons of the nodes from the first to the last change of size are written again into a
+    // copy - the tree has n - 1 sons before and after, so the part after them doesn't move
+    int32_t firstNode = (int32_t) (changes->lines[first] - 1);
+    int32_t lastNode = (int32_t) (changes->lines[last] - 1);
+    int32_t begin = sonsOffsets[firstNode];
+    int32_t length = sonsOffsets[lastNode + 1] - begin;
+    int32_t *rewritten = (int32_t *) checkedMalloc(length * sizeof(int32_t));
+    int32_t position = 0;
+    int32_t oldFirst = begin;
+    long change = first;
+    for (int32_t node = firstNode; node <= lastNode; node++)
+    {
+        int32_t oldEnd = sonsOffsets[node + 1];
+        if (change <= last && changes->lines[change] - 1 == node)
+        {
+            int64_t numOfSons = changes->newOffsets[change + 1] - changes->newOffsets[change];
+            memcpy(&rewritten[position], &changes->newSons[changes->newOffsets[change]],
+                   numOfSons * sizeof(int32_t));
+            position += (int32_t) numOfSons;
+            change++;
+        }
+        else
+        {
+            memcpy(&rewritten[position], &sons[oldFirst], (oldEnd - oldFirst) * sizeof(int32_t));
+            position += oldEnd - oldFirst;
+        }
+        oldFirst = oldEnd;
+        sonsOffsets[node + 1] = begin + position;
+    }
+    memcpy(&sons[begin], rewritten, length * sizeof(int32_t));
+    free(rewritten);
+}
+
+/********************************************************************************
+*********************************************************************************
+*************              Summaries & State             ************************
+*********************************************************************************
+********************************************************************************/
+
+void summarizeNode(const int32_t *sonsOffsets, const int32_t *sons, SubtreeSummary *summaries,
+                   int32_t node)
+{
+    int32_t highest = 0;
+    int32_t secondHighest = 0;
+    int32_t highestEnd = node;
+    int32_t secondHighestEnd = node;
+    int32_t shallowest = (sonsOffsets[node] == sonsOffsets[node + 1]) ? 0 : INT32_MAX;
+    int32_t longest = 0;
+    int32_t longestStart = node;
+    int32_t longestEnd = node;
+    for (int32_t j = sonsOffsets[node]; j < sonsOffsets[node + 1]; j++)
+    {
+        const SubtreeSummary *son = &summaries[sons[j]];
+        int32_t sonHeight = son->height + 1;
+        if (sonHeight > highest)
+        {
+            secondHighest = highest;
+            secondHighestEnd = highestEnd;
+            highest = sonHeight;
+            highestEnd = son->deepest;
+        }
+        else if (sonHeight > secondHighest)
+        {
+            secondHighest = sonHeight;
+            secondHighestEnd = son->deepest;
+        }
+        if (son->shallowest + 1 < shallowest)
+        {
+            shallowest = son->shallowest + 1;
+        }
+        if (son->longest > longest)
+        {
+            longest = son->longest;
+            longestStart = son->longestStart;
+            longestEnd = son->longestEnd;
+        }
+    }
+    if (highest + secondHighest > longest)
+    {
+        longest = highest + secondHighest;
+        longestStart = highestEnd;
+        longestEnd = secondHighestEnd;
+    }
+    SubtreeSummary summary = {highest, highestEnd, shallowest, longest, longestStart, longestEnd};
+    summaries[node] = summary;
+}
+
+void metricsOfSummaries(const SubtreeSummary *summaries, int root, TreeMetrics *metrics)
+{
+    metrics->root = root;
+    metrics->minBranch = summaries[root].shallowest;
+    metrics->maxBranch = summaries[root].height;
+    metrics->diameter = summaries[root].longest;
+    metrics->diameterStart = summaries[root].longestStart;
+    metrics->diameterEnd = summaries[root].longestEnd;
+}
+
+/**
+ * @brief the end of a column written at a position, padded to the next STATE_ALIGNMENT boundary
+ */
+uint64_t alignedEnd(uint64_t position, uint64_t length)
+{
+    return (position + length + STATE_ALIGNMENT - 1) / STATE_ALIGNMENT * STATE_ALIGNMENT;
+}
+
+void fillStateLayout(StateHeader *header, int numOfNodes, long numOfLines)
+{
+    memset(header, 0, sizeof(StateHeader));
+    memcpy(header->magic, STATE_MAGIC, sizeof(header->magic));
+    header->version = STATE_VERSION;
+    header->byteOrder = STATE_BYTE_ORDER;
+    header->numOfNodes = numOfNodes;
+    header->numOfLines = numOfLines;
+    header->hashesStart = alignedEnd(0, sizeof(StateHeader));
+    header->offsetsStart = alignedEnd(header->hashesStart, numOfLines * sizeof(uint64_t));
+    header->sonsStart = alignedEnd(header->offsetsStart,
+                                   ((size_t) numOfNodes + 1) * sizeof(int32_t));
+    header->fatherStart = alignedEnd(header->sonsStart, (numOfNodes - 1) * sizeof(int32_t));
+    header->summariesStart = alignedEnd(header->fatherStart, numOfNodes * sizeof(int32_t));
+    header->fileSize = alignedEnd(header->summariesStart, numOfNodes * sizeof(SubtreeSummary));
+}
+
+int checkStateHeader(const StateHeader *header, size_t fileSize)
+{
+    StateHeader expected;
+    if (memcmp(header->magic, STATE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != STATE_VERSION || header->byteOrder != STATE_BYTE_ORDER ||
+        header->headerChecksum != checksumBytes(0, header, offsetof(StateHeader, headerChecksum)) ||
+        header->updating != 0 || header->numOfNodes <= 0 || header->numOfNodes > INT_MAX ||
+        header->numOfLines <= header->numOfNodes || header->root < 0 ||
+        header->root >= header->numOfNodes)
+    {
+        return 0;
+    }
+    fillStateLayout(&expected, (int) header->numOfNodes, (long) header->numOfLines);
+    return header->hashesStart == expected.hashesStart &&
+           header->offsetsStart == expected.offsetsStart &&
+           header->sonsStart == expected.sonsStart &&
+           header->fatherStart == expected.fatherStart &&
+           header->summariesStart == expected.summariesStart &&
+           header->fileSize == expected.fileSize && header->fileSize == fileSize;
+}
+
+void openStateColumns(TreeState *state, char *base)
+{
+    StateHeader *header = (StateHeader *) base;
+    state->header = header;
+    state->numOfNodes = (int) header->numOfNodes;
+    state->hashes = (uint64_t *) (base + header->hashesStart);
+    state->sonsOffsets = (int32_t *) (base + header->offsetsStart);
+    state->sons = (int32_t *) (base + header->sonsStart);
+    state->father = (int32_t *) (base + header->fatherStart);
+    state->summaries = (SubtreeSummary *) (base + header->summariesStart);
+}
@@ -0,0 +1,213 @@
+/**
+* @file TreeLca.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief answering lowest common ancestor, distance and path queries on a tree without a BFS
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree and its root
+* Process: an iterative DFS writes the Euler tour of the tree - every node is written when it is
+* entered and again after each of its sons is done - along with the depth of every node and where
+* it first appears in the tour. the LCA of two nodes is the shallowest node in the tour between
+* their first appearances. the tour is cut into blocks of LCA_BLOCK_SIZE, and a sparse table over
+* the shallowest node of every block answers the whole blocks of a range in O(1), while the two
+* partial blocks at its ends are scanned. this keeps the table small even for huge trees.
+* Output : an LcaIndex to query
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LCA_BLOCK_SIZE 32
+
+/**
+ * @brief writes the Euler tour, the depths and the first appearances of all the nodes
+ */
+void buildEulerTour(const AllTree *mainTree, int root, LcaIndex *index);
+
+/**
+ * @brief builds the sparse table over the shallowest node of every block of the tour
+ */
+void buildBlockTable(LcaIndex *index);
+
+/**
+ * @brief the shallowest of two nodes, by the index depths
+ */
+int32_t shallower(const LcaIndex *index, int32_t first, int32_t second);
+
+/**
+ * @brief the shallowest node in the tour between two positions, both included, by scanning
+ */
+int32_t scanShallowest(const LcaIndex *index, long from, long to);
+
+LcaIndex *buildLcaIndex(const AllTree *mainTree, int root)
+{
+    LcaIndex *index = (LcaIndex *) checkedMalloc(sizeof(LcaIndex));
+    int n = mainTree->value;
+    index->numOfNodes = n;
+    index->father = mainTree->father;
+    index->tourLength = 2L * n - 1;
+    index->depth = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->firstInTour = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->tour = (int32_t *) checkedMalloc(index->tourLength * sizeof(int32_t));
+    buildEulerTour(mainTree, root, index);
+    buildBlockTable(index);
+    return index;
+}
+
+void buildEulerTour(const AllTree *mainTree, int root, LcaIndex *index)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int32_t *stack = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+    int32_t *nextSon = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+    long tourLength = 0;
+    int top = 0;
+    stack[top++] = root;
+    nextSon[root] = sonsOffsets[root];
+    index->depth[root] = 0;
+    index->firstInTour[root] = 0;
+    index->tour[tourLength++] = root;
+    while (top > 0)
+    {
+        int32_t cur = stack[top - 1];
+        if (nextSon[cur] < sonsOffsets[cur + 1]) // enter the next son
+        {
+            int32_t son = sons[nextSon[cur]++];
+            index->depth[son] = index->depth[cur] + 1;
+            index->firstInTour[son] = (int32_t) tourLength;
+            index->tour[tourLength++] = son;
+            nextSon[son] = sonsOffsets[son];
+            stack[top++] = son;
+        }
+        else // done with cur, back to its father
+        {
+            top--;
+            if (top > 0)
+            {
+                index->tour[tourLength++] = stack[top - 1];
+            }
+        }
+    }
+    free(stack);
+    free(nextSon);
+}
+
+void buildBlockTable(LcaIndex *index)
+{
+    long numOfBlocks = (index->tourLength + LCA_BLOCK_SIZE - 1) / LCA_BLOCK_SIZE;
+    int numOfLevels = 1;
+    while ((1L << numOfLevels) <= numOfBlocks)
+    {
+        numOfLevels++;
+    }
+    index->numOfBlocks = numOfBlocks;
+    index->numOfLevels = numOfLevels;
+    index->blockTable = (int32_t **) checkedMalloc(numOfLevels * sizeof(int32_t *));
+    index->blockTable[0] = (int32_t *) checkedMalloc(numOfBlocks * sizeof(int32_t));
+    for (long b = 0; b < numOfBlocks; b++)
+    {
+        long last = (b + 1) * LCA_BLOCK_SIZE - 1;
+        if (last >= index->tourLength)
+        {
+            last = index->tourLength - 1;
+        }
+        index->blockTable[0][b] = scanShallowest(index, b * LCA_BLOCK_SIZE, last);
+    }
+    for (int k = 1; k < numOfLevels; k++)
+    {
+        long size = numOfBlocks - (1L << k) + 1;
+        const int32_t *prev = index->blockTable[k - 1];
+        index->blockTable[k] = (int32_t *) checkedMalloc(size * sizeof(int32_t));
+        for (long b = 0; b < size; b++)
+        {
+            index->blockTable[k][b] = shallower(index, prev[b], prev[b + (1L << (k - 1))]);
+        }
+    }
+}
+
+int32_t shallower(const LcaIndex *index, int32_t first, int32_t second)
+{
+    return (index->depth[second] < index->depth[first]) ? second : first;
+}
+
+int32_t scanShallowest(const LcaIndex *index, long from, long to)
+{
+    int32_t best = index->tour[from];
+    for (long i = from + 1; i <= to; i++)
+    {
+        best = shallower(index, best, index->tour[i]);
+    }
+    return best;
+}
+
+int findLca(const LcaIndex *index, int u, int v)
+{
+    long from = index->firstInTour[u];
+    long to = index->firstInTour[v];
+    if (from > to)
+    {
+        long temp = from;
+        from = to;
+        to = temp;
+    }
+    long fromBlock = from / LCA_BLOCK_SIZE;
+    long toBlock = to / LCA_BLOCK_SIZE;
+    if (toBlock - fromBlock <= 1)
+    {
+        return scanShallowest(index, from, to);
+    }
+    int32_t best = scanShallowest(index, from, (fromBlock + 1) * LCA_BLOCK_SIZE - 1);
+    best = shallower(index, best, scanShallowest(index, toBlock * LCA_BLOCK_SIZE, to));
+    long firstBlock = fromBlock + 1;
+    long numOfBlocks = toBlock - firstBlock;
+    int k = 0;
+    while ((2L << k) <= numOfBlocks)
+    {
+        k++;
+    }
+    best = shallower(index, best, index->blockTable[k][firstBlock]);
+    return shallower(index, best, index->blockTable[k][toBlock - (1L << k)]);
+}
+
+int treeDistance(const LcaIndex *index, int u, int v)
+{
+    int lca = findLca(index, u, v);
+    return index->depth[u] + index->depth[v] - 2 * index->depth[lca];
+}
+
+int findPath(const LcaIndex *index, int u, int v, int32_t *path)
+{
+    int lca = findLca(index, u, v);
+    int upLength = index->depth[u] - index->depth[lca];
+    int length = upLength + index->depth[v] - index->depth[lca];
+    int i = 0;
+    for (int cur = u; cur != lca; cur = index->father[cur])
+    {
+        path[i++] = cur;
+    }
+    path[i] = lca;
+    i = length;
+    for (int cur = v; cur != lca; cur = index->father[cur])
+    {
+        path[i--] = cur;
+    }
+    return length + 1;
+}
+
+void freeLcaIndex(LcaIndex *index)
+{
+    for (int k = 0; k < index->numOfLevels; k++)
+    {
+        free(index->blockTable[k]);
+    }
+    free(index->blockTable);
+    free(index->tour);
+    free(index->firstInTour);
+    free(index->depth);
+    free(index);
+}
@@ -0,0 +1,246 @@
+/**
+* @file TreeLinkCut.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief a forest of rooted trees that changes while it is queried - subtrees are cut from their
+* fathers and linked under new ones - kept as link-cut trees
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, and the links, cuts and queries made on it afterwards
+* Process: every tree of the forest is split into preferred paths, each of them kept in a splay
+* tree ordered by depth - the nodes to the left of a node are its ancestors on the path. the root
+* of every splay tree points to the father of the top of its path, its path-parent. access(x)
+* makes the route from the root of the tree of x down to x a single preferred path, in the splay
+* tree x is the root of, so the size of the left subtree of x is then its depth. the LCA of two
+* nodes is where the access of the second one joins the route of the first. cut and link only
+* change the pointers around the node that moves. every operation is O(log n) amortized, and all
+* of them run without recursion, so deep trees are fine. even the queries rearrange the splay
+* trees, so the forest may not be used by two threads at once.
+* Output : a LinkCutTree to update and query
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief checks whether a node is the root of its splay tree - its parent, if any, is the
+ * path-parent of its path rather than its father in the splay tree
+ */
+int isSplayRoot(const LinkCutTree *forest, int32_t x);
+
+/**
+ * @brief computes the size of the splay subtree of a node from its children
+ */
+void updateSplaySize(LinkCutTree *forest, int32_t x);
+
+/**
+ * @brief rotates a node above its parent in the splay tree
+ */
+void rotateUp(LinkCutTree *forest, int32_t x);
+
+/**
+ * @brief rotates a node up to the root of its splay tree
+ */
+void splay(LinkCutTree *forest, int32_t x);
+
+/**
+ * @brief makes the route from the root of the tree of x down to x the preferred path, with x at
+ * the root of its splay tree and no node below it on the path
+ * @return - the last node whose path was joined on the way up - the LCA of x and the node
+ * accessed before, if they are in the same tree
+ */
+int32_t access(LinkCutTree *forest, int32_t x);
+
+LinkCutTree *buildLinkCutTree(const AllTree *mainTree)
+{
+    int n = mainTree->value;
+    LinkCutTree *forest = (LinkCutTree *) checkedMalloc(sizeof(LinkCutTree));
+    forest->numOfNodes = n;
+    forest->left = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    forest->right = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    forest->parent = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    forest->size = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    for (int i = 0; i < n; i++) // every node starts as a path of its own under its father
+    {
+        forest->left[i] = -1;
+        forest->right[i] = -1;
+        forest->parent[i] = mainTree->father[i];
+        forest->size[i] = 1;
+    }
+    return forest;
+}
+
+int linkCutRoot(LinkCutTree *forest, int x)
+{
+    access(forest, x);
+    int32_t root = x;
+    while (forest->left[root] != -1)
+    {
+        root = forest->left[root];
+    }
+    splay(forest, root); // keeps the next access of the route cheap
+    return root;
+}
+
+int linkCutDepth(LinkCutTree *forest, int x)
+{
+    access(forest, x);
+    return (forest->left[x] == -1) ? 0 : forest->size[forest->left[x]];
+}
+
+int linkCutLca(LinkCutTree *forest, int u, int v)
+{
+    if (u == v)
+    {
+        return u;
+    }
+    if (linkCutRoot(forest, u) != linkCutRoot(forest, v))
+    {
+        return -1;
+    }
+    access(forest, u);
+    return access(forest, v);
+}
+
+int linkCutDistance(LinkCutTree *forest, int u, int v)
+{
+    int lca = linkCutLca(forest, u, v);
+    if (lca == -1)
+    {
+        return -1;
+    }
+    return linkCutDepth(forest, u) + linkCutDepth(forest, v) - 2 * linkCutDepth(forest, lca);
+}
+
+int linkCutCut(LinkCutTree *forest, int x)
+{
+    access(forest, x);
+    int32_t ancestors = forest->left[x];
+    if (ancestors == -1) // x is a root
+    {
+        return 0;
+    }
+    forest->parent[ancestors] = -1;
+    forest->left[x] = -1;
+    updateSplaySize(forest, x);
+    return 1;
+}
+
+int linkCutLink(LinkCutTree *forest, int x, int y)
+{
+    access(forest, x);
+    if (forest->left[x] != -1 || linkCutRoot(forest, y) == x) // x has a father, or is above y
+    {
+        return 0;
+    }
+    access(forest, x); // x is alone in its splay tree, so it only needs a path-parent
+    forest->parent[x] = y;
+    return 1;
+}
+
+void freeLinkCutTree(LinkCutTree *forest)
+{
+    free(forest->left);
+    free(forest->right);
+    free(forest->parent);
+    free(forest->size);
+    free(forest);
+}
+
+/********************************************************************************
+*********************************************************************************
+*************               Splay Trees                  ************************
+*********************************************************************************
+********************************************************************************/
+
+int isSplayRoot(const LinkCutTree *forest, int32_t x)
+{
+    int32_t parent = forest->parent[x];
+    return parent == -1 || (forest->left[parent] != x && forest->right[parent] != x);
+}
+
+void updateSplaySize(LinkCutTree *forest, int32_t x)
+{
+    int32_t size = 1;
+    if (forest->left[x] != -1)
+    {
+        size += forest->size[forest->left[x]];
+    }
+    if (forest->right[x] != -1)
+    {
+        size += forest->size[forest->right[x]];
+    }
+    forest->size[x] = size;
+}
+
+void rotateUp(LinkCutTree *forest, int32_t x)
+{
+    int32_t parent = forest->parent[x];
+    int32_t grandparent = forest->parent[parent];
+    if (!isSplayRoot(forest, parent)) // otherwise x takes over the path-parent of its parent
+    {
+        if (forest->left[grandparent] == parent)
+        {
+            forest->left[grandparent] = x;
+        }
+        else
+        {
+            forest->right[grandparent] = x;
+        }
+    }
+    if (forest->left[parent] == x)
+    {
+        forest->left[parent] = forest->right[x];
+        if (forest->right[x] != -1)
+        {
+            forest->parent[forest->right[x]] = parent;
+        }
+        forest->right[x] = parent;
+    }
+    else
+    {
+        forest->right[parent] = forest->left[x];
+        if (forest->left[x] != -1)
+        {
+            forest->parent[forest->left[x]] = parent;
+        }
+        forest->left[x] = parent;
+    }
+    forest->parent[parent] = x;
+    forest->parent[x] = grandparent;
+    updateSplaySize(forest, parent);
+    updateSplaySize(forest, x);
+}
+
+void splay(LinkCutTree *forest, int32_t x)
+{
+    while (!isSplayRoot(forest, x))
+    {
+        int32_t parent = forest->parent[x];
+        if (!isSplayRoot(forest, parent))
+        {
+            int32_t grandparent = forest->parent[parent];
+            int zigZig = (forest->left[grandparent] == parent) == (forest->left[parent] == x);
+            rotateUp(forest, zigZig ? parent : x);
+        }
+        rotateUp(forest, x);
+    }
+}
+
+int32_t access(LinkCutTree *forest, int32_t x)
+{
+    int32_t last = -1;
+    for (int32_t y = x; y != -1; y = forest->parent[y])
+    {
+        splay(forest, y);
+        forest->right[y] = last; // the path below y is now the one leading to x
+        updateSplaySize(forest, y);
+        last = y;
+    }
+    splay(forest, x);
+    return last;
+}
@@ -0,0 +1,374 @@
+/**
+* @file TreeLoadGen.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief a load generator for the TreeAnalyzer server - a program of its own, with its own main
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : the socket of a running server, the number of vertices in its tree, and the load
+* Process: every connection is served by a thread of its own, which sends its requests in
+* windows of pipeline requests - a whole window is written at once, then all of its answers are
+* read. the latency of a request is the time from writing its window to reading its answer.
+* the vertices of every request are random.
+* Output : the throughput of the server, and the p50 / p99 / max latency of the requests
+*/
+#define _GNU_SOURCE // clock_gettime and the sockets of POSIX, before any system header
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define USAGE "Usage: TreeLoadGen <Socket Path> <Number Of Vertices> [--connections <N>] " \
+              "[--requests <N>] [--pipeline <N>] [--kind distance|path|subtree]\n"
+#define LOAD_BUFFER_SIZE (1 << 16)
+#define MAX_REQUEST_LENGTH 64
+
+/**
+ * @brief the load a single connection puts on the server, and what it measured:
+ * socketPath, numOfVertices, kind - where to connect, and what to ask
+ * numOfRequests - the number of requests to send
+ * pipeline - the number of requests sent before reading their answers
+ * seed - the seed of the random vertices
+ * latencies - out: the latency of every request, in nanoseconds
+ * numOfErrors - out: the number of answers starting with "error"
+ * failed - out: set if the connection failed
+ */
+typedef struct LoadConnection
+{
+    const char *socketPath;
+    int numOfVertices;
+    const char *kind;
+    int numOfRequests;
+    int pipeline;
+    unsigned int seed;
+    long long *latencies;
+    int numOfErrors;
+    int failed;
+} LoadConnection;
+
+/**
+ * @brief the routine of a connection thread
+ * @param arg - the LoadConnection
+ */
+void *runConnection(void *arg);
+
+/**
+ * @brief connects to the server
+ * @return - the socket, -1 on failure
+ */
+int connectToServer(const char *socketPath);
+
+/**
+ * @brief writes the whole buffer to the socket
+ * @return - 1 for success, 0 on failure
+ */
+int writeAll(int fd, const char *data, size_t length);
+
+/**
+ * @brief reads answers from the socket, until numOfAnswers whole lines were read
+ * @param buffer - holds the bytes read after the last of these answers, for the next call
+ * @param buffered - in/out: the number of such bytes
+ * @param answerTimes - out: the time every answer was read at
+ * @param numOfErrors - in/out: the number of answers starting with "error"
+ * @return - 1 for success, 0 if the connection was closed or failed
+ */
+int readAnswers(int fd, char *buffer, size_t *buffered, int numOfAnswers,
+                long long *answerTimes, int *numOfErrors);
+
+/**
+ * @brief the current monotonic time, in nanoseconds
+ */
+long long nowNanoseconds(void);
+
+/**
+ * @brief compares two latencies, for qsort
+ */
+int compareLatencies(const void *first, const void *second);
+
+/**
+ * @brief reads a positive number argument
+ * @return - the number, -1 if it isn't a positive number
+ */
+long parsePositive(const char *arg);
+
+int main(int argc, char *argv[])
+{
+    int numOfConnections = 4;
+    int numOfRequests = 100000;
+    int pipeline = 16;
+    const char *kind = "distance";
+    if (argc < 3 || argc % 2 == 0)
+    {
+        fprintf(stderr, USAGE);
+        return EXIT_FAILURE;
+    }
+    long numOfVertices = parsePositive(argv[2]);
+    for (int i = 3; i + 1 < argc && numOfVertices > 0; i += 2)
+    {
+        long number = parsePositive(argv[i + 1]);
+        if (strcmp(argv[i], "--connections") == 0 && number > 0 && number <= 1024)
+        {
+            numOfConnections = (int) number;
+        }
+        else if (strcmp(argv[i], "--requests") == 0 && number > 0)
+        {
+            numOfRequests = (int) number;
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0 && number > 0)
+        {
+            pipeline = (int) number;
+        }
+        else if (strcmp(argv[i], "--kind") == 0 &&
+                 (strcmp(argv[i + 1], "distance") == 0 || strcmp(argv[i + 1], "path") == 0 ||
+                  strcmp(argv[i + 1], "subtree") == 0))
+        {
+            kind = argv[i + 1];
+        }
+        else
+        {
+            numOfVertices = -1;
+        }
+    }
+    if (numOfVertices <= 0)
+    {
+        fprintf(stderr, USAGE);
+        return EXIT_FAILURE;
+    }
+
+    pthread_t *threads = (pthread_t *) malloc(numOfConnections * sizeof(pthread_t));
+    LoadConnection *connections = (LoadConnection *) malloc(numOfConnections *
+                                                            sizeof(LoadConnection));
+    long long *latencies = (long long *) malloc((size_t) numOfConnections * numOfRequests *
+                                                sizeof(long long));
+    if (threads == NULL || connections == NULL || latencies == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    long long start = nowNanoseconds();
+    for (int i = 0; i < numOfConnections; i++)
+    {
+        connections[i].socketPath = argv[1];
+        connections[i].numOfVertices = (int) numOfVertices;
+        connections[i].kind = kind;
+        connections[i].numOfRequests = numOfRequests;
+        connections[i].pipeline = pipeline;
+        connections[i].seed = (unsigned int) (start + i);
+        connections[i].latencies = latencies + (size_t) i * numOfRequests;
+        connections[i].numOfErrors = 0;
+        connections[i].failed = 0;
+        if (pthread_create(&threads[i], NULL, runConnection, &connections[i]) != 0)
+        {
+            fprintf(stderr, "Thread creation failed\n");
+            return EXIT_FAILURE;
+        }
+    }
+    int numOfErrors = 0;
+    int numOfFailed = 0;
+    for (int i = 0; i < numOfConnections; i++)
+    {
+        pthread_join(threads[i], NULL);
+        numOfErrors += connections[i].numOfErrors;
+        numOfFailed += connections[i].failed;
+    }
+    double seconds = (double) (nowNanoseconds() - start) / 1e9;
+    if (numOfFailed > 0)
+    {
+        fprintf(stderr, "%d of the connections failed\n", numOfFailed);
+        return EXIT_FAILURE;
+    }
+
+    size_t total = (size_t) numOfConnections * numOfRequests;
+    qsort(latencies, total, sizeof(long long), compareLatencies);
+    printf("Requests: %zu (%s, %d connections, pipeline %d)\n", total, kind, numOfConnections,
+           pipeline);
+    printf("Error Answers: %d\n", numOfErrors);
+    printf("Throughput: %.0f requests/s\n", (double) total / seconds);
+    printf("Latency p50: %.1f us\n", (double) latencies[total / 2] / 1e3);
+    printf("Latency p99: %.1f us\n", (double) latencies[(total * 99) / 100] / 1e3);
+    printf("Latency max: %.1f us\n", (double) latencies[total - 1] / 1e3);
+    free(threads);
+    free(connections);
+    free(latencies);
+    return EXIT_SUCCESS;
+}
+
+void *runConnection(void *arg)
+{
+    LoadConnection *connection = (LoadConnection *) arg;
+    char *requests = (char *) malloc((size_t) connection->pipeline * MAX_REQUEST_LENGTH);
+    char *answers = (char *) malloc(LOAD_BUFFER_SIZE);
+    long long *answerTimes = (long long *) malloc(connection->pipeline * sizeof(long long));
+    int fd = connectToServer(connection->socketPath);
+    if (requests == NULL || answers == NULL || answerTimes == NULL || fd < 0)
+    {
+        connection->failed = 1;
+    }
+    size_t buffered = 0;
+    for (int sent = 0; !connection->failed && sent < connection->numOfRequests;)
+    {
+        int windowSize = connection->numOfRequests - sent;
+        if (windowSize > connection->pipeline)
+        {
+            windowSize = connection->pipeline;
+        }
+        size_t length = 0;
+        for (int i = 0; i < windowSize; i++)
+        {
+            int u = (int) (rand_r(&connection->seed) % connection->numOfVertices);
+            int v = (int) (rand_r(&connection->seed) % connection->numOfVertices);
+            if (strcmp(connection->kind, "subtree") == 0)
+            {
+                length += (size_t) snprintf(requests + length, MAX_REQUEST_LENGTH,
+                                            "subtree %d\n", u);
+            }
+            else
+            {
+                length += (size_t) snprintf(requests + length, MAX_REQUEST_LENGTH,
+                                            "%s %d %d\n", connection->kind, u, v);
+            }
+        }
+        long long windowStart = nowNanoseconds();
+        if (writeAll(fd, requests, length) == 0 ||
+            readAnswers(fd, answers, &buffered, windowSize, answerTimes,
+                        &connection->numOfErrors) == 0)
+        {
+            connection->failed = 1;
+            break;
+        }
+        for (int i = 0; i < windowSize; i++)
+        {
+            connection->latencies[sent + i] = answerTimes[i] - windowStart;
+        }
+        sent += windowSize;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    free(requests);
+    free(answers);
+    free(answerTimes);
+    return NULL;
+}
+
+int connectToServer(const char *socketPath)
+{
+    struct sockaddr_un address;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int writeAll(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t numOfBytes = write(fd, data, length);
+        if (numOfBytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numOfBytes <= 0)
+        {
+            return 0;
+        }
+        data += numOfBytes;
+        length -= (size_t) numOfBytes;
+    }
+    return 1;
+}
+
+int readAnswers(int fd, char *buffer, size_t *buffered, int numOfAnswers,
+                long long *answerTimes, int *numOfErrors)
+{
+    int numOfRead = 0;
+    int atLineStart = 1; // the buffer never holds more than a part of a single answer
+    while (numOfRead < numOfAnswers)
+    {
+        ssize_t numOfBytes = read(fd, buffer + *buffered, LOAD_BUFFER_SIZE - *buffered);
+        if (numOfBytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numOfBytes <= 0)
+        {
+            return 0;
+        }
+        long long now = nowNanoseconds();
+        size_t end = *buffered + (size_t) numOfBytes;
+        size_t lineStart = 0;
+        for (size_t i = *buffered; i < end && numOfRead < numOfAnswers; i++)
+        {
+            if (buffer[i] == '\n')
+            {
+                if (atLineStart && strncmp(buffer + lineStart, "error", 5) == 0)
+                {
+                    (*numOfErrors)++;
+                }
+                answerTimes[numOfRead++] = now;
+                lineStart = i + 1;
+                atLineStart = 1;
+            }
+        }
+        if (lineStart == 0 && end == LOAD_BUFFER_SIZE) // a long path - keep only its end
+        {
+            buffer[0] = buffer[end - 1];
+            lineStart = end - 1;
+            atLineStart = 0;
+        }
+        *buffered = end - lineStart;
+        memmove(buffer, buffer + lineStart, *buffered);
+    }
+    return 1;
+}
+
+long long nowNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+int compareLatencies(const void *first, const void *second)
+{
+    long long a = *(const long long *) first;
+    long long b = *(const long long *) second;
+    return (a > b) - (a < b);
+}
+
+long parsePositive(const char *arg)
+{
+    char *end;
+    long number = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || number <= 0 || number > 1000000000L)
+    {
+        return -1;
+    }
+    return number;
+}
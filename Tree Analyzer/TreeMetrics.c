@@ -0,0 +1,120 @@
+/**
+* @file TreeMetrics.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief computing the depth and diameter stats of a tree in a single pass
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree and its root
+* Process: the nodes are put in BFS order from the root, which gives the depth of every node and
+* so the minimal and maximal branch. then the nodes are visited in reverse order - every node
+* after all of its sons - and the height of every node is computed from the heights of its sons.
+* the longest route in the tree passes through the node where the two highest sons add up to
+* the most. the order array stands in for the recursion stack, so deep trees are fine.
+* the stats are computed once by a macro specialized for the int32_t columns of AllTree and the
+* uint32_t and uint64_t columns of WideTree.
+* Output : the TreeMetrics of the tree, or the StreamedMetrics of a WideTree
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief defines the computation of the stats of a tree whose ids and offsets are of a given type
+ * @param name - the name of the computation
+ * @param Id - the type of the ids and the offsets
+ */
+#define DEFINE_ANALYZE_COLUMNS(name, Id) \
+void name(const Id *sonsOffsets, const Id *sons, Id n, Id root, StreamedMetrics *metrics) \
+{ \
+    Id *order = (Id *) checkedMalloc((size_t) n * sizeof(Id)); \
+    Id *height = (Id *) checkedMalloc((size_t) n * sizeof(Id)); /* the depth, until 2nd pass */ \
+    Id *deepest = (Id *) checkedMalloc((size_t) n * sizeof(Id)); \
+    Id minBranch = n; \
+    Id maxBranch = 0; \
+    Id numOfOrdered = 1; \
+    order[0] = root; \
+    height[root] = 0; \
+    for (Id i = 0; i < numOfOrdered; i++) \
+    { \
+        Id cur = order[i]; \
+        Id depth = height[cur]; \
+        if (sonsOffsets[cur] == sonsOffsets[cur + 1]) /* a leaf */ \
+        { \
+            minBranch = (depth < minBranch) ? depth : minBranch; \
+            maxBranch = (depth > maxBranch) ? depth : maxBranch; \
+        } \
+        for (Id j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++) \
+        { \
+            height[sons[j]] = depth + 1; \
+            order[numOfOrdered++] = sons[j]; \
+        } \
+    } \
+    Id diameter = 0; \
+    Id diameterStart = root; \
+    Id diameterEnd = root; \
+    for (Id i = n; i-- > 0;) \
+    { \
+        Id cur = order[i]; \
+        Id highest = 0; \
+        Id secondHighest = 0; \
+        Id highestEnd = cur; \
+        Id secondHighestEnd = cur; \
+        for (Id j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++) \
+        { \
+            Id son = sons[j]; \
+            Id sonHeight = height[son] + 1; \
+            if (sonHeight > highest) \
+            { \
+                secondHighest = highest; \
+                secondHighestEnd = highestEnd; \
+                highest = sonHeight; \
+                highestEnd = deepest[son]; \
+            } \
+            else if (sonHeight > secondHighest) \
+            { \
+                secondHighest = sonHeight; \
+                secondHighestEnd = deepest[son]; \
+            } \
+        } \
+        height[cur] = highest; \
+        deepest[cur] = highestEnd; \
+        if (highest + secondHighest > diameter) \
+        { \
+            diameter = highest + secondHighest; \
+            diameterStart = highestEnd; \
+            diameterEnd = secondHighestEnd; \
+        } \
+    } \
+    metrics->root = (long long) root; \
+    metrics->minBranch = (long long) minBranch; \
+    metrics->maxBranch = (long long) maxBranch; \
+    metrics->diameter = (long long) diameter; \
+    metrics->diameterStart = (long long) diameterStart; \
+    metrics->diameterEnd = (long long) diameterEnd; \
+    free(order); \
+    free(height); \
+    free(deepest); \
+}
+
+DEFINE_ANALYZE_COLUMNS(analyzeColumns, int32_t)
+
+DEFINE_ANALYZE_COLUMNS(analyzeColumns32, uint32_t)
+
+DEFINE_ANALYZE_COLUMNS(analyzeColumns64, uint64_t)
+
+void analyzeTree(const AllTree *mainTree, int root, TreeMetrics *metrics)
+{
+    StreamedMetrics columnsMetrics;
+    analyzeColumns(mainTree->sonsOffsets, mainTree->sons, mainTree->value, root, &columnsMetrics);
+    metrics->root = (int) columnsMetrics.root;
+    metrics->minBranch = (int) columnsMetrics.minBranch;
+    metrics->maxBranch = (int) columnsMetrics.maxBranch;
+    metrics->diameter = (int) columnsMetrics.diameter;
+    metrics->diameterStart = (int) columnsMetrics.diameterStart;
+    metrics->diameterEnd = (int) columnsMetrics.diameterEnd;
+}
@@ -0,0 +1,152 @@
+/**
+* @file TreeOutput.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief writing large amounts of output - paths, answers and a result per vertex - through a
+* single large buffer
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : text, numbers and raw bytes to write to a file descriptor
+* Process: everything is copied into a buffer, which is written with a single write call once it
+* is full, instead of going through stdio formatting for every number. a number is converted into
+* text from its last digits to its first, two digits at a time from a table of all the pairs of
+* digits, straight into the buffer. blocks of raw bytes larger than the buffer are written as
+* they are, without being copied. once a write fails, nothing else is written.
+* Output : the bytes appended, on the file descriptor
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define MAX_NUMBER_LENGTH 20 // the digits and the sign of a long long
+
+static const char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+/**
+ * @brief writes a block of bytes to the file descriptor of the output, and marks the output as
+ * failed if it can't be written
+ */
+void writeOutputBytes(OutputBuffer *out, const char *data, size_t length);
+
+OutputBuffer *openOutputBuffer(int fd, size_t capacity)
+{
+    OutputBuffer *out = (OutputBuffer *) checkedMalloc(sizeof(OutputBuffer));
+    out->fd = fd;
+    out->data = (char *) checkedMalloc(capacity);
+    out->capacity = capacity;
+    out->length = 0;
+    out->failed = 0;
+    return out;
+}
+
+void appendOutput(OutputBuffer *out, const char *text)
+{
+    appendBytes(out, text, strlen(text));
+}
+
+void appendChar(OutputBuffer *out, char c)
+{
+    if (out->length == out->capacity)
+    {
+        flushOutput(out);
+    }
+    out->data[out->length++] = c;
+}
+
+void appendNumber(OutputBuffer *out, long long number)
+{
+    if (out->capacity - out->length < MAX_NUMBER_LENGTH)
+    {
+        flushOutput(out);
+    }
+    // the magnitude is taken as unsigned, so the smallest long long doesn't overflow
+    unsigned long long magnitude = (number < 0) ? 0ULL - (unsigned long long) number :
+                                   (unsigned long long) number;
+    int numOfDigits = 1;
+    for (unsigned long long rest = magnitude; rest >= 10; rest /= 10)
+    {
+        numOfDigits++;
+    }
+    char *p = out->data + out->length;
+    if (number < 0)
+    {
+        *p++ = '-';
+    }
+    char *end = p + numOfDigits;
+    out->length = (size_t) (end - out->data);
+    while (magnitude >= 100)
+    {
+        const char *pair = digitPairs + 2 * (magnitude % 100);
+        magnitude /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (magnitude >= 10)
+    {
+        *--end = digitPairs[2 * magnitude + 1];
+        *--end = digitPairs[2 * magnitude];
+    }
+    else
+    {
+        *--end = (char) ('0' + magnitude);
+    }
+}
+
+void appendBytes(OutputBuffer *out, const void *data, size_t length)
+{
+    if (out->length + length > out->capacity)
+    {
+        flushOutput(out);
+        if (length > out->capacity)
+        {
+            writeOutputBytes(out, (const char *) data, length);
+            return;
+        }
+    }
+    memcpy(out->data + out->length, data, length);
+    out->length += length;
+}
+
+int flushOutput(OutputBuffer *out)
+{
+    writeOutputBytes(out, out->data, out->length);
+    out->length = 0;
+    return !out->failed;
+}
+
+int closeOutputBuffer(OutputBuffer *out)
+{
+    int written = flushOutput(out);
+    free(out->data);
+    free(out);
+    return written;
+}
+
+void writeOutputBytes(OutputBuffer *out, const char *data, size_t length)
+{
+    size_t written = 0;
+    while (!out->failed && written < length)
+    {
+        ssize_t numOfBytes = write(out->fd, data + written, length - written);
+        if (numOfBytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numOfBytes <= 0)
+        {
+            out->failed = 1;
+            break;
+        }
+        written += (size_t) numOfBytes;
+    }
+}
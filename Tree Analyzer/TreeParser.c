@@ -0,0 +1,969 @@
+/**
+* @file TreeParser.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief reading a graph file into the tree structure of the TreeAnalyzer
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a file with a structure of a graph - the number of nodes n in the first line, and then
+* n lines, line i holding the sons of node i separated by spaces, or "-" if it has none.
+* Process: the file is mapped into memory. small files are scanned once - every line is checked
+* and its node is built right away, without copying the line anywhere. large files are split into
+* chunks at line boundaries that are parsed by several threads - the first pass counts the lines
+* and sons of every chunk, a prefix sum gives every chunk its first node and first son, and the
+* second pass writes the sons of every chunk straight into the tree.
+* The parsed graph is then checked to be a tree by validateTree.
+* Output : the tree, or NULL and the first error in the file if it is invalid
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_PARSE_THREADS 64
+#define MIN_BYTES_PER_THREAD (1 << 20)
+#define MIN_BYTES_FOR_BUFFERS (1 << 24)
+#define INITIAL_LINES_CAPACITY 1024
+#define INITIAL_FEED_CAPACITY (1 << 16)
+
+/**
+ * @brief a part of the file, starting and ending at a line boundary, parsed by one thread:
+ * begin, end - the bytes of the chunk
+ * numOfNodesInTree - the number of nodes, as read from the first line
+ * mainTree - the tree the chunk is written into, NULL in the first pass
+ * lineCodes - the number of sons in every line of the chunk, or LINE_INVALID / LINE_BLANK
+ * numOfLines, linesCapacity - the number of lines in the chunk, and the room in lineCodes
+ * firstLine - the index of the first line of the chunk among the lines following the first line,
+ * which is also the node of that line
+ * numOfSons - the number of sons in the chunk
+ * firstSon - the offset in mainTree->sons of the first son of the chunk
+ * error - the first error in the chunk, line 0 if none
+ */
+typedef struct ParseChunk
+{
+    const char *begin;
+    const char *end;
+    int numOfNodesInTree;
+    AllTree *mainTree;
+    int32_t *lineCodes;
+    long numOfLines;
+    long linesCapacity;
+    long firstLine;
+    long long numOfSons;
+    long long firstSon;
+    ParseError error;
+} ParseChunk;
+
+/**
+ * @brief builds the tree out of the content of a graph file, in a single pass
+ * @param scanner - positioned after the first line
+ * @param numOfNodesInTree - the number of nodes, as read from the first line
+ * @param error - out: the first error in the file, if any
+ * @return - the tree, NULL if the content is invalid
+ */
+AllTree *buildTree(Scanner *scanner, int numOfNodesInTree, ParseError *error);
+
+/**
+ * @brief builds the tree out of the content of a graph file using several threads
+ * @param scanner - positioned after the first line
+ * @param numOfNodesInTree - the number of nodes, as read from the first line
+ * @param numOfThreads - the number of threads to parse with
+ * @param error - out: the first error in the file, if any
+ * @return - the tree, NULL if the content is invalid
+ */
+AllTree *buildTreeInChunks(Scanner *scanner, int numOfNodesInTree, int numOfThreads,
+                           ParseError *error);
+
+/**
+ * @brief the first pass over a chunk - finds the code of every line in it. a thread routine.
+ * @param arg - the ParseChunk
+ */
+void *scanChunkLines(void *arg);
+
+/**
+ * @brief the second pass over a chunk - checks every line against its place in the file and
+ * writes the sons of the nodes of the chunk into the tree. a thread routine.
+ * @param arg - the ParseChunk
+ */
+void *fillChunkSons(void *arg);
+
+/**
+ * @brief instead of the second pass, when the file has too few lines for a tree - finds the first
+ * invalid or empty line of a chunk, without allocating the tree
+ */
+void findBadLine(ParseChunk *chunk);
+
+/**
+ * @brief runs a routine on all the chunks, a thread for each
+ */
+void runOnChunks(ParseChunk *chunks, int numOfChunks, void *(*routine)(void *));
+
+/**
+ * @brief reads the first line of the file - the number of nodes in the tree. it has to be a
+ * positive number, written only with digits.
+ * @param scanner - the scanner, positioned at the start of the file. advanced past the line.
+ * @return - the number of nodes, 0 if the line is invalid, and -1 if it is a number too large
+ * for the nodes to be kept in memory
+ */
+int scanNumOfNodes(Scanner *scanner);
+
+/**
+ * @brief defines the reader of the sons in the line of a node, for sons of a given type. the
+ * number being read is below the number of nodes before every digit, so it never overflows.
+ * @param name - the name of the function
+ * @param Id - the type of the sons
+ */
+#define DEFINE_SCAN_SONS(name, Id) \
+long long name(const char *p, const char *contentEnd, long long numOfNodesInTree, Id *sons, \
+               long long room) \
+{ \
+    long long numOfSons = 0; \
+    if (contentEnd - p == 1 && *p == NOSONS) /* if the line has only '-' it is valid */ \
+    { \
+        return 0; \
+    } \
+    while (p < contentEnd) \
+    { \
+        if (*p == DELIMITER) \
+        { \
+            p++; \
+            continue; \
+        } \
+        long long son = 0; \
+        for (; p < contentEnd && *p != DELIMITER; p++) \
+        { \
+            if (*p < '0' || *p > '9') \
+            { \
+                return LINE_INVALID; \
+            } \
+            son = son * 10 + (*p - '0'); \
+            if (son >= numOfNodesInTree) \
+            { \
+                return LINE_INVALID; \
+            } \
+        } \
+        if (numOfSons < room) \
+        { \
+            sons[numOfSons] = (Id) son; \
+        } \
+        numOfSons++; \
+    } \
+    if (numOfSons == 0) /* an empty line */ \
+    { \
+        return LINE_BLANK; \
+    } \
+    return numOfSons; \
+}
+
+/**
+ * @brief allocates the tree of a line feed, once the number of its nodes is known. only a first
+ * few nodes and sons get room, so a number of nodes far beyond the lines that follow it doesn't
+ * allocate memory for all of them.
+ */
+void startFeedTree(LineFeed *feed, int numOfNodesInTree);
+
+/**
+ * @brief feeds the content of a line after the first one - the line of the next node, or a line
+ * after the last node, which may only be blank
+ * @param p - the first char of the line
+ * @param contentEnd - one past the last char of the content of the line
+ */
+void feedNodeLine(LineFeed *feed, const char *p, const char *contentEnd, ParseError *error);
+
+/**
+ * @brief makes sure the tree being built has room for at least the given number of sons.
+ * exits if memory allocation fails.
+ */
+void growSons(LineFeed *feed, long long required);
+
+/**
+ * @brief doubles the room for the offsets of the sons of the nodes of the tree being built, up to
+ * all its nodes. exits if memory allocation fails.
+ */
+void growNodes(LineFeed *feed);
+
+/**
+ * @brief allocates a tree with room for the offsets of the sons of the given number of nodes,
+ * without the arrays of the fathers, the distances and the paths
+ * @param n - the number of nodes in the graph
+ * @param nodesCapacity - the number of nodes to allocate offsets for, at most n
+ * @param sonsCapacity - the number of sons to allocate room for
+ */
+AllTree *allocTree(int n, int nodesCapacity, int sonsCapacity);
+
+/**
+ * @brief allocates and initializes the fathers, the distances and the paths of all the nodes of a
+ * tree allocated by allocTree
+ */
+void initNodes(AllTree *mainTree);
+
+/**
+ * @brief reads the weight in a line of a weights file
+ * @param weight - out: the weight
+ * @return - 1 if the line is a valid weight, 0 otherwise
+ */
+int scanWeight(const char *p, const char *contentEnd, long long *weight);
+
+/**
+ * @brief records an error, if error isn't NULL
+ * @param line - the line of the error in the file, starting from 1
+ */
+void setParseError(ParseError *error, long line, const char *message);
+
+/********************************************************************************
+*********************************************************************************
+*************        Mapping & Scanning the File         ************************
+*********************************************************************************
+********************************************************************************/
+
+int mapFile(const char *fileName, MappedFile *file)
+{
+    struct stat fileStat;
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return 0;
+    }
+    void *data = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return 0;
+    }
+    madvise(data, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+    file->data = (const char *) data;
+    file->size = (size_t) fileStat.st_size;
+    return 1;
+}
+
+void unmapFile(MappedFile *file)
+{
+    if (file->data != NULL)
+    {
+        munmap((void *) file->data, file->size);
+    }
+    file->data = NULL;
+    file->size = 0;
+}
+
+AllTree *parseTreeFile(const char *fileName, int numOfThreads, ParseError *error)
+{
+    AllTree *mainTree = readGraphFile(fileName, numOfThreads, error);
+    if (mainTree != NULL && validateTree(mainTree, error) == 0)
+    {
+        freeTree(mainTree);
+        mainTree = NULL;
+    }
+    return mainTree;
+}
+
+AllTree *readGraphFile(const char *fileName, int numOfThreads, ParseError *error)
+{
+    MappedFile file;
+    setParseError(error, 0, "");
+    if (mapFile(fileName, &file) == 0)
+    {
+        setParseError(error, 0, ERROR_EMPTY_FILE);
+        return NULL;
+    }
+    int format = compressionOf(file.data, file.size);
+    if (format != COMPRESSION_NONE ||
+        (numOfThreads <= 1 && file.size >= MIN_BYTES_FOR_BUFFERS))
+    {
+        // a large file parsed by a single thread is read ahead by another one, so the parser
+        // doesn't stall on page faults while the disk reads the pages it maps
+        unmapFile(&file);
+        return readGraphFileInBuffers(fileName, format, error);
+    }
+    Scanner scanner = {file.data, file.data + file.size};
+    AllTree *mainTree = NULL;
+    int numOfNodesInTree = scanNumOfNodes(&scanner);
+    if (numOfNodesInTree <= 0)
+    {
+        setParseError(error, 1, (numOfNodesInTree < 0) ? ERROR_TOO_MANY_NODES : ERROR_NUM_OF_NODES);
+    }
+    else
+    {
+        long long maxThreads = (scanner.end - scanner.cur) / MIN_BYTES_PER_THREAD;
+        if (numOfThreads > maxThreads)
+        {
+            numOfThreads = (int) maxThreads;
+        }
+        if (numOfThreads > MAX_PARSE_THREADS)
+        {
+            numOfThreads = MAX_PARSE_THREADS;
+        }
+        if (numOfThreads > 1)
+        {
+            mainTree = buildTreeInChunks(&scanner, numOfNodesInTree, numOfThreads, error);
+        }
+        else
+        {
+            mainTree = buildTree(&scanner, numOfNodesInTree, error);
+        }
+    }
+    unmapFile(&file);
+    return mainTree;
+}
+
+AllTree *buildTree(Scanner *scanner, int numOfNodesInTree, ParseError *error)
+{
+    LineFeed feed;
+    startLineFeed(&feed);
+    feed.line = 2;
+    startFeedTree(&feed, numOfNodesInTree);
+    while (scanner->cur < scanner->end && !feed.failed)
+    {
+        const char *next;
+        const char *contentEnd = lineContentEnd(scanner, &next);
+        feedNodeLine(&feed, scanner->cur, contentEnd, error);
+        scanner->cur = next;
+    }
+    return finishLineFeed(&feed, error);
+}
+
+/********************************************************************************
+*********************************************************************************
+*************          Feeding Lines One by One           ***********************
+*********************************************************************************
+********************************************************************************/
+
+void startLineFeed(LineFeed *feed)
+{
+    feed->mainTree = NULL;
+    feed->sonsCapacity = 0;
+    feed->nodesCapacity = 0;
+    feed->numOfNodesInTree = 0;
+    feed->numOfNodes = 0;
+    feed->line = 1;
+    feed->failed = 0;
+}
+
+void startFeedTree(LineFeed *feed, int numOfNodesInTree)
+{
+    feed->numOfNodesInTree = numOfNodesInTree;
+    feed->nodesCapacity = (numOfNodesInTree < INITIAL_FEED_CAPACITY) ? numOfNodesInTree :
+                          INITIAL_FEED_CAPACITY;
+    feed->sonsCapacity = (numOfNodesInTree > 1) ? numOfNodesInTree - 1 : 1; // a tree's edges
+    if (feed->sonsCapacity > INITIAL_FEED_CAPACITY)
+    {
+        feed->sonsCapacity = INITIAL_FEED_CAPACITY;
+    }
+    feed->mainTree = allocTree(numOfNodesInTree, feed->nodesCapacity, feed->sonsCapacity);
+}
+
+void feedGraphLine(LineFeed *feed, const char *p, const char *lineEnd, ParseError *error)
+{
+    if (feed->failed)
+    {
+        return;
+    }
+    const char *contentEnd = (const char *) memchr(p, '\r', (size_t) (lineEnd - p));
+    if (contentEnd == NULL)
+    {
+        contentEnd = lineEnd;
+    }
+    if (feed->mainTree != NULL)
+    {
+        feedNodeLine(feed, p, contentEnd, error);
+        return;
+    }
+    Scanner scanner = {p, contentEnd};
+    int numOfNodesInTree = scanNumOfNodes(&scanner);
+    if (numOfNodesInTree <= 0)
+    {
+        setParseError(error, 1, (numOfNodesInTree < 0) ? ERROR_TOO_MANY_NODES : ERROR_NUM_OF_NODES);
+        feed->failed = 1;
+        return;
+    }
+    feed->line = 2;
+    startFeedTree(feed, numOfNodesInTree);
+}
+
+long long scanGraphLine(const char *p, const char *lineEnd, int numOfNodesInTree, int32_t *sons,
+                        long long room)
+{
+    const char *contentEnd = (const char *) memchr(p, '\r', (size_t) (lineEnd - p));
+    return scanSons(p, (contentEnd == NULL) ? lineEnd : contentEnd, numOfNodesInTree, sons, room);
+}
+
+void feedNodeLine(LineFeed *feed, const char *p, const char *contentEnd, ParseError *error)
+{
+    AllTree *mainTree = feed->mainTree;
+    int numOfNodesInTree = feed->numOfNodesInTree;
+    if (feed->numOfNodes == numOfNodesInTree) // only blank lines may follow the lines of the nodes
+    {
+        if (scanSons(p, contentEnd, numOfNodesInTree, NULL, 0) != LINE_BLANK)
+        {
+            setParseError(error, feed->line, ERROR_EXTRA_CONTENT);
+            feed->failed = 1;
+        }
+        feed->line++;
+        return;
+    }
+    int i = feed->numOfNodes;
+    int32_t first = mainTree->sonsOffsets[i];
+    long long room = feed->sonsCapacity - first;
+    long long numOfSons = scanSons(p, contentEnd, numOfNodesInTree, &mainTree->sons[first], room);
+    if (numOfSons > room) // the sons didn't fit, make room and write them again
+    {
+        if (first + numOfSons > INT32_MAX)
+        {
+            setParseError(error, feed->line, ERROR_TOO_MANY_SONS);
+            feed->failed = 1;
+            return;
+        }
+        growSons(feed, first + numOfSons);
+        scanSons(p, contentEnd, numOfNodesInTree, &mainTree->sons[first], numOfSons);
+    }
+    if (numOfSons < 0)
+    {
+        setParseError(error, feed->line, (numOfSons == LINE_BLANK) ? ERROR_EMPTY_LINE :
+                                         ERROR_INVALID_LINE);
+        feed->failed = 1;
+        return;
+    }
+    if (i == feed->nodesCapacity)
+    {
+        growNodes(feed);
+    }
+    mainTree->sonsOffsets[i + 1] = (int32_t) (first + numOfSons);
+    feed->numOfNodes++;
+    feed->line++;
+}
+
+AllTree *finishLineFeed(LineFeed *feed, ParseError *error)
+{
+    if (!feed->failed && feed->mainTree == NULL)
+    {
+        setParseError(error, 0, ERROR_EMPTY_FILE);
+        feed->failed = 1;
+    }
+    else if (!feed->failed && feed->numOfNodes < feed->numOfNodesInTree) // less lines than nodes
+    {
+        setParseError(error, feed->line, ERROR_MISSING_LINES);
+        feed->failed = 1;
+    }
+    if (feed->failed)
+    {
+        if (feed->mainTree != NULL)
+        {
+            freeTree(feed->mainTree);
+        }
+        feed->mainTree = NULL;
+    }
+    else
+    {
+        initNodes(feed->mainTree);
+    }
+    return feed->mainTree;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************            Parsing in Chunks               ************************
+*********************************************************************************
+********************************************************************************/
+
+AllTree *buildTreeInChunks(Scanner *scanner, int numOfNodesInTree, int numOfThreads,
+                           ParseError *error)
+{
+    ParseChunk chunks[MAX_PARSE_THREADS];
+    size_t chunkSize = (size_t) (scanner->end - scanner->cur) / numOfThreads;
+    const char *begin = scanner->cur;
+    for (int i = 0; i < numOfThreads; i++) // every chunk ends right after a line break
+    {
+        const char *end = scanner->end;
+        if (i < numOfThreads - 1)
+        {
+            end = scanner->cur + chunkSize * (i + 1);
+            if (end < begin)
+            {
+                end = begin;
+            }
+            const char *lineEnd = (const char *) memchr(end, '\n', (size_t) (scanner->end - end));
+            end = (lineEnd == NULL) ? scanner->end : lineEnd + 1;
+        }
+        memset(&chunks[i], 0, sizeof(ParseChunk));
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        chunks[i].numOfNodesInTree = numOfNodesInTree;
+        begin = end;
+    }
+    runOnChunks(chunks, numOfThreads, scanChunkLines);
+
+    long numOfLines = 0;
+    long long numOfSons = 0;
+    for (int i = 0; i < numOfThreads; i++)
+    {
+        chunks[i].firstLine = numOfLines;
+        chunks[i].firstSon = numOfSons;
+        numOfLines += chunks[i].numOfLines;
+        numOfSons += chunks[i].numOfSons;
+    }
+    AllTree *mainTree = NULL;
+    if (numOfSons <= INT32_MAX && numOfLines >= numOfNodesInTree)
+    {
+        mainTree = initTree(numOfNodesInTree, (numOfSons > 0) ? (int) numOfSons : 1);
+        for (int i = 0; i < numOfThreads; i++)
+        {
+            chunks[i].mainTree = mainTree;
+        }
+        runOnChunks(chunks, numOfThreads, fillChunkSons);
+    }
+    else if (numOfSons <= INT32_MAX) // too few lines for a tree, only a bad line comes before that
+    {
+        for (int i = 0; i < numOfThreads; i++)
+        {
+            findBadLine(&chunks[i]);
+        }
+    }
+
+    ParseError firstError = {0, ""};
+    for (int i = 0; i < numOfThreads; i++) // the first error in the file, whatever the chunks
+    {
+        if (firstError.line == 0 && chunks[i].error.line != 0)
+        {
+            firstError = chunks[i].error;
+        }
+        free(chunks[i].lineCodes);
+    }
+    if (firstError.line == 0 && numOfSons > INT32_MAX)
+    {
+        setParseError(&firstError, 1, ERROR_TOO_MANY_SONS);
+    }
+    if (firstError.line == 0 && numOfLines < numOfNodesInTree)
+    {
+        setParseError(&firstError, numOfLines + 2, ERROR_MISSING_LINES);
+    }
+    if (firstError.line != 0)
+    {
+        setParseError(error, firstError.line, firstError.message);
+        if (mainTree != NULL)
+        {
+            freeTree(mainTree);
+        }
+        return NULL;
+    }
+    return mainTree;
+}
+
+void runOnChunks(ParseChunk *chunks, int numOfChunks, void *(*routine)(void *))
+{
+    pthread_t threads[MAX_PARSE_THREADS];
+    for (int i = 1; i < numOfChunks; i++)
+    {
+        if (pthread_create(&threads[i], NULL, routine, &chunks[i]) != 0)
+        {
+            fprintf(stderr, "Thread creation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    routine(&chunks[0]);
+    for (int i = 1; i < numOfChunks; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+void *scanChunkLines(void *arg)
+{
+    ParseChunk *chunk = (ParseChunk *) arg;
+    Scanner scanner = {chunk->begin, chunk->end};
+    chunk->linesCapacity = INITIAL_LINES_CAPACITY;
+    chunk->lineCodes = (int32_t *) checkedMalloc(chunk->linesCapacity * sizeof(int32_t));
+    while (scanner.cur < scanner.end)
+    {
+        const char *next;
+        const char *contentEnd = lineContentEnd(&scanner, &next);
+        long long code = scanSons(scanner.cur, contentEnd, chunk->numOfNodesInTree, NULL, 0);
+        if (chunk->numOfLines == chunk->linesCapacity)
+        {
+            chunk->linesCapacity *= 2;
+            chunk->lineCodes = (int32_t *) checkedRealloc(chunk->lineCodes,
+                                                          chunk->linesCapacity * sizeof(int32_t));
+        }
+        if (code > INT32_MAX)
+        {
+            code = LINE_INVALID;
+        }
+        chunk->lineCodes[chunk->numOfLines] = (int32_t) code;
+        chunk->numOfLines++;
+        if (code > 0)
+        {
+            chunk->numOfSons += code;
+        }
+        scanner.cur = next;
+    }
+    return NULL;
+}
+
+void findBadLine(ParseChunk *chunk)
+{
+    for (long j = 0; j < chunk->numOfLines; j++)
+    {
+        int32_t code = chunk->lineCodes[j];
+        if (code < 0)
+        {
+            setParseError(&chunk->error, chunk->firstLine + j + 2,
+                          (code == LINE_BLANK) ? ERROR_EMPTY_LINE : ERROR_INVALID_LINE);
+            return;
+        }
+    }
+}
+
+void *fillChunkSons(void *arg)
+{
+    ParseChunk *chunk = (ParseChunk *) arg;
+    AllTree *mainTree = chunk->mainTree;
+    Scanner scanner = {chunk->begin, chunk->end};
+    int32_t offset = (int32_t) chunk->firstSon;
+    for (long j = 0; j < chunk->numOfLines; j++)
+    {
+        const char *next;
+        const char *contentEnd = lineContentEnd(&scanner, &next);
+        long node = chunk->firstLine + j;
+        int32_t code = chunk->lineCodes[j];
+        const char *message = NULL;
+        if (node >= mainTree->value)
+        {
+            message = (code == LINE_BLANK) ? NULL : ERROR_EXTRA_CONTENT;
+        }
+        else if (code < 0)
+        {
+            message = (code == LINE_BLANK) ? ERROR_EMPTY_LINE : ERROR_INVALID_LINE;
+        }
+        else
+        {
+            scanSons(scanner.cur, contentEnd, mainTree->value, &mainTree->sons[offset], code);
+            offset += code;
+            mainTree->sonsOffsets[node + 1] = offset;
+        }
+        if (message != NULL)
+        {
+            setParseError(&chunk->error, node + 2, message);
+            break;
+        }
+        scanner.cur = next;
+    }
+    return NULL;
+}
+
+long long *parseWeightsFile(const char *fileName, int numOfNodesInTree, ParseError *error)
+{
+    MappedFile file;
+    setParseError(error, 0, "");
+    if (mapFile(fileName, &file) == 0)
+    {
+        setParseError(error, 0, "the weights file can't be opened, or is empty");
+        return NULL;
+    }
+    Scanner scanner = {file.data, file.data + file.size};
+    long long *weights = (long long *) checkedMalloc(numOfNodesInTree * sizeof(long long));
+    long line = 1;
+    for (int i = 0; i < numOfNodesInTree; i++, line++)
+    {
+        const char *next;
+        if (scanner.cur == scanner.end)
+        {
+            setParseError(error, line, ERROR_MISSING_LINES);
+            free(weights);
+            weights = NULL;
+            break;
+        }
+        const char *contentEnd = lineContentEnd(&scanner, &next);
+        if (scanWeight(scanner.cur, contentEnd, &weights[i]) == 0)
+        {
+            setParseError(error, line, (scanner.cur == contentEnd) ? ERROR_EMPTY_LINE :
+                                       ERROR_INVALID_WEIGHT);
+            free(weights);
+            weights = NULL;
+            break;
+        }
+        scanner.cur = next;
+    }
+    // only blank lines may follow the lines of the nodes
+    for (; weights != NULL && scanner.cur < scanner.end; line++)
+    {
+        const char *next;
+        const char *contentEnd = lineContentEnd(&scanner, &next);
+        if (scanSons(scanner.cur, contentEnd, numOfNodesInTree, NULL, 0) != LINE_BLANK)
+        {
+            setParseError(error, line, ERROR_EXTRA_CONTENT);
+            free(weights);
+            weights = NULL;
+        }
+        scanner.cur = next;
+    }
+    unmapFile(&file);
+    return weights;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************              Scanning Lines                ************************
+*********************************************************************************
+********************************************************************************/
+
+const char *lineContentEnd(const Scanner *scanner, const char **next)
+{
+    size_t left = (size_t) (scanner->end - scanner->cur);
+    const char *lineEnd = (const char *) memchr(scanner->cur, '\n', left);
+    if (lineEnd == NULL)
+    {
+        lineEnd = scanner->end;
+        *next = scanner->end;
+    }
+    else
+    {
+        *next = lineEnd + 1;
+    }
+    const char *contentEnd = (const char *) memchr(scanner->cur, '\r',
+                                                   (size_t) (lineEnd - scanner->cur));
+    return (contentEnd == NULL) ? lineEnd : contentEnd;
+}
+
+int scanNumOfNodes(Scanner *scanner)
+{
+    const char *next;
+    const char *contentEnd = lineContentEnd(scanner, &next);
+    const char *p = scanner->cur;
+    long long num = 0;
+    if (p == contentEnd)
+    {
+        return 0;
+    }
+    for (; p < contentEnd; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return 0;
+        }
+        if (num <= INT_MAX) // past it the digits are only checked
+        {
+            num = num * 10 + (*p - '0');
+        }
+    }
+    if (num > INT_MAX)
+    {
+        return -1;
+    }
+    scanner->cur = next;
+    return (int) num;
+}
+
+DEFINE_SCAN_SONS(scanSons, int32_t)
+
+DEFINE_SCAN_SONS(scanSons32, uint32_t)
+
+DEFINE_SCAN_SONS(scanSons64, uint64_t)
+
+int scanWeight(const char *p, const char *contentEnd, long long *weight)
+{
+    int negative = (p < contentEnd && *p == '-');
+    long long num = 0;
+    if (negative)
+    {
+        p++;
+    }
+    if (p == contentEnd)
+    {
+        return 0;
+    }
+    for (; p < contentEnd; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return 0;
+        }
+        num = num * 10 + (*p - '0');
+        if (num > (long long) INT32_MAX + negative)
+        {
+            return 0;
+        }
+    }
+    *weight = negative ? -num : num;
+    return 1;
+}
+
+void setParseError(ParseError *error, long line, const char *message)
+{
+    if (error != NULL)
+    {
+        error->line = line;
+        snprintf(error->message, PARSE_ERROR_LENGTH, "%s", message);
+    }
+}
+
+/********************************************************************************
+*********************************************************************************
+*************        Parsing & Initializing Tree         ************************
+*********************************************************************************
+********************************************************************************/
+
+AllTree *initTree(int n, int sonsCapacity)
+{
+    AllTree *mainTree = allocTree(n, n, sonsCapacity);
+    memset(mainTree->sonsOffsets, 0, ((size_t) n + 1) * sizeof(int32_t));
+    initNodes(mainTree);
+    return mainTree;
+}
+
+AllTree *allocTree(int n, int nodesCapacity, int sonsCapacity)
+{
+    AllTree *mainTree = (AllTree *) checkedMalloc(sizeof(AllTree));
+    mainTree->value = n;
+    mainTree->cache.data = NULL;
+    mainTree->cache.size = 0;
+    mainTree->originalLabel = NULL;
+    mainTree->internalLabel = NULL;
+    mainTree->sonsOffsets = (int32_t *) checkedMalloc(((size_t) nodesCapacity + 1) *
+                                                      sizeof(int32_t));
+    mainTree->sonsOffsets[0] = 0;
+    mainTree->sons = (int32_t *) checkedMalloc((size_t) sonsCapacity * sizeof(int32_t));
+    mainTree->father = NULL;
+    mainTree->distance = NULL;
+    mainTree->previousInPath = NULL;
+    return mainTree;
+}
+
+void initNodes(AllTree *mainTree)
+{
+    size_t n = (size_t) mainTree->value;
+    mainTree->father = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    mainTree->distance = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    mainTree->previousInPath = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    for (size_t i = 0; i < n; i++)
+    {
+        mainTree->father[i] = -1;
+        mainTree->previousInPath[i] = -1;
+    }
+}
+
+int findRoot(AllTree *mainTree)
+{
+    for (int i = 0; i < mainTree->value; i++)
+    {
+        if (mainTree->father[i] == -1)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void growSons(LineFeed *feed, long long required)
+{
+    long long capacity = 2LL * feed->sonsCapacity;
+    if (capacity < required)
+    {
+        capacity = required;
+    }
+    if (capacity > INT32_MAX)
+    {
+        capacity = INT32_MAX;
+    }
+    feed->mainTree->sons = (int32_t *) checkedRealloc(feed->mainTree->sons,
+                                                      (size_t) capacity * sizeof(int32_t));
+    feed->sonsCapacity = (int) capacity;
+}
+
+void growNodes(LineFeed *feed)
+{
+    long long capacity = 2LL * feed->nodesCapacity;
+    if (capacity > feed->numOfNodesInTree)
+    {
+        capacity = feed->numOfNodesInTree;
+    }
+    feed->mainTree->sonsOffsets = (int32_t *) checkedRealloc(feed->mainTree->sonsOffsets,
+                                                             ((size_t) capacity + 1) *
+                                                             sizeof(int32_t));
+    feed->nodesCapacity = (int) capacity;
+}
+
+/********************************************************************************
+*********************************************************************************
+**************            Freeing Space             *****************************
+*********************************************************************************
+********************************************************************************/
+void freeTree(AllTree *mainTree)
+{
+    if (mainTree->cache.data != NULL)
+    {
+        unmapFile(&mainTree->cache);
+    }
+    else
+    {
+        free(mainTree->sonsOffsets);
+        free(mainTree->sons);
+        free(mainTree->father);
+    }
+    free(mainTree->originalLabel);
+    free(mainTree->internalLabel);
+    free(mainTree->distance);
+    free(mainTree->previousInPath);
+    free(mainTree);
+}
+
+void *checkedMalloc(size_t size)
+{
+    void *memory = malloc(size);
+    if (memory == NULL && size != 0)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    countAllocation(size);
+    return memory;
+}
+
+void *checkedRealloc(void *memory, size_t size)
+{
+    void *grown = realloc(memory, size);
+    if (grown == NULL && size != 0)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    countAllocation(size);
+    return grown;
+}
+
+void *checkedCalloc(size_t numOfItems, size_t size)
+{
+    void *memory = calloc(numOfItems, size);
+    if (memory == NULL && numOfItems != 0 && size != 0)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    countAllocation(numOfItems * size);
+    return memory;
+}
+
+void *checkedAlignedAlloc(size_t alignment, size_t size)
+{
+    void *memory = NULL;
+    if (posix_memalign(&memory, alignment, size) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    countAllocation(size);
+    return memory;
+}
@@ -0,0 +1,524 @@
+/**
+* @file TreeReader.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief reading a graph file a buffer at a time on a thread of its own, while it is parsed -
+* large files, and files compressed with gzip or zstd
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph file - plain, compressed with gzip (built with HAVE_ZLIB, linked with -lz) or
+* compressed with zstd (built with HAVE_ZSTD, linked with -lzstd)
+* Process: a reading thread reads the file into a ring of a few large buffers, and the calling
+* thread parses every buffer as soon as it is full, so the disk and the parser work at the same
+* time instead of taking turns. a plain file is read with pread in blocks at aligned offsets, into
+* page aligned buffers. a compressed file is decompressed by the reading thread, so decompressing
+* overlaps parsing as well. the reading thread waits when all the buffers are full, and the parser
+* waits when all of them are empty, so the memory used is fixed whatever the size of the file.
+* the lines are fed to a LineFeed - the same grammar and errors as a mapped file - in place in
+* the buffers. only a line split between two buffers is copied, to join its two parts. the parser
+* stops the reading as soon as it finds an error.
+* Output : the graph, or NULL and the first error in the file if it is invalid
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define RING_BUFFER_SIZE (1 << 22)
+#define NUM_OF_RING_BUFFERS 4
+#define GZIP_INTERNAL_BUFFER_SIZE (1 << 18)
+#define BUFFER_ALIGNMENT 4096
+
+/**
+ * @brief the ring of buffers between the reading thread and the parser:
+ * source - the file read, used only by the reading thread
+ * buffers, lengths - the buffers, and the number of bytes in every full buffer
+ * first - the oldest full buffer
+ * numOfFull - the number of full buffers, first and those after it
+ * done - set when the reading thread filled its last buffer
+ * failed - set if the file can't be read, or isn't valid in its format
+ * stopped - set by the parser when it needs no more buffers
+ * lock, changed - guard the fields above and signal their changes
+ */
+typedef struct BufferRing
+{
+    struct BlockSource *source;
+    char *buffers[NUM_OF_RING_BUFFERS];
+    size_t lengths[NUM_OF_RING_BUFFERS];
+    int first;
+    int numOfFull;
+    int done;
+    int failed;
+    int stopped;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} BufferRing;
+
+/**
+ * @brief an open graph file:
+ * format - one of the COMPRESSION_ constants
+ * fd - the file, for a plain or zstd file
+ * offset - the offset of the next block of a plain file
+ * gzip - the gzip stream
+ * zstd - the zstd stream, input - what was read from the file and not decompressed yet,
+ * lastResult - the last hint of the stream, 0 once a frame is done and all of it was written out,
+ * endOfFile - set once the file was read to its end
+ */
+typedef struct BlockSource
+{
+    int format;
+    int fd;
+    off_t offset;
+#ifdef HAVE_ZLIB
+    gzFile gzip;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx *zstd;
+    ZSTD_inBuffer input;
+    size_t lastResult;
+    int endOfFile;
+#endif
+} BlockSource;
+
+/**
+ * @brief the routine of the reading thread - fills the buffers of the ring until the file
+ * ends, fails, or the parser stops
+ * @param arg - the BufferRing
+ */
+void *fillBuffers(void *arg);
+
+/**
+ * @brief waits for a full buffer, for the parser
+ * @param length - out: the number of bytes in the buffer
+ * @return - the oldest full buffer, NULL if the file ended
+ */
+char *takeFullBuffer(BufferRing *ring, size_t *length);
+
+/**
+ * @brief hands the oldest full buffer back to the reading thread
+ */
+void releaseBuffer(BufferRing *ring);
+
+/**
+ * @brief opens the graph file
+ * @return - 1 for success, 0 if the file can't be opened, -1 if the format isn't built in
+ */
+int openBlockSource(BlockSource *source, const char *fileName, int format);
+
+/**
+ * @brief reads the next bytes of the file, decompressed
+ * @return - the number of bytes written into the buffer, less than its size only at the end of
+ * the file. -1 if the file can't be read or isn't valid.
+ */
+long readBlock(BlockSource *source, char *buffer, size_t size);
+
+/**
+ * @brief closes the graph file
+ */
+void closeBlockSource(BlockSource *source);
+
+/**
+ * @brief appends bytes to the line split between two buffers
+ */
+void appendToSplitLine(char **line, size_t *length, size_t *capacity, const char *p, size_t size);
+
+/**
+ * @brief records an error which isn't in a single line, if error isn't NULL
+ */
+void setReaderError(ParseError *error, const char *message);
+
+int compressionOf(const char *data, size_t size)
+{
+    if (size >= 2 && (unsigned char) data[0] == 0x1f && (unsigned char) data[1] == 0x8b)
+    {
+        return COMPRESSION_GZIP;
+    }
+    if (size >= 4 && (unsigned char) data[0] == 0x28 && (unsigned char) data[1] == 0xb5 &&
+        (unsigned char) data[2] == 0x2f && (unsigned char) data[3] == 0xfd)
+    {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+AllTree *readGraphFileInBuffers(const char *fileName, int format, ParseError *error)
+{
+    BlockSource source;
+    int opened = openBlockSource(&source, fileName, format);
+    if (opened != 1)
+    {
+        if (opened == 0)
+        {
+            setReaderError(error, ERROR_EMPTY_FILE);
+        }
+        else
+        {
+            setReaderError(error, (format == COMPRESSION_GZIP) ?
+                                      "the file is compressed with gzip, which this build can't "
+                                      "read" :
+                                      "the file is compressed with zstd, which this build can't "
+                                      "read");
+        }
+        return NULL;
+    }
+    BufferRing ring;
+    ring.source = &source;
+    for (int i = 0; i < NUM_OF_RING_BUFFERS; i++)
+    {
+        ring.buffers[i] = (char *) checkedAlignedAlloc(BUFFER_ALIGNMENT, RING_BUFFER_SIZE);
+    }
+    ring.first = 0;
+    ring.numOfFull = 0;
+    ring.done = 0;
+    ring.failed = 0;
+    ring.stopped = 0;
+    pthread_mutex_init(&ring.lock, NULL);
+    pthread_cond_init(&ring.changed, NULL);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, fillBuffers, &ring) != 0)
+    {
+        fprintf(stderr, "Thread creation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    LineFeed feed;
+    startLineFeed(&feed);
+    char *splitLine = NULL;
+    size_t splitLength = 0;
+    size_t splitCapacity = 0;
+    int inSplitLine = 0; // the last buffer ended in the middle of a line
+    size_t length;
+    char *buffer;
+    while (!feed.failed && (buffer = takeFullBuffer(&ring, &length)) != NULL)
+    {
+        const char *p = buffer;
+        const char *end = buffer + length;
+        while (p < end && !feed.failed)
+        {
+            const char *lineEnd = (const char *) memchr(p, '\n', (size_t) (end - p));
+            if (lineEnd == NULL) // the line goes on in the next buffer
+            {
+                appendToSplitLine(&splitLine, &splitLength, &splitCapacity, p, end - p);
+                inSplitLine = 1;
+                break;
+            }
+            if (inSplitLine)
+            {
+                appendToSplitLine(&splitLine, &splitLength, &splitCapacity, p, lineEnd - p);
+                feedGraphLine(&feed, splitLine, splitLine + splitLength, error);
+                splitLength = 0;
+                inSplitLine = 0;
+            }
+            else
+            {
+                feedGraphLine(&feed, p, lineEnd, error);
+            }
+            p = lineEnd + 1;
+        }
+        releaseBuffer(&ring);
+    }
+    pthread_mutex_lock(&ring.lock);
+    ring.stopped = 1;
+    pthread_cond_broadcast(&ring.changed);
+    pthread_mutex_unlock(&ring.lock);
+    pthread_join(thread, NULL);
+    if (ring.failed && !feed.failed)
+    {
+        setReaderError(error, (format == COMPRESSION_NONE) ? "the file can't be read" :
+                              "the compressed file is corrupt or can't be read");
+        feed.failed = 1;
+    }
+    if (inSplitLine) // the last line, without a line break
+    {
+        feedGraphLine(&feed, splitLine, splitLine + splitLength, error);
+    }
+    AllTree *mainTree = finishLineFeed(&feed, error);
+    closeBlockSource(&source);
+    pthread_mutex_destroy(&ring.lock);
+    pthread_cond_destroy(&ring.changed);
+    for (int i = 0; i < NUM_OF_RING_BUFFERS; i++)
+    {
+        free(ring.buffers[i]);
+    }
+    free(splitLine);
+    return mainTree;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************             The Ring of Buffers             ***********************
+*********************************************************************************
+********************************************************************************/
+
+void *fillBuffers(void *arg)
+{
+    BufferRing *ring = (BufferRing *) arg;
+    int failed = 0;
+    while (1)
+    {
+        pthread_mutex_lock(&ring->lock);
+        while (ring->numOfFull == NUM_OF_RING_BUFFERS && !ring->stopped)
+        {
+            pthread_cond_wait(&ring->changed, &ring->lock);
+        }
+        int stopped = ring->stopped;
+        int next = (ring->first + ring->numOfFull) % NUM_OF_RING_BUFFERS;
+        pthread_mutex_unlock(&ring->lock);
+        if (stopped)
+        {
+            break;
+        }
+        // the buffer is empty, so the parser doesn't touch it until it is handed over
+        long length = readBlock(ring->source, ring->buffers[next], RING_BUFFER_SIZE);
+        if (length < 0)
+        {
+            failed = 1;
+            break;
+        }
+        pthread_mutex_lock(&ring->lock);
+        if (length > 0)
+        {
+            ring->lengths[next] = (size_t) length;
+            ring->numOfFull++;
+        }
+        pthread_cond_broadcast(&ring->changed);
+        pthread_mutex_unlock(&ring->lock);
+        if (length < RING_BUFFER_SIZE) // the end of the file
+        {
+            break;
+        }
+    }
+    pthread_mutex_lock(&ring->lock);
+    ring->done = 1;
+    ring->failed = failed;
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+    return NULL;
+}
+
+char *takeFullBuffer(BufferRing *ring, size_t *length)
+{
+    pthread_mutex_lock(&ring->lock);
+    while (ring->numOfFull == 0 && !ring->done)
+    {
+        pthread_cond_wait(&ring->changed, &ring->lock);
+    }
+    char *buffer = NULL;
+    if (ring->numOfFull > 0 && !ring->failed)
+    {
+        buffer = ring->buffers[ring->first];
+        *length = ring->lengths[ring->first];
+    }
+    pthread_mutex_unlock(&ring->lock);
+    return buffer;
+}
+
+void releaseBuffer(BufferRing *ring)
+{
+    pthread_mutex_lock(&ring->lock);
+    ring->first = (ring->first + 1) % NUM_OF_RING_BUFFERS;
+    ring->numOfFull--;
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+void appendToSplitLine(char **line, size_t *length, size_t *capacity, const char *p, size_t size)
+{
+    if (*length + size > *capacity)
+    {
+        *capacity = 2 * (*length + size);
+        *line = (char *) checkedRealloc(*line, *capacity);
+    }
+    memcpy(*line + *length, p, size);
+    *length += size;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************              The BlockSources              ***********************
+*********************************************************************************
+********************************************************************************/
+
+int openBlockSource(BlockSource *source, const char *fileName, int format)
+{
+    source->format = format;
+    source->fd = -1;
+    source->offset = 0;
+    if (format == COMPRESSION_NONE)
+    {
+        source->fd = open(fileName, O_RDONLY);
+        if (source->fd < 0)
+        {
+            return 0;
+        }
+        posix_fadvise(source->fd, 0, 0, POSIX_FADV_SEQUENTIAL); // a larger readahead
+        return 1;
+    }
+#ifdef HAVE_ZLIB
+    if (format == COMPRESSION_GZIP)
+    {
+        source->gzip = gzopen(fileName, "rb");
+        if (source->gzip == NULL)
+        {
+            return 0;
+        }
+        gzbuffer(source->gzip, GZIP_INTERNAL_BUFFER_SIZE);
+        return 1;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (format == COMPRESSION_ZSTD)
+    {
+        source->fd = open(fileName, O_RDONLY);
+        if (source->fd < 0)
+        {
+            return 0;
+        }
+        source->zstd = ZSTD_createDCtx();
+        if (source->zstd == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        size_t inputSize = ZSTD_DStreamInSize();
+        source->input.src = checkedMalloc(inputSize);
+        source->input.size = 0;
+        source->input.pos = 0;
+        source->lastResult = 0;
+        source->endOfFile = 0;
+        return 1;
+    }
+#endif
+    (void) fileName;
+    return -1;
+}
+
+long readBlock(BlockSource *source, char *buffer, size_t size)
+{
+    if (source->format == COMPRESSION_NONE)
+    {
+        size_t filled = 0;
+        while (filled < size)
+        {
+            ssize_t numOfRead = pread(source->fd, buffer + filled, size - filled,
+                                      source->offset + (off_t) filled);
+            if (numOfRead < 0)
+            {
+                return -1;
+            }
+            if (numOfRead == 0)
+            {
+                break;
+            }
+            filled += (size_t) numOfRead;
+        }
+        source->offset += (off_t) filled;
+        return (long) filled;
+    }
+#ifdef HAVE_ZLIB
+    if (source->format == COMPRESSION_GZIP)
+    {
+        size_t filled = 0;
+        while (filled < size)
+        {
+            int numOfRead = gzread(source->gzip, buffer + filled,
+                                   (unsigned int) (size - filled));
+            if (numOfRead < 0)
+            {
+                return -1;
+            }
+            if (numOfRead == 0)
+            {
+                int code;
+                gzerror(source->gzip, &code);
+                return (code == Z_OK) ? (long) filled : -1; // a cut file is an error
+            }
+            filled += (size_t) numOfRead;
+        }
+        return (long) filled;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (source->format == COMPRESSION_ZSTD)
+    {
+        ZSTD_outBuffer output = {buffer, size, 0};
+        while (output.pos < size)
+        {
+            ZSTD_inBuffer *input = &source->input;
+            if (input->pos == input->size && !source->endOfFile)
+            {
+                ssize_t numOfRead = read(source->fd, (void *) input->src,
+                                         ZSTD_DStreamInSize());
+                if (numOfRead < 0)
+                {
+                    return -1;
+                }
+                source->endOfFile = (numOfRead == 0);
+                input->size = (size_t) numOfRead;
+                input->pos = 0;
+            }
+            int inputEnded = (input->pos == input->size && source->endOfFile);
+            if (inputEnded && source->lastResult == 0) // the last frame is done
+            {
+                break;
+            }
+            size_t before = output.pos;
+            size_t result = ZSTD_decompressStream(source->zstd, &output, input);
+            if (ZSTD_isError(result))
+            {
+                return -1;
+            }
+            source->lastResult = result;
+            if (inputEnded && output.pos == before) // a frame isn't complete - the file was cut
+            {
+                return -1;
+            }
+        }
+        return (long) output.pos;
+    }
+#endif
+    return -1;
+}
+
+void closeBlockSource(BlockSource *source)
+{
+#ifdef HAVE_ZLIB
+    if (source->format == COMPRESSION_GZIP)
+    {
+        gzclose(source->gzip);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (source->format == COMPRESSION_ZSTD)
+    {
+        ZSTD_freeDCtx(source->zstd);
+        free((void *) source->input.src);
+    }
+#endif
+    if (source->fd >= 0)
+    {
+        close(source->fd);
+    }
+}
+
+void setReaderError(ParseError *error, const char *message)
+{
+    if (error != NULL)
+    {
+        error->line = 0;
+        snprintf(error->message, PARSE_ERROR_LENGTH, "%s", message);
+    }
+}
@@ -0,0 +1,151 @@
+/**
+* @file TreeRelabel.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief renumbering the nodes of a tree in traversal order, for the traversals to read memory in
+* order
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, its root and the order to number the nodes in
+* Process: the numbers in the graph file are arbitrary, so the sons and the father of a node are
+* anywhere in the columns, and a traversal misses the cache at almost every step. the nodes are
+* numbered in BFS order or DFS preorder from the root instead, and the columns are rebuilt in the
+* new numbering - in BFS order the sons of every node are consecutive numbers, and a BFS reads the
+* columns from start to end. in DFS preorder every subtree is a range of numbers. the two ways
+* between the numbers are kept in the tree, so every vertex read from the user is translated in,
+* and every node written out is translated back.
+* Output : the relabeled tree
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief writes the nodes in the order they are numbered in
+ * @param order - out: the n nodes of the tree
+ */
+void findLabelOrder(const AllTree *mainTree, int root, int relabelOrder, int32_t *order);
+
+void relabelTree(AllTree *mainTree, int root, int order)
+{
+    int n = mainTree->value;
+    int32_t *originalLabel = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *internalLabel = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    findLabelOrder(mainTree, root, order, originalLabel);
+    for (int i = 0; i < n; i++)
+    {
+        internalLabel[originalLabel[i]] = i;
+    }
+
+    int32_t *sonsOffsets = (int32_t *) checkedMalloc(((size_t) n + 1) * sizeof(int32_t));
+    int32_t *sons = (int32_t *) checkedMalloc((n > 0 ? n - 1 : 0) * sizeof(int32_t));
+    int32_t *father = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t numOfSons = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int32_t old = originalLabel[i];
+        sonsOffsets[i] = numOfSons;
+        for (int32_t j = mainTree->sonsOffsets[old]; j < mainTree->sonsOffsets[old + 1]; j++)
+        {
+            sons[numOfSons++] = internalLabel[mainTree->sons[j]];
+        }
+        father[i] = (mainTree->father[old] == -1) ? -1 : internalLabel[mainTree->father[old]];
+    }
+    sonsOffsets[n] = numOfSons;
+
+    if (mainTree->cache.data != NULL) // the columns were mapped from the snapshot
+    {
+        unmapFile(&mainTree->cache);
+        mainTree->cache.data = NULL;
+    }
+    else
+    {
+        free(mainTree->sonsOffsets);
+        free(mainTree->sons);
+        free(mainTree->father);
+    }
+    // distance and previousInPath hold nothing until a BFS writes them, so they stay as they are
+    mainTree->sonsOffsets = sonsOffsets;
+    mainTree->sons = sons;
+    mainTree->father = father;
+    mainTree->originalLabel = originalLabel;
+    mainTree->internalLabel = internalLabel;
+}
+
+void findLabelOrder(const AllTree *mainTree, int root, int relabelOrder, int32_t *order)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int numOfOrdered = 1;
+    order[0] = root;
+    if (relabelOrder == RELABEL_BFS)
+    {
+        for (int i = 0; i < numOfOrdered; i++)
+        {
+            int32_t cur = order[i];
+            for (int32_t j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++)
+            {
+                order[numOfOrdered++] = sons[j];
+            }
+        }
+        return;
+    }
+    int32_t *stack = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+    int top = 0;
+    for (int32_t j = sonsOffsets[root + 1] - 1; j >= sonsOffsets[root]; j--)
+    {
+        stack[top++] = sons[j];
+    }
+    while (top > 0)
+    {
+        int32_t cur = stack[--top];
+        order[numOfOrdered++] = cur;
+        for (int32_t j = sonsOffsets[cur + 1] - 1; j >= sonsOffsets[cur]; j--) // first son on top
+        {
+            stack[top++] = sons[j];
+        }
+    }
+    free(stack);
+}
+
+void toInternalOrder(const AllTree *mainTree, long long *values)
+{
+    if (mainTree->originalLabel == NULL)
+    {
+        return;
+    }
+    int n = mainTree->value;
+    long long *original = (long long *) checkedMalloc(n * sizeof(long long));
+    for (int i = 0; i < n; i++)
+    {
+        original[i] = values[i];
+    }
+    for (int i = 0; i < n; i++)
+    {
+        values[i] = original[mainTree->originalLabel[i]];
+    }
+    free(original);
+}
+
+void toOriginalOrder(const AllTree *mainTree, int32_t *values)
+{
+    if (mainTree->originalLabel == NULL)
+    {
+        return;
+    }
+    int n = mainTree->value;
+    int32_t *internal = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    for (int i = 0; i < n; i++)
+    {
+        internal[i] = values[i];
+    }
+    for (int i = 0; i < n; i++)
+    {
+        values[i] = internal[mainTree->internalLabel[i]];
+    }
+    free(internal);
+}
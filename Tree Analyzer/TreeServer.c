@@ -0,0 +1,706 @@
+/**
+* @file TreeServer.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief keeping a parsed tree in memory and answering queries on it over a local socket
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree, and requests over a UNIX-domain socket (or the standard input). every
+* request is a single line:
+*   distance <u> <v>  - the length of the shortest path between u and v
+*   path <u> <v>      - the length of the path, a colon, and the vertices along it
+*   diameter          - the length of the longest route, and its two ends
+*   subtree <x>       - the number of vertices in the subtree of x, x included
+*   depth <x>         - the distance of x from the root
+*   ancestor <x> <y>  - 1 if x is an ancestor of y (or y itself), 0 otherwise
+*   stats             - the root, the number of vertices and the min / max branch
+*   quit              - closes the connection
+* in the dynamic mode the tree may change between requests, and becomes a forest once a subtree
+* is cut. the requests are then:
+*   link <x> <y>      - makes y the father of x, which has to be the root of its tree - "ok"
+*   cut <x>           - cuts x and its subtree from its father - "ok"
+*   connected <u> <v> - 1 if u and v are in the same tree, 0 otherwise
+*   root <x>          - the root of the tree of x
+*   depth <x>         - the distance of x from the root of its tree
+*   distance <u> <v>  - the length of the path between u and v, in the same tree
+*   ancestor <x> <y>  - 1 if x is an ancestor of y (or y itself), 0 otherwise
+*   quit              - closes the connection
+* a request with more tokens than it takes is answered with the error of its invalid arguments.
+* Process: the LCA index, the stats and the subtree index are computed once at startup. a fixed
+* pool of worker threads takes accepted connections from a bounded queue. a client may send many
+* requests without waiting for the answers - they are read in large blocks, answered in order
+* into an output buffer, and the buffer is flushed whenever the server runs out of whole requests
+* to answer, so pipelined requests cost one write for many answers. in the dynamic mode the tree
+* is kept as link-cut trees instead, so every request is O(log n) amortized. even their queries
+* change them, so the requests of all the connections take turns on a lock.
+* Output : a line per request, "error <reason>" for invalid requests
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define CONNECTION_QUEUE_CAPACITY 256
+#define SERVER_BUFFER_SIZE (1 << 16)
+#define MAX_REQUEST_LENGTH 4096
+#define LISTEN_BACKLOG 128
+#define FULL_QUEUE_WAIT_NS 10000000L
+
+/**
+ * @brief everything the workers answer from, computed once and only read afterwards:
+ * mainTree - the tree
+ * index - the LCA index of the tree, NULL in the dynamic mode
+ * metrics - the stats of the tree
+ * subtrees - the subtree index of the tree, NULL in the dynamic mode
+ * forest - the link-cut trees of the dynamic mode, NULL otherwise
+ * forestLock - taken around every request on the forest
+ */
+typedef struct ServerState
+{
+    const AllTree *mainTree;
+    LcaIndex *index;
+    TreeMetrics metrics;
+    SubtreeIndex *subtrees;
+    LinkCutTree *forest;
+    pthread_mutex_t *forestLock;
+} ServerState;
+
+/**
+ * @brief the accepted connections waiting for a worker:
+ * fds - a ring of connection descriptors
+ * head, count - the first connection in the ring, and the number of connections in it
+ * closed - set once no more connections will be added
+ * activeFds - the connection each worker is serving, -1 if none
+ * the accepting thread doesn't wait on the lock for room in the ring - it sleeps in ppoll, where
+ * the stop signals can reach it, and looks again.
+ */
+typedef struct ConnectionQueue
+{
+    int fds[CONNECTION_QUEUE_CAPACITY];
+    int head;
+    int count;
+    int closed;
+    int *activeFds;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+} ConnectionQueue;
+
+/**
+ * @brief a worker of the pool:
+ * id - the index of the worker, and of its slot in activeFds
+ * state - what the queries are answered from
+ * queue - where connections are taken from
+ */
+typedef struct ServerWorker
+{
+    int id;
+    const ServerState *state;
+    ConnectionQueue *queue;
+} ServerWorker;
+
+static volatile sig_atomic_t stopServer = 0;
+
+/**
+ * @brief computes everything the queries are answered from
+ * @param dynamic - if not 0, only the link-cut trees
+ */
+void initServerState(ServerState *state, const AllTree *mainTree, int root, int dynamic);
+
+/**
+ * @brief frees everything computed by initServerState
+ */
+void freeServerState(ServerState *state);
+
+/**
+ * @brief the routine of a worker thread - serves connections until the queue is closed
+ * @param arg - the ServerWorker
+ */
+void *serverWorker(void *arg);
+
+/**
+ * @brief reads requests from a connection and answers them, until the connection is closed or
+ * the client quits.
+ * @param path - room for the longest path in the tree
+ */
+void serveConnection(const ServerState *state, int inFd, int outFd, int32_t *path);
+
+/**
+ * @brief answers a single request line
+ * @return - 0 if the client asked to quit, 1 otherwise
+ */
+int answerRequest(const ServerState *state, char *request, OutputBuffer *out, int32_t *path);
+
+/**
+ * @brief answers a request of the dynamic mode, holding the lock of the forest
+ * @param command - the first token of the request
+ * @return - 0 if the client asked to quit, 1 otherwise
+ */
+int answerDynamicRequest(const ServerState *state, const char *command, char **savePtr,
+                         OutputBuffer *out);
+
+/**
+ * @brief reads a vertex out of the request, using strtok
+ * @return - the vertex, -1 if the next token isn't a valid vertex
+ */
+int nextRequestVertex(const ServerState *state, char **savePtr);
+
+/**
+ * @brief checks that nothing is left in the request, using strtok
+ * @return - 1 if the request has no more tokens, 0 otherwise
+ */
+int endOfRequest(char **savePtr);
+
+
+/**
+ * @brief adds an accepted connection to the queue, waiting while it is full
+ * @param waitMask - the signal mask to wait with, in which the stop signals are unblocked
+ * @return - 1 if the connection was added, 0 if the server was stopped while waiting
+ */
+int pushConnection(ConnectionQueue *queue, int fd, const sigset_t *waitMask);
+
+/**
+ * @brief takes a connection out of the queue, waiting while it is empty
+ * @return - the connection, -1 once the queue is closed and empty
+ */
+int popConnection(ConnectionQueue *queue);
+
+/**
+ * @brief opens a UNIX-domain socket listening on the given path
+ * @return - the socket, -1 on failure
+ */
+int openServerSocket(const char *socketPath);
+
+/**
+ * @brief marks the server to stop, on SIGINT or SIGTERM
+ */
+void handleStopSignal(int signalNumber);
+
+/********************************************************************************
+*********************************************************************************
+*************              Running the Server            ************************
+*********************************************************************************
+********************************************************************************/
+
+int runServer(const AllTree *mainTree, int root, const char *socketPath, int numOfWorkers,
+              int dynamic)
+{
+    ServerState state;
+    signal(SIGPIPE, SIG_IGN);
+    initServerState(&state, mainTree, root, dynamic);
+    if (strcmp(socketPath, "-") == 0)
+    {
+        int32_t *path = (int32_t *) checkedMalloc(mainTree->value * sizeof(int32_t));
+        serveConnection(&state, STDIN_FILENO, STDOUT_FILENO, path);
+        free(path);
+        freeServerState(&state);
+        return EXIT_SUCCESS;
+    }
+    struct sigaction stopAction;
+    memset(&stopAction, 0, sizeof(stopAction));
+    stopAction.sa_handler = handleStopSignal;
+    sigaction(SIGINT, &stopAction, NULL);
+    sigaction(SIGTERM, &stopAction, NULL);
+    // the stop signals stay blocked everywhere but inside the ppoll of the accepting thread, so
+    // one sent while it checks stopServer waits for the ppoll and makes it return at once
+    sigset_t stopSignals;
+    sigset_t previousMask;
+    sigset_t waitMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+    waitMask = previousMask;
+    sigdelset(&waitMask, SIGINT);
+    sigdelset(&waitMask, SIGTERM);
+    int listenFd = openServerSocket(socketPath);
+    if (listenFd < 0)
+    {
+        fprintf(stderr, "Can't listen on %s: %s\n", socketPath, strerror(errno));
+        pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+        freeServerState(&state);
+        return EXIT_FAILURE;
+    }
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+
+    ConnectionQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.notEmpty, NULL);
+    queue.activeFds = (int *) checkedMalloc(numOfWorkers * sizeof(int));
+    pthread_t *threads = (pthread_t *) checkedMalloc(numOfWorkers * sizeof(pthread_t));
+    ServerWorker *workers = (ServerWorker *) checkedMalloc(numOfWorkers * sizeof(ServerWorker));
+    for (int i = 0; i < numOfWorkers; i++)
+    {
+        queue.activeFds[i] = -1;
+        workers[i].id = i;
+        workers[i].state = &state;
+        workers[i].queue = &queue;
+        if (pthread_create(&threads[i], NULL, serverWorker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "Thread creation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    fprintf(stderr, "Listening on %s with %d workers\n", socketPath, numOfWorkers);
+    struct pollfd listening = {listenFd, POLLIN, 0};
+    while (!stopServer)
+    {
+        if (ppoll(&listening, 1, NULL, &waitMask) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd >= 0)
+        {
+            if (!pushConnection(&queue, fd, &waitMask))
+            {
+                close(fd);
+            }
+        }
+        else if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN &&
+                 errno != EWOULDBLOCK)
+        {
+            perror("accept");
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&queue.lock); // stop taking connections, and wake up all the workers
+    queue.closed = 1;
+    for (int i = 0; i < numOfWorkers; i++)
+    {
+        if (queue.activeFds[i] != -1)
+        {
+            shutdown(queue.activeFds[i], SHUT_RDWR);
+        }
+    }
+    pthread_cond_broadcast(&queue.notEmpty);
+    pthread_mutex_unlock(&queue.lock);
+    for (int i = 0; i < numOfWorkers; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < queue.count; i++)
+    {
+        close(queue.fds[(queue.head + i) % CONNECTION_QUEUE_CAPACITY]);
+    }
+    close(listenFd);
+    unlink(socketPath);
+    pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+    free(threads);
+    free(workers);
+    free(queue.activeFds);
+    freeServerState(&state);
+    return EXIT_SUCCESS;
+}
+
+void initServerState(ServerState *state, const AllTree *mainTree, int root, int dynamic)
+{
+    memset(state, 0, sizeof(ServerState));
+    state->mainTree = mainTree;
+    if (dynamic)
+    {
+        state->forest = buildLinkCutTree(mainTree);
+        state->forestLock = (pthread_mutex_t *) checkedMalloc(sizeof(pthread_mutex_t));
+        pthread_mutex_init(state->forestLock, NULL);
+        return;
+    }
+    analyzeTree(mainTree, root, &state->metrics);
+    state->index = buildLcaIndex(mainTree, root);
+    state->subtrees = buildSubtreeIndex(mainTree, root);
+}
+
+void freeServerState(ServerState *state)
+{
+    if (state->forest != NULL)
+    {
+        freeLinkCutTree(state->forest);
+        pthread_mutex_destroy(state->forestLock);
+        free(state->forestLock);
+        return;
+    }
+    freeLcaIndex(state->index);
+    freeSubtreeIndex(state->subtrees);
+}
+
+void *serverWorker(void *arg)
+{
+    ServerWorker *worker = (ServerWorker *) arg;
+    int32_t *path = (int32_t *) checkedMalloc(worker->state->mainTree->value * sizeof(int32_t));
+    int fd;
+    while ((fd = popConnection(worker->queue)) != -1)
+    {
+        pthread_mutex_lock(&worker->queue->lock);
+        worker->queue->activeFds[worker->id] = fd;
+        pthread_mutex_unlock(&worker->queue->lock);
+        serveConnection(worker->state, fd, fd, path);
+        pthread_mutex_lock(&worker->queue->lock);
+        worker->queue->activeFds[worker->id] = -1;
+        pthread_mutex_unlock(&worker->queue->lock);
+        close(fd);
+    }
+    free(path);
+    return NULL;
+}
+
+void handleStopSignal(int signalNumber)
+{
+    (void) signalNumber;
+    stopServer = 1;
+}
+
+int openServerSocket(const char *socketPath)
+{
+    struct sockaddr_un address;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+    unlink(socketPath);
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(fd, LISTEN_BACKLOG) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************             Connection Queue               ************************
+*********************************************************************************
+********************************************************************************/
+
+int pushConnection(ConnectionQueue *queue, int fd, const sigset_t *waitMask)
+{
+    const struct timespec fullQueueWait = {0, FULL_QUEUE_WAIT_NS};
+    while (!stopServer)
+    {
+        pthread_mutex_lock(&queue->lock);
+        if (queue->count < CONNECTION_QUEUE_CAPACITY)
+        {
+            queue->fds[(queue->head + queue->count) % CONNECTION_QUEUE_CAPACITY] = fd;
+            queue->count++;
+            pthread_cond_signal(&queue->notEmpty);
+            pthread_mutex_unlock(&queue->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&queue->lock);
+        ppoll(NULL, 0, &fullQueueWait, waitMask); // a stop signal ends the wait at once
+    }
+    return 0;
+}
+
+int popConnection(ConnectionQueue *queue)
+{
+    int fd = -1;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed)
+    {
+        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+    if (!queue->closed)
+    {
+        fd = queue->fds[queue->head];
+        queue->head = (queue->head + 1) % CONNECTION_QUEUE_CAPACITY;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return fd;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************            Answering Requests              ************************
+*********************************************************************************
+********************************************************************************/
+
+void serveConnection(const ServerState *state, int inFd, int outFd, int32_t *path)
+{
+    char *in = (char *) checkedMalloc(SERVER_BUFFER_SIZE);
+    OutputBuffer *out = openOutputBuffer(outFd, SERVER_BUFFER_SIZE);
+    size_t inLength = 0;
+    int skippingLongLine = 0;
+    int open = 1;
+    while (open && !out->failed)
+    {
+        flushOutput(out); // all the whole requests read so far are answered
+        ssize_t numOfBytes = read(inFd, in + inLength, SERVER_BUFFER_SIZE - inLength);
+        if (numOfBytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numOfBytes <= 0)
+        {
+            break;
+        }
+        inLength += (size_t) numOfBytes;
+        char *lineStart = in;
+        char *lineEnd;
+        while (open && (lineEnd = (char *) memchr(lineStart, '\n',
+                                                  inLength - (lineStart - in))) != NULL)
+        {
+            *lineEnd = '\0';
+            if (skippingLongLine)
+            {
+                skippingLongLine = 0;
+            }
+            else
+            {
+                open = answerRequest(state, lineStart, out, path);
+            }
+            lineStart = lineEnd + 1;
+        }
+        inLength -= (size_t) (lineStart - in);
+        memmove(in, lineStart, inLength);
+        if (inLength > MAX_REQUEST_LENGTH) // drop the rest of a request that is too long
+        {
+            if (!skippingLongLine)
+            {
+                appendOutput(out, "error request too long\n");
+            }
+            skippingLongLine = 1;
+            inLength = 0;
+        }
+    }
+    closeOutputBuffer(out);
+    free(in);
+}
+
+int answerRequest(const ServerState *state, char *request, OutputBuffer *out, int32_t *path)
+{
+    char *savePtr;
+    char *command = strtok_r(request, " \t\r", &savePtr);
+    if (command == NULL)
+    {
+        appendOutput(out, "error empty request\n");
+    }
+    else if (state->forest != NULL)
+    {
+        return answerDynamicRequest(state, command, &savePtr, out);
+    }
+    else if (strcmp(command, "distance") == 0 || strcmp(command, "path") == 0)
+    {
+        int u = nextRequestVertex(state, &savePtr);
+        int v = nextRequestVertex(state, &savePtr);
+        if (u == -1 || v == -1 || !endOfRequest(&savePtr))
+        {
+            appendOutput(out, "error expected two vertices\n");
+        }
+        else if (command[0] == 'd')
+        {
+            appendNumber(out, treeDistance(state->index, u, v));
+            appendChar(out, '\n');
+        }
+        else
+        {
+            int numOfVertices = findPath(state->index, u, v, path);
+            appendNumber(out, numOfVertices - 1);
+            appendChar(out, ':');
+            for (int i = 0; i < numOfVertices; i++)
+            {
+                appendChar(out, ' ');
+                appendNumber(out, ORIGINAL_LABEL(state->mainTree, path[i]));
+            }
+            appendChar(out, '\n');
+        }
+    }
+    else if (strcmp(command, "subtree") == 0 || strcmp(command, "depth") == 0)
+    {
+        int x = nextRequestVertex(state, &savePtr);
+        if (x == -1 || !endOfRequest(&savePtr))
+        {
+            appendOutput(out, "error expected a vertex\n");
+        }
+        else
+        {
+            appendNumber(out, (command[0] == 's') ? subtreeSize(state->subtrees, x) :
+                              nodeDepth(state->subtrees, x));
+            appendChar(out, '\n');
+        }
+    }
+    else if (strcmp(command, "ancestor") == 0)
+    {
+        int x = nextRequestVertex(state, &savePtr);
+        int y = nextRequestVertex(state, &savePtr);
+        if (x == -1 || y == -1 || !endOfRequest(&savePtr))
+        {
+            appendOutput(out, "error expected two vertices\n");
+        }
+        else
+        {
+            appendOutput(out, isAncestor(state->subtrees, x, y) ? "1\n" : "0\n");
+        }
+    }
+    else if (strcmp(command, "diameter") == 0 && endOfRequest(&savePtr))
+    {
+        appendNumber(out, state->metrics.diameter);
+        appendChar(out, ' ');
+        appendNumber(out, ORIGINAL_LABEL(state->mainTree, state->metrics.diameterStart));
+        appendChar(out, ' ');
+        appendNumber(out, ORIGINAL_LABEL(state->mainTree, state->metrics.diameterEnd));
+        appendChar(out, '\n');
+    }
+    else if (strcmp(command, "stats") == 0 && endOfRequest(&savePtr))
+    {
+        appendNumber(out, ORIGINAL_LABEL(state->mainTree, state->metrics.root));
+        appendChar(out, ' ');
+        appendNumber(out, state->mainTree->value);
+        appendChar(out, ' ');
+        appendNumber(out, state->metrics.minBranch);
+        appendChar(out, ' ');
+        appendNumber(out, state->metrics.maxBranch);
+        appendChar(out, '\n');
+    }
+    else if (strcmp(command, "quit") == 0 && endOfRequest(&savePtr))
+    {
+        return 0;
+    }
+    else
+    {
+        appendOutput(out, "error unknown request\n");
+    }
+    return 1;
+}
+
+int answerDynamicRequest(const ServerState *state, const char *command, char **savePtr,
+                         OutputBuffer *out)
+{
+    LinkCutTree *forest = state->forest;
+    int numOfVertices;
+    if (strcmp(command, "link") == 0 || strcmp(command, "connected") == 0 ||
+        strcmp(command, "distance") == 0 || strcmp(command, "ancestor") == 0)
+    {
+        numOfVertices = 2;
+    }
+    else if (strcmp(command, "cut") == 0 || strcmp(command, "root") == 0 ||
+             strcmp(command, "depth") == 0)
+    {
+        numOfVertices = 1;
+    }
+    else if (strcmp(command, "quit") == 0 && endOfRequest(savePtr))
+    {
+        return 0;
+    }
+    else
+    {
+        appendOutput(out, (strcmp(command, "path") == 0 || strcmp(command, "diameter") == 0 ||
+                           strcmp(command, "subtree") == 0 || strcmp(command, "stats") == 0) ?
+                          "error not available in the dynamic mode\n" :
+                          "error unknown request\n");
+        return 1;
+    }
+    int x = nextRequestVertex(state, savePtr);
+    int y = (numOfVertices == 2) ? nextRequestVertex(state, savePtr) : 0;
+    if (x == -1 || y == -1 || !endOfRequest(savePtr))
+    {
+        appendOutput(out, (numOfVertices == 2) ? "error expected two vertices\n" :
+                          "error expected a vertex\n");
+        return 1;
+    }
+    pthread_mutex_lock(state->forestLock);
+    if (strcmp(command, "link") == 0)
+    {
+        if (linkCutDepth(forest, x) != 0)
+        {
+            appendOutput(out, "error the vertex already has a father\n");
+        }
+        else
+        {
+            appendOutput(out, linkCutLink(forest, x, y) ? "ok\n" :
+                              "error the father is in the subtree of the vertex\n");
+        }
+    }
+    else if (strcmp(command, "cut") == 0)
+    {
+        appendOutput(out, linkCutCut(forest, x) ? "ok\n" : "error the vertex has no father\n");
+    }
+    else if (strcmp(command, "connected") == 0)
+    {
+        appendOutput(out, (linkCutRoot(forest, x) == linkCutRoot(forest, y)) ? "1\n" : "0\n");
+    }
+    else if (strcmp(command, "root") == 0)
+    {
+        appendNumber(out, ORIGINAL_LABEL(state->mainTree, linkCutRoot(forest, x)));
+        appendChar(out, '\n');
+    }
+    else if (strcmp(command, "depth") == 0)
+    {
+        appendNumber(out, linkCutDepth(forest, x));
+        appendChar(out, '\n');
+    }
+    else if (strcmp(command, "distance") == 0)
+    {
+        int distance = linkCutDistance(forest, x, y);
+        if (distance == -1)
+        {
+            appendOutput(out, "error the vertices aren't connected\n");
+        }
+        else
+        {
+            appendNumber(out, distance);
+            appendChar(out, '\n');
+        }
+    }
+    else
+    {
+        appendOutput(out, (linkCutLca(forest, x, y) == x) ? "1\n" : "0\n");
+    }
+    pthread_mutex_unlock(state->forestLock);
+    return 1;
+}
+
+int nextRequestVertex(const ServerState *state, char **savePtr)
+{
+    char *token = strtok_r(NULL, " \t\r", savePtr);
+    long long vertex = 0;
+    if (token == NULL || *token == '\0')
+    {
+        return -1;
+    }
+    for (; *token != '\0'; token++)
+    {
+        if (*token < '0' || *token > '9')
+        {
+            return -1;
+        }
+        vertex = vertex * 10 + (*token - '0');
+        if (vertex >= state->mainTree->value)
+        {
+            return -1;
+        }
+    }
+    return INTERNAL_LABEL(state->mainTree, (int) vertex);
+}
+
+int endOfRequest(char **savePtr)
+{
+    return strtok_r(NULL, " \t\r", savePtr) == NULL;
+}
@@ -0,0 +1,235 @@
+/**
+* @file TreeStats.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief measuring where the time and memory of a run of the TreeAnalyzer go, for --stats
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : the phases of the run as they start, and the allocations and BFS runs made in them
+* Process: the run is split into named phases, one after the other. the wall time and the CPU
+* time of the process - of all of its threads - are taken when a phase starts and ends. the
+* allocations and BFS runs are added up into running totals, atomically since they are made by
+* several threads, and a phase holds the difference of the totals between its start and end.
+* when the stats are off, every hook returns at its first check, so they can stay in the code.
+* the stats are printed when the program exits, however it exits.
+* Output : a line per phase on the standard error, or a JSON object
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define MAX_STATS_PHASES 32
+
+/**
+ * @brief what was measured in a phase:
+ * name - the name of the phase
+ * wallSeconds, cpuSeconds - the wall time of the phase, and the CPU time of all the threads
+ * numOfAllocations, allocatedBytes - the allocations made in the phase, and their size
+ * peakKilobytes - the peak resident memory of the process at the end of the phase
+ * numOfBfs, bfsNodes, bfsEdges - the BFS runs made in the phase, and the nodes and edges they
+ * visited
+ */
+typedef struct StatsPhase
+{
+    const char *name;
+    double wallSeconds;
+    double cpuSeconds;
+    long long numOfAllocations;
+    long long allocatedBytes;
+    long peakKilobytes;
+    long long numOfBfs;
+    long long bfsNodes;
+    long long bfsEdges;
+} StatsPhase;
+
+/**
+ * @brief the totals the phases are measured by - all of them since the stats were enabled
+ */
+typedef struct StatsTotals
+{
+    struct timespec wall;
+    struct timespec cpu;
+    long long numOfAllocations;
+    long long allocatedBytes;
+    long long numOfBfs;
+    long long bfsNodes;
+    long long bfsEdges;
+} StatsTotals;
+
+static int statsFormat = STATS_OFF;
+static StatsPhase phases[MAX_STATS_PHASES];
+static int numOfPhases = 0;
+static int phaseOpen = 0;
+static StatsTotals phaseStart;
+static StatsTotals totals;
+
+/**
+ * @brief the totals right now
+ */
+void readTotals(StatsTotals *now);
+
+/**
+ * @brief the seconds between two times
+ */
+double secondsBetween(const struct timespec *start, const struct timespec *end);
+
+/**
+ * @brief the peak resident memory of the process, in KB
+ */
+long peakKilobytes(void);
+
+void enableStats(int format)
+{
+    statsFormat = format;
+    if (format != STATS_OFF)
+    {
+        atexit(printStats); // every way out of the program - a failure too - prints the stats
+    }
+}
+
+void startStatsPhase(const char *name)
+{
+    if (statsFormat == STATS_OFF)
+    {
+        return;
+    }
+    endStatsPhase();
+    if (numOfPhases == MAX_STATS_PHASES)
+    {
+        return;
+    }
+    phases[numOfPhases].name = name;
+    readTotals(&phaseStart);
+    phaseOpen = 1;
+}
+
+void endStatsPhase(void)
+{
+    if (statsFormat == STATS_OFF || !phaseOpen)
+    {
+        return;
+    }
+    StatsTotals now;
+    readTotals(&now);
+    StatsPhase *phase = &phases[numOfPhases++];
+    phase->wallSeconds = secondsBetween(&phaseStart.wall, &now.wall);
+    phase->cpuSeconds = secondsBetween(&phaseStart.cpu, &now.cpu);
+    phase->numOfAllocations = now.numOfAllocations - phaseStart.numOfAllocations;
+    phase->allocatedBytes = now.allocatedBytes - phaseStart.allocatedBytes;
+    phase->peakKilobytes = peakKilobytes();
+    phase->numOfBfs = now.numOfBfs - phaseStart.numOfBfs;
+    phase->bfsNodes = now.bfsNodes - phaseStart.bfsNodes;
+    phase->bfsEdges = now.bfsEdges - phaseStart.bfsEdges;
+    phaseOpen = 0;
+}
+
+void countAllocation(size_t size)
+{
+    if (statsFormat == STATS_OFF)
+    {
+        return;
+    }
+    __atomic_fetch_add(&totals.numOfAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.allocatedBytes, (long long) size, __ATOMIC_RELAXED);
+}
+
+void countBfs(long long numOfNodes, long long numOfEdges)
+{
+    if (statsFormat == STATS_OFF)
+    {
+        return;
+    }
+    __atomic_fetch_add(&totals.numOfBfs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.bfsNodes, numOfNodes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.bfsEdges, numOfEdges, __ATOMIC_RELAXED);
+}
+
+void printStats(void)
+{
+    if (statsFormat == STATS_OFF)
+    {
+        return;
+    }
+    endStatsPhase();
+    StatsPhase total = {"total", 0, 0, 0, 0, peakKilobytes(), 0, 0, 0};
+    for (int i = 0; i < numOfPhases; i++)
+    {
+        total.wallSeconds += phases[i].wallSeconds;
+        total.cpuSeconds += phases[i].cpuSeconds;
+        total.numOfAllocations += phases[i].numOfAllocations;
+        total.allocatedBytes += phases[i].allocatedBytes;
+        total.numOfBfs += phases[i].numOfBfs;
+        total.bfsNodes += phases[i].bfsNodes;
+        total.bfsEdges += phases[i].bfsEdges;
+    }
+    if (statsFormat == STATS_JSON)
+    {
+        fprintf(stderr, "{\"phases\": [");
+    }
+    else
+    {
+        fprintf(stderr, "%-12s %10s %10s %12s %14s %10s %6s %12s %12s\n", "phase", "wall s",
+                "cpu s", "allocations", "bytes", "peak MB", "bfs", "bfs nodes", "bfs edges");
+    }
+    for (int i = 0; i <= numOfPhases; i++)
+    {
+        const StatsPhase *phase = (i < numOfPhases) ? &phases[i] : &total;
+        if (statsFormat == STATS_JSON && i == numOfPhases)
+        {
+            fprintf(stderr, "], \"total\": ");
+        }
+        else if (statsFormat == STATS_JSON && i > 0)
+        {
+            fprintf(stderr, ", ");
+        }
+        if (statsFormat == STATS_JSON)
+        {
+            fprintf(stderr, "{\"name\": \"%s\", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, "
+                            "\"allocations\": %lld, \"allocated_bytes\": %lld, "
+                            "\"peak_rss_kb\": %ld, \"bfs_runs\": %lld, \"bfs_nodes\": %lld, "
+                            "\"bfs_edges\": %lld}", phase->name, phase->wallSeconds,
+                    phase->cpuSeconds, phase->numOfAllocations, phase->allocatedBytes,
+                    phase->peakKilobytes, phase->numOfBfs, phase->bfsNodes, phase->bfsEdges);
+        }
+        else
+        {
+            fprintf(stderr, "%-12s %10.3f %10.3f %12lld %14lld %10.1f %6lld %12lld %12lld\n",
+                    phase->name, phase->wallSeconds, phase->cpuSeconds, phase->numOfAllocations,
+                    phase->allocatedBytes, (double) phase->peakKilobytes / 1024, phase->numOfBfs,
+                    phase->bfsNodes, phase->bfsEdges);
+        }
+    }
+    if (statsFormat == STATS_JSON)
+    {
+        fprintf(stderr, "}\n");
+    }
+}
+
+void readTotals(StatsTotals *now)
+{
+    clock_gettime(CLOCK_MONOTONIC, &now->wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now->cpu);
+    now->numOfAllocations = __atomic_load_n(&totals.numOfAllocations, __ATOMIC_RELAXED);
+    now->allocatedBytes = __atomic_load_n(&totals.allocatedBytes, __ATOMIC_RELAXED);
+    now->numOfBfs = __atomic_load_n(&totals.numOfBfs, __ATOMIC_RELAXED);
+    now->bfsNodes = __atomic_load_n(&totals.bfsNodes, __ATOMIC_RELAXED);
+    now->bfsEdges = __atomic_load_n(&totals.bfsEdges, __ATOMIC_RELAXED);
+}
+
+double secondsBetween(const struct timespec *start, const struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+long peakKilobytes(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,1411 @@
+/**
+* @file TreeStream.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief computing the stats of a tree that doesn't fit in memory, from sequential passes over
+* files with a bounded amount of memory
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph file, and the number of bytes of memory to use
+* Process: nothing is kept per node in memory - every step reads files of fixed size records from
+* start to end and writes new ones, in temporary files that are deleted when closed.
+* 1. the graph file is read once, and every son in it is written as a (child, parent) edge.
+* 2. the edges are sorted by child, which puts the father of every node next to the node, in the
+*    order of the nodes. a node missing from the edges is a root, and a node found twice has two
+*    fathers.
+* 3. the depths are found by pointer jumping - every node starts with its father as its ancestor,
+*    and every round replaces the ancestor of every node with the ancestor of its ancestor, adding
+*    up the distances, so after round k every node at depth below 2^k has reached the root. a round
+*    sorts the (node, ancestor, distance) records by ancestor and joins them with themselves sorted
+*    by node. after as many rounds as a field has bits, a node that didn't reach the root lies on
+*    or below a cycle.
+* 4. the nodes are sorted by depth, deepest first, and handled level by level. every node takes
+*    the heights its sons sent it, which gives its height and the longest route through it, and
+*    sends its own height to its father - the messages of a level are sorted by father, so they
+*    are read in the order the next level is handled.
+* every sort is an external merge sort - runs of as many records as fit in the memory are radix
+* sorted and written out, and then merged, as many runs at a time as the memory allows. small
+* sorts are a single run and never touch the merge.
+* the fields of the records are as wide as the number of nodes needs - 32 bits below 2^31 nodes,
+* and 64 bits above it, up to about 9 * 10^17. the width is chosen once the first line is read,
+* and the radix sort, where most of the time goes, is specialized for each width.
+* Output : the number of nodes and the StreamedMetrics of the tree, or the first error in the file
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#define READ_BUFFER_SIZE (1 << 20)
+// a piece of a line in the read buffer holds at most a son and a delimiter every two bytes
+#define PIECE_SONS_ROOM (READ_BUFFER_SIZE / 2 + 1)
+#define STREAM_BUFFER_RECORDS (1 << 16)
+#define MIN_RUN_RECORDS 4096
+#define MERGE_BUFFER_BYTES (1 << 20)
+#define MAX_MERGE_FAN_IN 1024
+#define TEMP_FILE_TEMPLATE "/TreeStreamXXXXXX"
+// the sons read from a line are below the number of nodes, so ten times it must fit in 64 bits
+#define MAX_STREAMED_NODES (LLONG_MAX / 10)
+
+#define LINE_MISSING (-3)
+
+/**
+ * @brief defines a stable LSD radix sort of records of fields of a given type, a byte of the key
+ * at a time. the signed fields are sorted by their value, -1 first, by flipping their sign bit.
+ * @param name - the name of the function
+ * @param Field - the type of the fields
+ * @param Key - the unsigned type of the same width
+ * @param signBit - the sign bit of a key
+ */
+#define DEFINE_RADIX_SORT(name, Field, Key, signBit) \
+void name(void *records, void *temp, long long count, const RecordOrder *order) \
+{ \
+    int recordLength = order->recordLength; \
+    int keyField = order->keyField; \
+    Key flip = order->descending ? (Key) ~(signBit) : (signBit); \
+    Field *from = (Field *) records; \
+    Field *to = (Field *) temp; \
+    for (int shift = 0; shift < (int) (8 * sizeof(Key)); shift += 8) \
+    { \
+        long long counts[256] = {0}; \
+        for (long long i = 0; i < count; i++) \
+        { \
+            counts[(((Key) from[i * recordLength + keyField] ^ flip) >> shift) & 0xFF]++; \
+        } \
+        if (count == 0 || counts[(((Key) from[keyField] ^ flip) >> shift) & 0xFF] == count) \
+        { \
+            continue; /* all the keys share this byte */ \
+        } \
+        long long position = 0; \
+        for (int b = 0; b < 256; b++) \
+        { \
+            long long bucketSize = counts[b]; \
+            counts[b] = position; \
+            position += bucketSize; \
+        } \
+        for (long long i = 0; i < count; i++) \
+        { \
+            const Field *record = from + i * recordLength; \
+            Field *target = to + counts[(((Key) record[keyField] ^ flip) >> shift) & 0xFF]++ * \
+                                 recordLength; \
+            for (int f = 0; f < recordLength; f++) \
+            { \
+                target[f] = record[f]; \
+            } \
+        } \
+        Field *swap = from; \
+        from = to; \
+        to = swap; \
+    } \
+    if (from != (Field *) records) \
+    { \
+        memcpy(records, from, count * recordLength * sizeof(Field)); \
+    } \
+}
+
+// an edge: the child, and the node whose line it is in
+#define EDGE_FIELDS 2
+#define EDGE_CHILD 0
+#define EDGE_PARENT 1
+// a pointer jumping record: the node, its current ancestor (-1 past the root) and the distance
+#define JUMP_FIELDS 3
+#define JUMP_NODE 0
+#define JUMP_ANCESTOR 1
+#define JUMP_DISTANCE 2
+// a node of a level: its depth, the node and its father
+#define LEVEL_FIELDS 3
+#define LEVEL_DEPTH 0
+#define LEVEL_NODE 1
+#define LEVEL_PARENT 2
+// a message to a father: the father, the height of the son plus 1, and the deepest leaf under it
+#define MESSAGE_FIELDS 3
+#define MESSAGE_PARENT 0
+#define MESSAGE_HEIGHT 1
+#define MESSAGE_DEEPEST 2
+
+/**
+ * @brief how records are sorted:
+ * recordLength - the number of fields in a record
+ * keyField - the field the records are sorted by. records with the same key keep their order.
+ * descending - 1 for the largest key first, 0 for the smallest first
+ */
+typedef struct RecordOrder
+{
+    int recordLength;
+    int keyField;
+    int descending;
+} RecordOrder;
+
+/**
+ * @brief a buffered sequential reader of the records of a file:
+ * file - the file, read from its start
+ * recordLength - the number of fields in a record
+ * buffer, count, next - the records read into memory, and the next one to return
+ */
+typedef struct RecordStream
+{
+    FILE *file;
+    int recordLength;
+    char *buffer;
+    long count;
+    long next;
+} RecordStream;
+
+/**
+ * @brief a buffered sequential writer of records into a file:
+ * file - the file, written from its current position
+ * recordLength - the number of fields in a record
+ * buffer, count - the records not written yet
+ * numOfRecords - the number of records given to the sink
+ */
+typedef struct RecordSink
+{
+    FILE *file;
+    int recordLength;
+    char *buffer;
+    long count;
+    long long numOfRecords;
+} RecordSink;
+
+/**
+ * @brief one sorted run of a file being merged:
+ * fd - the file of the runs
+ * position, left - the next record of the run not read into the buffer, and how many are left
+ * buffer, count, next - the records of the run read into memory, and the current one
+ */
+typedef struct RunReader
+{
+    int fd;
+    long long position;
+    long long left;
+    char *buffer;
+    long capacity;
+    long count;
+    long next;
+} RunReader;
+
+/**
+ * @brief the messages sent to the nodes of a level by their sons. they are kept in memory, and
+ * spilled to a temporary file if there are too many of them:
+ * records, count, capacity - the messages in memory
+ * spill - the file of the spilled messages, NULL if none were spilled
+ * numOfMessages - the number of messages of the level
+ * sorted - the messages sorted by father, once the level is done, if they were spilled
+ * stream, current - reading the sorted messages, current is the next one or NULL at the end
+ */
+typedef struct MessageLevel
+{
+    char *records;
+    long long count;
+    long long capacity;
+    FILE *spill;
+    long long numOfMessages;
+    FILE *sorted;
+    RecordStream stream;
+    long long next;
+    const void *current;
+} MessageLevel;
+
+/**
+ * @brief a buffered reader of the graph file:
+ * file - the graph file
+ * buffer, length, next - the bytes read into memory, and the next one not used yet
+ * ended - set once the end of the file was read
+ * sons - room for the sons of the piece of a line in the buffer, as read by scanSons64
+ */
+typedef struct GraphReader
+{
+    FILE *file;
+    char *buffer;
+    size_t length;
+    size_t next;
+    int ended;
+    uint64_t *sons;
+} GraphReader;
+
+// the bytes of a field of every record, chosen by scanGraphFile from the number of nodes
+static int fieldBytes = sizeof(int32_t);
+
+/**
+ * @brief reads the graph file, and writes an edge for every son in it. the width of the fields
+ * of the records is chosen from the number of nodes.
+ * @param numOfNodesInTree - out: the number of nodes, from the first line
+ * @param edges - out: the edges, opened once the width is chosen. opened even if the file is
+ * invalid.
+ * @return - 1 if the file is valid line by line, 0 otherwise
+ */
+int scanGraphFile(const char *fileName, long long *numOfNodesInTree, RecordSink *edges,
+                  ParseError *error);
+
+/**
+ * @brief reads the first line of the graph file - a positive number of nodes
+ * @return - the number of nodes, 0 if the line is invalid
+ */
+long long scanStreamedNumOfNodes(GraphReader *reader);
+
+/**
+ * @brief reads a line of the graph file with scanSons64, the same way the sons of a line are read
+ * by TreeParser.c. a line longer than the buffer is read in pieces, each of them cut after a
+ * DELIMITER so no son is cut in two.
+ * @param node - the node of the line, its sons are written to edges as its edges
+ * @param edges - where the edges are written, NULL to only check the line
+ * @return - the number of sons, LINE_BLANK if the line has nothing but spaces, LINE_INVALID if
+ * it is invalid, and LINE_MISSING if the file ended before it
+ */
+long long scanStreamedLine(GraphReader *reader, long long numOfNodesInTree, long long node,
+                           RecordSink *edges);
+
+/**
+ * @brief the next byte of the graph file, EOF at its end
+ */
+int readGraphByte(GraphReader *reader);
+
+/**
+ * @brief moves the bytes of the buffer not used yet to its start, and reads more after them
+ * @return - the number of bytes read, 0 at the end of the file
+ */
+size_t fillGraphReader(GraphReader *reader);
+
+/**
+ * @brief finds the father of every node from the edges sorted by child, and checks every node but
+ * a single root has exactly one father
+ * @param jumps - out: the first pointer jumping record of every node, in the order of the nodes
+ * @param fathers - out: the father of every node, -1 for the root, in the order of the nodes
+ * @param root - out: the root
+ * @return - 1 if valid, 0 otherwise
+ */
+int findStreamedFathers(FILE *sortedEdges, long long numOfNodesInTree, RecordSink *jumps,
+                        RecordSink *fathers, long long *root, ParseError *error);
+
+/**
+ * @brief finds the depth of every node by pointer jumping
+ * @param jumps - the first pointer jumping record of every node, in the order of the nodes.
+ * closed by the function.
+ * @return - a record per node in the order of the nodes, with the depth as its distance and -1 as
+ * its ancestor. NULL if some nodes can't be reached from the root.
+ */
+FILE *findStreamedDepths(FILE *jumps, long long numOfNodesInTree, long long root,
+                         size_t memoryBudget, ParseError *error);
+
+/**
+ * @brief handles the nodes level by level from the deepest, and computes the stats of the tree
+ * @param levels - the nodes sorted by depth, deepest first, and by node within a level
+ */
+void measureStreamedLevels(FILE *levels, long long root, size_t memoryBudget,
+                           StreamedMetrics *metrics);
+
+/**
+ * @brief adds a message to the messages of the next level
+ */
+void sendMessage(MessageLevel *level, long long parent, long long height, long long deepest);
+
+/**
+ * @brief sorts the messages of a level by father, for them to be read
+ * @param temp - room for as many records as the level keeps in memory
+ */
+void finishMessageLevel(MessageLevel *level, void *temp, size_t memoryBudget);
+
+/**
+ * @brief moves to the next message of a level that is being read
+ */
+void nextMessage(MessageLevel *level);
+
+/**
+ * @brief empties a level, for it to take the messages of another
+ */
+void resetMessageLevel(MessageLevel *level);
+
+/**
+ * @brief sorts the records of a file with an external merge sort, leaving the file as it is
+ * @return - a new temporary file with the sorted records
+ */
+FILE *sortRecords(FILE *input, long long numOfRecords, const RecordOrder *order,
+                  size_t memoryBudget);
+
+/**
+ * @brief merges sorted runs of a file into a single run, appended to out
+ * @param runStart, runLength - the first record and the number of records of every run
+ * @param numOfRuns - the number of runs to merge
+ */
+void mergeRuns(FILE *runs, const long long *runStart, const long long *runLength, int numOfRuns,
+               FILE *out, const RecordOrder *order, size_t memoryBudget);
+
+/**
+ * @brief sorts records in memory with a stable LSD radix sort, by the kernel of the width of the
+ * fields
+ * @param temp - room for count records
+ */
+void radixSortRecords(void *records, void *temp, long long count, const RecordOrder *order);
+
+void radixSortRecords32(void *records, void *temp, long long count, const RecordOrder *order);
+
+void radixSortRecords64(void *records, void *temp, long long count, const RecordOrder *order);
+
+/**
+ * @brief the key of a record as an unsigned number, in the order the records are sorted in
+ */
+uint64_t recordKey(const void *record, const RecordOrder *order);
+
+/**
+ * @brief moves a run to its next record, reading more of it if needed
+ * @return - 1 if there is a next record, 0 at the end of the run
+ */
+int advanceRun(RunReader *run, int recordLength);
+
+/**
+ * @brief restores the order of a heap of runs below a position, after the run there changed
+ */
+void siftRunDown(int *heap, int heapSize, int i, const RunReader *runs, const RecordOrder *order);
+
+/**
+ * @brief whether the current record of the first run comes before that of the second
+ */
+int runBefore(const RunReader *runs, int first, int second, const RecordOrder *order);
+
+void openRecordStream(RecordStream *stream, FILE *file, int recordLength);
+
+/**
+ * @brief the next record of a stream
+ * @return - the record, valid until the next call, or NULL at the end of the file
+ */
+const void *readRecord(RecordStream *stream);
+
+void closeRecordStream(RecordStream *stream);
+
+void openRecordSink(RecordSink *sink, FILE *file, int recordLength);
+
+/**
+ * @brief adds a record to a sink
+ * @return - where to write the fields of the record, valid until the next call
+ */
+void *appendRecord(RecordSink *sink);
+
+/**
+ * @brief writes the records left in a sink and frees its buffer. the file stays open.
+ */
+void closeRecordSink(RecordSink *sink);
+
+/**
+ * @brief a field of a record
+ */
+long long fieldOf(const void *record, int field);
+
+/**
+ * @brief sets a field of a record
+ */
+void setField(void *record, int field, long long value);
+
+/**
+ * @brief the bytes of a record of a number of fields
+ */
+size_t recordBytes(int recordLength);
+
+/**
+ * @brief the largest number a field holds
+ */
+long long maxFieldValue(void);
+
+/**
+ * @brief opens a new temporary file for reading and writing, in $TMPDIR or /tmp. it is deleted
+ * right away, so it goes away when closed. exits the program if the file can't be made.
+ */
+FILE *openTempFile(void);
+
+/**
+ * @brief writes to a temporary file, and exits the program if writing fails
+ */
+void checkedWrite(const void *data, size_t size, size_t count, FILE *file);
+
+/**
+ * @brief records an error, if error isn't NULL
+ */
+void setStreamError(ParseError *error, long line, const char *format, long long first,
+                    long long second);
+
+/********************************************************************************
+*********************************************************************************
+*************                The Passes                  ************************
+*********************************************************************************
+********************************************************************************/
+
+int streamAnalyzeTree(const char *fileName, size_t memoryBudget, long long *numOfNodesInTree,
+                      StreamedMetrics *metrics, ParseError *error)
+{
+    setStreamError(error, 0, "", 0, 0);
+    // large buffers come and go with every sort. left to itself, malloc raises its mmap threshold
+    // after the first of them is freed and serves the next ones from the heap, which then can't be
+    // given back, and the memory used creeps over the budget
+    mallopt(M_MMAP_THRESHOLD, MERGE_BUFFER_BYTES);
+    RecordSink edges;
+    int valid = scanGraphFile(fileName, numOfNodesInTree, &edges, error);
+    closeRecordSink(&edges);
+    if (!valid)
+    {
+        fclose(edges.file);
+        return 0;
+    }
+    RecordOrder byChild = {EDGE_FIELDS, EDGE_CHILD, 0};
+    FILE *sortedEdges = sortRecords(edges.file, edges.numOfRecords, &byChild, memoryBudget);
+    fclose(edges.file);
+
+    RecordSink jumps;
+    RecordSink fathers;
+    openRecordSink(&jumps, openTempFile(), JUMP_FIELDS);
+    openRecordSink(&fathers, openTempFile(), 1);
+    long long root;
+    valid = findStreamedFathers(sortedEdges, *numOfNodesInTree, &jumps, &fathers, &root, error);
+    fclose(sortedEdges);
+    closeRecordSink(&jumps);
+    closeRecordSink(&fathers);
+    FILE *depths = valid ? findStreamedDepths(jumps.file, *numOfNodesInTree, root, memoryBudget,
+                                              error) : NULL;
+    if (depths == NULL)
+    {
+        if (!valid)
+        {
+            fclose(jumps.file);
+        }
+        fclose(fathers.file);
+        return 0;
+    }
+
+    RecordStream depthStream;
+    RecordStream fatherStream;
+    RecordSink levels;
+    openRecordStream(&depthStream, depths, JUMP_FIELDS);
+    openRecordStream(&fatherStream, fathers.file, 1);
+    openRecordSink(&levels, openTempFile(), LEVEL_FIELDS);
+    const void *depth;
+    while ((depth = readRecord(&depthStream)) != NULL)
+    {
+        void *level = appendRecord(&levels);
+        setField(level, LEVEL_DEPTH, fieldOf(depth, JUMP_DISTANCE));
+        setField(level, LEVEL_NODE, fieldOf(depth, JUMP_NODE));
+        setField(level, LEVEL_PARENT, fieldOf(readRecord(&fatherStream), 0));
+    }
+    closeRecordStream(&depthStream);
+    closeRecordStream(&fatherStream);
+    closeRecordSink(&levels);
+    fclose(depths);
+    fclose(fathers.file);
+    RecordOrder deepestFirst = {LEVEL_FIELDS, LEVEL_DEPTH, 1};
+    FILE *sortedLevels = sortRecords(levels.file, levels.numOfRecords, &deepestFirst,
+                                     memoryBudget);
+    fclose(levels.file);
+    measureStreamedLevels(sortedLevels, root, memoryBudget, metrics);
+    fclose(sortedLevels);
+    return 1;
+}
+
+int scanGraphFile(const char *fileName, long long *numOfNodesInTree, RecordSink *edges,
+                  ParseError *error)
+{
+    GraphReader reader;
+    reader.file = fopen(fileName, "rb");
+    reader.buffer = (char *) checkedMalloc(READ_BUFFER_SIZE);
+    reader.length = 0;
+    reader.next = 0;
+    reader.ended = 0;
+    reader.sons = (uint64_t *) checkedMalloc(PIECE_SONS_ROOM * sizeof(uint64_t));
+    fieldBytes = sizeof(int32_t);
+    int valid = 1;
+    int c = (reader.file != NULL) ? readGraphByte(&reader) : EOF;
+    if (c == EOF)
+    {
+        setStreamError(error, 0, ERROR_EMPTY_FILE, 0, 0);
+        valid = 0;
+    }
+    else if (compressionOf(reader.buffer, reader.length) != COMPRESSION_NONE)
+    {
+        setStreamError(error, 0, "compressed files can't be streamed, only read whole", 0, 0);
+        valid = 0;
+    }
+    else
+    {
+        reader.next--; // the byte was only read to see the file isn't empty
+        *numOfNodesInTree = scanStreamedNumOfNodes(&reader);
+        if (*numOfNodesInTree == 0)
+        {
+            setStreamError(error, 1, ERROR_NUM_OF_NODES, 0, 0);
+            valid = 0;
+        }
+        // every field holds a node, a depth or a height - all of them less than the nodes
+        fieldBytes = (*numOfNodesInTree <= INT32_MAX) ? sizeof(int32_t) : sizeof(int64_t);
+    }
+    openRecordSink(edges, openTempFile(), EDGE_FIELDS);
+    long line = 2;
+    for (long long i = 0; valid && i < *numOfNodesInTree; i++, line++)
+    {
+        long long numOfSons = scanStreamedLine(&reader, *numOfNodesInTree, i, edges);
+        if (numOfSons < 0)
+        {
+            setStreamError(error, line, (numOfSons == LINE_MISSING) ? ERROR_MISSING_LINES :
+                                        (numOfSons == LINE_BLANK) ? ERROR_EMPTY_LINE :
+                                        ERROR_INVALID_LINE, 0, 0);
+            valid = 0;
+        }
+        else if (edges->numOfRecords > maxFieldValue())
+        {
+            setStreamError(error, line, ERROR_TOO_MANY_SONS, 0, 0);
+            valid = 0;
+        }
+    }
+    // only blank lines may follow the lines of the nodes
+    for (long long code = 0; valid && code != LINE_MISSING; line++)
+    {
+        code = scanStreamedLine(&reader, *numOfNodesInTree, -1, NULL);
+        if (code != LINE_BLANK && code != LINE_MISSING)
+        {
+            setStreamError(error, line, ERROR_EXTRA_CONTENT, 0, 0);
+            valid = 0;
+        }
+    }
+    free(reader.buffer);
+    free(reader.sons);
+    if (reader.file != NULL)
+    {
+        fclose(reader.file);
+    }
+    return valid;
+}
+
+int findStreamedFathers(FILE *sortedEdges, long long numOfNodesInTree, RecordSink *jumps,
+                        RecordSink *fathers, long long *root, ParseError *error)
+{
+    RecordStream stream;
+    openRecordStream(&stream, sortedEdges, EDGE_FIELDS);
+    long long roots[2];
+    long long numOfRoots = 0;
+    long long expected = 0; // the next node without a record
+    long long firstParent = -1;
+    long errorLine = LONG_MAX;
+    long long errorVertex = 0;
+    long long errorFirstParent = 0;
+    const void *edge;
+    do
+    {
+        edge = readRecord(&stream);
+        long long child = (edge != NULL) ? fieldOf(edge, EDGE_CHILD) : numOfNodesInTree;
+        if (edge != NULL && child == expected - 1) // a second father - the parents are in order
+        {
+            if (firstParent != -2 && fieldOf(edge, EDGE_PARENT) + 2 < errorLine)
+            {
+                errorLine = (long) fieldOf(edge, EDGE_PARENT) + 2;
+                errorVertex = child;
+                errorFirstParent = firstParent;
+            }
+            firstParent = -2; // only the second father of a node is where the error is found
+            continue;
+        }
+        for (; expected < child; expected++) // the nodes without a father
+        {
+            if (numOfRoots < 2)
+            {
+                roots[numOfRoots] = expected;
+            }
+            numOfRoots++;
+            void *jump = appendRecord(jumps);
+            setField(jump, JUMP_NODE, expected);
+            setField(jump, JUMP_ANCESTOR, -1);
+            setField(jump, JUMP_DISTANCE, 0);
+            setField(appendRecord(fathers), 0, -1);
+        }
+        if (edge != NULL)
+        {
+            firstParent = fieldOf(edge, EDGE_PARENT);
+            void *jump = appendRecord(jumps);
+            setField(jump, JUMP_NODE, child);
+            setField(jump, JUMP_ANCESTOR, firstParent);
+            setField(jump, JUMP_DISTANCE, 1);
+            setField(appendRecord(fathers), 0, firstParent);
+            expected = child + 1;
+        }
+    } while (edge != NULL);
+    closeRecordStream(&stream);
+
+    if (errorLine != LONG_MAX)
+    {
+        if (errorLine == errorFirstParent + 2)
+        {
+            setStreamError(error, errorLine, "vertex %lld appears more than once in the line",
+                           errorVertex, 0);
+        }
+        else
+        {
+            setStreamError(error, errorLine, "vertex %lld already has a father, in line %lld",
+                           errorVertex, errorFirstParent + 2);
+        }
+        return 0;
+    }
+    if (numOfRoots == 0)
+    {
+        setStreamError(error, 0, "every vertex has a father, so there is no root and the graph "
+                                 "has a cycle", 0, 0);
+        return 0;
+    }
+    if (numOfRoots > 1)
+    {
+        setStreamError(error, 0, "vertices %lld and %lld have no father - there can be only one "
+                                 "root", roots[0], roots[1]);
+        return 0;
+    }
+    *root = roots[0];
+    return 1;
+}
+
+FILE *findStreamedDepths(FILE *jumps, long long numOfNodesInTree, long long root,
+                         size_t memoryBudget, ParseError *error)
+{
+    RecordOrder byAncestor = {JUMP_FIELDS, JUMP_ANCESTOR, 0};
+    RecordOrder byNode = {JUMP_FIELDS, JUMP_NODE, 0};
+    long long numOfActive = numOfNodesInTree - 1; // the nodes that haven't reached the root
+    long long maxDistance = maxFieldValue();
+    FILE *table = jumps;
+    // every depth is below 2^(bits of a field), so it is reached after as many rounds
+    for (int round = 0; numOfActive > 0 && round < 8 * fieldBytes; round++)
+    {
+        FILE *sorted = sortRecords(table, numOfNodesInTree, &byAncestor, memoryBudget);
+        RecordStream records;
+        RecordStream ancestors; // the table in the order of the nodes, to look the ancestors up
+        RecordSink next;
+        openRecordStream(&records, sorted, JUMP_FIELDS);
+        openRecordStream(&ancestors, table, JUMP_FIELDS);
+        openRecordSink(&next, openTempFile(), JUMP_FIELDS);
+        const void *ancestor = readRecord(&ancestors);
+        const void *record;
+        numOfActive = 0;
+        while ((record = readRecord(&records)) != NULL)
+        {
+            void *jumped = appendRecord(&next);
+            memcpy(jumped, record, recordBytes(JUMP_FIELDS));
+            long long ancestorNode = fieldOf(record, JUMP_ANCESTOR);
+            if (ancestorNode == -1)
+            {
+                continue;
+            }
+            while (fieldOf(ancestor, JUMP_NODE) != ancestorNode)
+            {
+                ancestor = readRecord(&ancestors);
+            }
+            long long distance = fieldOf(record, JUMP_DISTANCE);
+            long long ancestorDistance = fieldOf(ancestor, JUMP_DISTANCE);
+            distance = (distance < maxDistance - ancestorDistance) ? distance + ancestorDistance :
+                       maxDistance;
+            setField(jumped, JUMP_ANCESTOR, fieldOf(ancestor, JUMP_ANCESTOR));
+            setField(jumped, JUMP_DISTANCE, distance);
+            numOfActive += (fieldOf(jumped, JUMP_ANCESTOR) != -1);
+        }
+        closeRecordStream(&records);
+        closeRecordStream(&ancestors);
+        closeRecordSink(&next);
+        fclose(sorted);
+        fclose(table);
+        table = sortRecords(next.file, numOfNodesInTree, &byNode, memoryBudget);
+        fclose(next.file);
+    }
+    if (numOfActive == 0)
+    {
+        rewind(table);
+        return table;
+    }
+    RecordStream records; // after all the rounds, the nodes left are never reached from the root
+    openRecordStream(&records, table, JUMP_FIELDS);
+    const void *record = readRecord(&records);
+    while (fieldOf(record, JUMP_ANCESTOR) == -1)
+    {
+        record = readRecord(&records);
+    }
+    setStreamError(error, 0, "vertex %lld is not reachable from the root %lld - it lies on or "
+                             "below a cycle", fieldOf(record, JUMP_NODE), root);
+    closeRecordStream(&records);
+    fclose(table);
+    return NULL;
+}
+
+void measureStreamedLevels(FILE *levels, long long root, size_t memoryBudget,
+                           StreamedMetrics *metrics)
+{
+    metrics->root = root;
+    metrics->minBranch = LLONG_MAX;
+    metrics->maxBranch = 0;
+    metrics->diameter = 0;
+    metrics->diameterStart = root;
+    metrics->diameterEnd = root;
+    MessageLevel messageLevels[2];
+    long long capacity = (long long) (memoryBudget / 4 / recordBytes(MESSAGE_FIELDS));
+    if (capacity < MIN_RUN_RECORDS)
+    {
+        capacity = MIN_RUN_RECORDS;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        messageLevels[i].records = (char *) checkedMalloc(capacity * recordBytes(MESSAGE_FIELDS));
+        messageLevels[i].capacity = capacity;
+        messageLevels[i].spill = NULL;
+        messageLevels[i].sorted = NULL;
+        resetMessageLevel(&messageLevels[i]);
+    }
+    void *temp = checkedMalloc(capacity * recordBytes(MESSAGE_FIELDS));
+    MessageLevel *received = &messageLevels[0]; // the messages to the current level
+    MessageLevel *sent = &messageLevels[1]; // the messages to the level above it
+
+    RecordStream stream;
+    openRecordStream(&stream, levels, LEVEL_FIELDS);
+    const void *node;
+    long long currentDepth = -1;
+    while ((node = readRecord(&stream)) != NULL)
+    {
+        long long depth = fieldOf(node, LEVEL_DEPTH);
+        long long nodeId = fieldOf(node, LEVEL_NODE);
+        if (depth != currentDepth) // a new level, so the messages to it are all sent
+        {
+            MessageLevel *done = received;
+            received = sent;
+            sent = done;
+            resetMessageLevel(sent);
+            finishMessageLevel(received, temp, memoryBudget / 4);
+            currentDepth = depth;
+        }
+        long long highest = 0;
+        long long secondHighest = 0;
+        long long highestEnd = nodeId;
+        long long secondHighestEnd = nodeId;
+        int isLeaf = 1;
+        for (; received->current != NULL && fieldOf(received->current, MESSAGE_PARENT) == nodeId;
+               nextMessage(received))
+        {
+            long long height = fieldOf(received->current, MESSAGE_HEIGHT);
+            isLeaf = 0;
+            if (height > highest)
+            {
+                secondHighest = highest;
+                secondHighestEnd = highestEnd;
+                highest = height;
+                highestEnd = fieldOf(received->current, MESSAGE_DEEPEST);
+            }
+            else if (height > secondHighest)
+            {
+                secondHighest = height;
+                secondHighestEnd = fieldOf(received->current, MESSAGE_DEEPEST);
+            }
+        }
+        if (isLeaf)
+        {
+            if (currentDepth < metrics->minBranch)
+            {
+                metrics->minBranch = currentDepth;
+            }
+            if (currentDepth > metrics->maxBranch)
+            {
+                metrics->maxBranch = currentDepth;
+            }
+        }
+        if (highest + secondHighest > metrics->diameter)
+        {
+            metrics->diameter = highest + secondHighest;
+            metrics->diameterStart = highestEnd;
+            metrics->diameterEnd = secondHighestEnd;
+        }
+        if (fieldOf(node, LEVEL_PARENT) != -1)
+        {
+            sendMessage(sent, fieldOf(node, LEVEL_PARENT), highest + 1, highestEnd);
+        }
+    }
+    closeRecordStream(&stream);
+    for (int i = 0; i < 2; i++)
+    {
+        resetMessageLevel(&messageLevels[i]);
+        free(messageLevels[i].records);
+    }
+    free(temp);
+}
+
+/********************************************************************************
+*********************************************************************************
+*************               Message Levels               ************************
+*********************************************************************************
+********************************************************************************/
+
+void sendMessage(MessageLevel *level, long long parent, long long height, long long deepest)
+{
+    if (level->count == level->capacity) // spill the messages in memory
+    {
+        if (level->spill == NULL)
+        {
+            level->spill = openTempFile();
+        }
+        checkedWrite(level->records, recordBytes(MESSAGE_FIELDS), (size_t) level->count,
+                     level->spill);
+        level->count = 0;
+    }
+    void *message = level->records + level->count * recordBytes(MESSAGE_FIELDS);
+    setField(message, MESSAGE_PARENT, parent);
+    setField(message, MESSAGE_HEIGHT, height);
+    setField(message, MESSAGE_DEEPEST, deepest);
+    level->count++;
+    level->numOfMessages++;
+}
+
+void finishMessageLevel(MessageLevel *level, void *temp, size_t memoryBudget)
+{
+    RecordOrder byParent = {MESSAGE_FIELDS, MESSAGE_PARENT, 0};
+    if (level->spill == NULL)
+    {
+        radixSortRecords(level->records, temp, level->count, &byParent);
+        level->next = 0;
+        level->current = (level->count > 0) ? level->records : NULL;
+        return;
+    }
+    checkedWrite(level->records, recordBytes(MESSAGE_FIELDS), (size_t) level->count,
+                 level->spill);
+    level->count = 0;
+    level->sorted = sortRecords(level->spill, level->numOfMessages, &byParent, memoryBudget);
+    fclose(level->spill);
+    level->spill = NULL;
+    openRecordStream(&level->stream, level->sorted, MESSAGE_FIELDS);
+    level->current = readRecord(&level->stream);
+}
+
+void nextMessage(MessageLevel *level)
+{
+    if (level->sorted != NULL)
+    {
+        level->current = readRecord(&level->stream);
+        return;
+    }
+    level->next++;
+    level->current = (level->next < level->count) ?
+                     level->records + level->next * recordBytes(MESSAGE_FIELDS) : NULL;
+}
+
+void resetMessageLevel(MessageLevel *level)
+{
+    if (level->sorted != NULL)
+    {
+        closeRecordStream(&level->stream);
+        fclose(level->sorted);
+        level->sorted = NULL;
+    }
+    if (level->spill != NULL)
+    {
+        fclose(level->spill);
+        level->spill = NULL;
+    }
+    level->count = 0;
+    level->numOfMessages = 0;
+    level->next = 0;
+    level->current = NULL;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************               External Sorting             ************************
+*********************************************************************************
+********************************************************************************/
+
+FILE *sortRecords(FILE *input, long long numOfRecords, const RecordOrder *order,
+                  size_t memoryBudget)
+{
+    size_t recordSize = recordBytes(order->recordLength);
+    long long runCapacity = (long long) (memoryBudget / (2 * recordSize)); // and as much to sort
+    if (runCapacity < MIN_RUN_RECORDS)
+    {
+        runCapacity = MIN_RUN_RECORDS;
+    }
+    if (runCapacity > numOfRecords)
+    {
+        runCapacity = (numOfRecords > 0) ? numOfRecords : 1;
+    }
+    void *records = checkedMalloc(runCapacity * recordSize);
+    void *temp = checkedMalloc(runCapacity * recordSize);
+    long numOfRuns = 0;
+    long runsCapacity = 0;
+    long long *runStart = NULL;
+    long long *runLength = NULL;
+    FILE *runs = openTempFile();
+    rewind(input);
+    for (long long start = 0; start < numOfRecords; start += runCapacity)
+    {
+        long long length = numOfRecords - start;
+        if (length > runCapacity)
+        {
+            length = runCapacity;
+        }
+        if (fread(records, recordSize, (size_t) length, input) != (size_t) length)
+        {
+            fprintf(stderr, "Reading the temporary files failed\n");
+            exit(EXIT_FAILURE);
+        }
+        radixSortRecords(records, temp, length, order);
+        checkedWrite(records, recordSize, (size_t) length, runs);
+        if (numOfRuns == runsCapacity)
+        {
+            runsCapacity = (runsCapacity > 0) ? 2 * runsCapacity : 16;
+            runStart = (long long *) checkedRealloc(runStart, runsCapacity * sizeof(long long));
+            runLength = (long long *) checkedRealloc(runLength, runsCapacity * sizeof(long long));
+        }
+        runStart[numOfRuns] = start;
+        runLength[numOfRuns++] = length;
+    }
+    free(records);
+    free(temp);
+
+    long maxFanIn = (long) (memoryBudget / MERGE_BUFFER_BYTES);
+    maxFanIn = (maxFanIn < 2) ? 2 : (maxFanIn > MAX_MERGE_FAN_IN) ? MAX_MERGE_FAN_IN : maxFanIn;
+    while (numOfRuns > 1) // every pass merges groups of runs into longer runs
+    {
+        FILE *merged = openTempFile();
+        fflush(runs);
+        long numOfMerged = 0;
+        for (long first = 0; first < numOfRuns; first += maxFanIn)
+        {
+            int groupSize = (int) ((numOfRuns - first < maxFanIn) ? numOfRuns - first : maxFanIn);
+            mergeRuns(runs, runStart + first, runLength + first, groupSize, merged, order,
+                      memoryBudget);
+            long long length = 0;
+            for (int i = 0; i < groupSize; i++)
+            {
+                length += runLength[first + i];
+            }
+            runStart[numOfMerged] = runStart[first];
+            runLength[numOfMerged++] = length;
+        }
+        fclose(runs);
+        runs = merged;
+        numOfRuns = numOfMerged;
+    }
+    free(runStart);
+    free(runLength);
+    fflush(runs);
+    rewind(runs);
+    return runs;
+}
+
+void mergeRuns(FILE *runs, const long long *runStart, const long long *runLength, int numOfRuns,
+               FILE *out, const RecordOrder *order, size_t memoryBudget)
+{
+    int recordLength = order->recordLength;
+    size_t recordSize = recordBytes(recordLength);
+    long capacity = (long) (memoryBudget / (numOfRuns + 1) / recordSize);
+    if (capacity < 1)
+    {
+        capacity = 1;
+    }
+    RunReader *readers = (RunReader *) checkedMalloc(numOfRuns * sizeof(RunReader));
+    int *heap = (int *) checkedMalloc(numOfRuns * sizeof(int));
+    int heapSize = 0;
+    for (int i = 0; i < numOfRuns; i++)
+    {
+        readers[i].fd = fileno(runs);
+        readers[i].position = runStart[i];
+        readers[i].left = runLength[i];
+        readers[i].capacity = (capacity < runLength[i]) ? capacity : (long) runLength[i];
+        readers[i].buffer = (char *) checkedMalloc(readers[i].capacity * recordSize);
+        readers[i].count = 0;
+        readers[i].next = -1;
+        if (advanceRun(&readers[i], recordLength))
+        {
+            heap[heapSize++] = i;
+        }
+    }
+    for (int i = heapSize / 2 - 1; i >= 0; i--)
+    {
+        siftRunDown(heap, heapSize, i, readers, order);
+    }
+    RecordSink sink;
+    openRecordSink(&sink, out, recordLength);
+    while (heapSize > 0)
+    {
+        RunReader *run = &readers[heap[0]];
+        memcpy(appendRecord(&sink), run->buffer + run->next * recordSize, recordSize);
+        if (!advanceRun(run, recordLength))
+        {
+            heap[0] = heap[--heapSize];
+        }
+        siftRunDown(heap, heapSize, 0, readers, order);
+    }
+    closeRecordSink(&sink);
+    for (int i = 0; i < numOfRuns; i++)
+    {
+        free(readers[i].buffer);
+    }
+    free(readers);
+    free(heap);
+}
+
+int advanceRun(RunReader *run, int recordLength)
+{
+    run->next++;
+    if (run->next < run->count)
+    {
+        return 1;
+    }
+    if (run->left == 0)
+    {
+        return 0;
+    }
+    size_t recordSize = recordBytes(recordLength);
+    long count = (run->left < run->capacity) ? (long) run->left : run->capacity;
+    size_t done = 0;
+    while (done < count * recordSize)
+    {
+        ssize_t numOfBytes = pread(run->fd, (char *) run->buffer + done, count * recordSize - done,
+                                   (off_t) (run->position * recordSize + done));
+        if (numOfBytes <= 0)
+        {
+            fprintf(stderr, "Reading the temporary files failed\n");
+            exit(EXIT_FAILURE);
+        }
+        done += (size_t) numOfBytes;
+    }
+    run->position += count;
+    run->left -= count;
+    run->count = count;
+    run->next = 0;
+    return 1;
+}
+
+void siftRunDown(int *heap, int heapSize, int i, const RunReader *runs, const RecordOrder *order)
+{
+    while (1)
+    {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        if (left < heapSize && runBefore(runs, heap[left], heap[smallest], order))
+        {
+            smallest = left;
+        }
+        if (right < heapSize && runBefore(runs, heap[right], heap[smallest], order))
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+        {
+            return;
+        }
+        int temp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = temp;
+        i = smallest;
+    }
+}
+
+int runBefore(const RunReader *runs, int first, int second, const RecordOrder *order)
+{
+    size_t recordSize = recordBytes(order->recordLength);
+    uint64_t firstKey = recordKey(runs[first].buffer + runs[first].next * recordSize, order);
+    uint64_t secondKey = recordKey(runs[second].buffer + runs[second].next * recordSize, order);
+    // equal keys are taken from the earlier run, which keeps the sort stable
+    return firstKey < secondKey || (firstKey == secondKey && first < second);
+}
+
+void radixSortRecords(void *records, void *temp, long long count, const RecordOrder *order)
+{
+    if (fieldBytes == sizeof(int32_t))
+    {
+        radixSortRecords32(records, temp, count, order);
+    }
+    else
+    {
+        radixSortRecords64(records, temp, count, order);
+    }
+}
+
+DEFINE_RADIX_SORT(radixSortRecords32, int32_t, uint32_t, 0x80000000u)
+
+DEFINE_RADIX_SORT(radixSortRecords64, int64_t, uint64_t, 0x8000000000000000u)
+
+uint64_t recordKey(const void *record, const RecordOrder *order)
+{
+    // signed order, -1 first, at any width since the field is sign extended
+    uint64_t key = (uint64_t) fieldOf(record, order->keyField) ^ 0x8000000000000000u;
+    return order->descending ? ~key : key;
+}
+
+/********************************************************************************
+*********************************************************************************
+*************            Reading & Writing               ************************
+*********************************************************************************
+********************************************************************************/
+
+long long scanStreamedNumOfNodes(GraphReader *reader)
+{
+    long long num = 0;
+    int length = 0;
+    int valid = 1;
+    int inContent = 1;
+    for (int c = readGraphByte(reader); c != EOF && c != '\n'; c = readGraphByte(reader))
+    {
+        if (!inContent || c == '\r') // whatever follows a '\r' isn't part of the line
+        {
+            inContent = 0;
+            continue;
+        }
+        length++;
+        if (c < '0' || c > '9')
+        {
+            valid = 0;
+        }
+        else if (valid)
+        {
+            num = num * 10 + (c - '0');
+            if (num > MAX_STREAMED_NODES)
+            {
+                valid = 0;
+            }
+        }
+    }
+    return (valid && length > 0) ? num : 0;
+}
+
+long long scanStreamedLine(GraphReader *reader, long long numOfNodesInTree, long long node,
+                           RecordSink *edges)
+{
+    if (reader->next == reader->length && fillGraphReader(reader) == 0)
+    {
+        return LINE_MISSING;
+    }
+    long long numOfSons = 0;
+    int noSons = 0;
+    int valid = 1;
+    int firstPiece = 1;
+    int contentDone = 0; // set once the content is read, the rest of the line is skipped
+    while (1)
+    {
+        char *start = reader->buffer + reader->next;
+        size_t available = reader->length - reader->next;
+        char *lineEnd = (char *) memchr(start, '\n', available);
+        if (lineEnd == NULL && !reader->ended && (contentDone || available < READ_BUFFER_SIZE))
+        {
+            if (contentDone)
+            {
+                reader->next = reader->length;
+            }
+            fillGraphReader(reader); // the line goes on past the buffer
+            continue;
+        }
+        char *end = (lineEnd != NULL) ? lineEnd : start + available;
+        if (!contentDone)
+        {
+            char *contentEnd = (char *) memchr(start, '\r', (size_t) (end - start));
+            contentDone = (lineEnd != NULL || reader->ended || contentEnd != NULL);
+            contentEnd = (contentEnd != NULL) ? contentEnd : end;
+            if (!contentDone) // the buffer is full of the line - cut it after its last delimiter
+            {
+                char *cut = (char *) memrchr(start, DELIMITER, available);
+                if (cut == NULL) // a single son fills the buffer, only its leading zeros may go
+                {
+                    char *digits = start;
+                    while (digits < end - 1 && *digits == '0')
+                    {
+                        digits++;
+                    }
+                    valid = valid && (digits > start);
+                    contentDone = !valid;
+                    reader->next = (size_t) (digits - reader->buffer);
+                    continue;
+                }
+                contentEnd = cut + 1;
+            }
+            // a piece after the first is never the "-" of a line without sons
+            long long code = (!firstPiece && contentEnd - start == 1 && *start == NOSONS) ?
+                             LINE_INVALID :
+                             scanSons64(start, contentEnd, numOfNodesInTree, reader->sons,
+                                        PIECE_SONS_ROOM);
+            valid = valid && (code != LINE_INVALID);
+            noSons = noSons || (code == 0);
+            for (long long i = 0; valid && edges != NULL && i < code; i++)
+            {
+                void *edge = appendRecord(edges);
+                setField(edge, EDGE_CHILD, (long long) reader->sons[i]);
+                setField(edge, EDGE_PARENT, node);
+            }
+            numOfSons += (code > 0) ? code : 0;
+            firstPiece = 0;
+            if (!contentDone)
+            {
+                reader->next += (size_t) (contentEnd - start);
+                continue;
+            }
+        }
+        reader->next = (lineEnd != NULL) ? (size_t) (lineEnd + 1 - reader->buffer) : reader->length;
+        if (lineEnd != NULL || reader->ended)
+        {
+            break;
+        }
+    }
+    if (!valid)
+    {
+        return LINE_INVALID;
+    }
+    return (numOfSons == 0 && !noSons) ? LINE_BLANK : numOfSons;
+}
+
+int readGraphByte(GraphReader *reader)
+{
+    if (reader->next == reader->length && fillGraphReader(reader) == 0)
+    {
+        return EOF;
+    }
+    return (unsigned char) reader->buffer[reader->next++];
+}
+
+size_t fillGraphReader(GraphReader *reader)
+{
+    size_t kept = reader->length - reader->next;
+    memmove(reader->buffer, reader->buffer + reader->next, kept);
+    reader->next = 0;
+    size_t numOfBytes = fread(reader->buffer + kept, 1, READ_BUFFER_SIZE - kept, reader->file);
+    reader->length = kept + numOfBytes;
+    reader->ended = (numOfBytes == 0);
+    return numOfBytes;
+}
+
+void openRecordStream(RecordStream *stream, FILE *file, int recordLength)
+{
+    fflush(file);
+    rewind(file);
+    stream->file = file;
+    stream->recordLength = recordLength;
+    stream->buffer = (char *) checkedMalloc(STREAM_BUFFER_RECORDS * recordBytes(recordLength));
+    stream->count = 0;
+    stream->next = 0;
+}
+
+const void *readRecord(RecordStream *stream)
+{
+    if (stream->next == stream->count)
+    {
+        stream->count = (long) fread(stream->buffer, recordBytes(stream->recordLength),
+                                     STREAM_BUFFER_RECORDS, stream->file);
+        stream->next = 0;
+        if (stream->count == 0)
+        {
+            if (ferror(stream->file))
+            {
+                fprintf(stderr, "Reading the temporary files failed\n");
+                exit(EXIT_FAILURE);
+            }
+            return NULL;
+        }
+    }
+    return stream->buffer + (stream->next++) * recordBytes(stream->recordLength);
+}
+
+void closeRecordStream(RecordStream *stream)
+{
+    free(stream->buffer);
+    stream->buffer = NULL;
+}
+
+void openRecordSink(RecordSink *sink, FILE *file, int recordLength)
+{
+    sink->file = file;
+    sink->recordLength = recordLength;
+    sink->buffer = (char *) checkedMalloc(STREAM_BUFFER_RECORDS * recordBytes(recordLength));
+    sink->count = 0;
+    sink->numOfRecords = 0;
+}
+
+void *appendRecord(RecordSink *sink)
+{
+    if (sink->count == STREAM_BUFFER_RECORDS)
+    {
+        checkedWrite(sink->buffer, recordBytes(sink->recordLength), (size_t) sink->count,
+                     sink->file);
+        sink->count = 0;
+    }
+    sink->numOfRecords++;
+    return sink->buffer + (sink->count++) * recordBytes(sink->recordLength);
+}
+
+void closeRecordSink(RecordSink *sink)
+{
+    checkedWrite(sink->buffer, recordBytes(sink->recordLength), (size_t) sink->count,
+                 sink->file);
+    free(sink->buffer);
+    sink->buffer = NULL;
+    sink->count = 0;
+    fflush(sink->file);
+}
+
+long long fieldOf(const void *record, int field)
+{
+    if (fieldBytes == sizeof(int32_t))
+    {
+        return ((const int32_t *) record)[field];
+    }
+    return ((const int64_t *) record)[field];
+}
+
+void setField(void *record, int field, long long value)
+{
+    if (fieldBytes == sizeof(int32_t))
+    {
+        ((int32_t *) record)[field] = (int32_t) value;
+        return;
+    }
+    ((int64_t *) record)[field] = value;
+}
+
+size_t recordBytes(int recordLength)
+{
+    return (size_t) recordLength * fieldBytes;
+}
+
+long long maxFieldValue(void)
+{
+    return (fieldBytes == sizeof(int32_t)) ? INT32_MAX : INT64_MAX;
+}
+
+FILE *openTempFile(void)
+{
+    const char *directory = getenv("TMPDIR");
+    if (directory == NULL || *directory == '\0')
+    {
+        directory = "/tmp";
+    }
+    size_t length = strlen(directory) + sizeof(TEMP_FILE_TEMPLATE);
+    char *path = (char *) checkedMalloc(length);
+    snprintf(path, length, "%s%s", directory, TEMP_FILE_TEMPLATE);
+    int fd = mkstemp(path);
+    FILE *file = (fd >= 0) ? fdopen(fd, "w+b") : NULL;
+    if (fd >= 0)
+    {
+        unlink(path);
+    }
+    free(path);
+    if (file == NULL)
+    {
+        fprintf(stderr, "A temporary file can't be made in %s\n", directory);
+        exit(EXIT_FAILURE);
+    }
+    return file;
+}
+
+void checkedWrite(const void *data, size_t size, size_t count, FILE *file)
+{
+    if (count > 0 && fwrite(data, size, count, file) != count)
+    {
+        fprintf(stderr, "Writing the temporary files failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void setStreamError(ParseError *error, long line, const char *format, long long first,
+                    long long second)
+{
+    if (error != NULL)
+    {
+        error->line = line;
+        snprintf(error->message, PARSE_ERROR_LENGTH, format, first, second);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+* @file TreeSubtree.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief answering subtree size, depth and ancestor queries on a tree in O(1)
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a valid tree and its root
+* Process: a single iterative DFS numbers the nodes in the order they are entered. a node gets its
+* entry time when it is entered and its exit time - the last entry time given inside its subtree -
+* when all of its sons are done, so the subtree of x is exactly the nodes entered between the
+* entry and exit times of x. x is an ancestor of y if the entry time of y falls in that range, and
+* the size of the subtree of x is the length of the range.
+* Output : a SubtreeIndex to query
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+SubtreeIndex *buildSubtreeIndex(const AllTree *mainTree, int root)
+{
+    const int32_t *sonsOffsets = mainTree->sonsOffsets;
+    const int32_t *sons = mainTree->sons;
+    int n = mainTree->value;
+    SubtreeIndex *index = (SubtreeIndex *) checkedMalloc(sizeof(SubtreeIndex));
+    index->numOfNodes = n;
+    index->entry = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->exit = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    index->depth = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *stack = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t *nextSon = (int32_t *) checkedMalloc(n * sizeof(int32_t));
+    int32_t time = 0;
+    int top = 0;
+    stack[top++] = root;
+    nextSon[root] = sonsOffsets[root];
+    index->entry[root] = time++;
+    index->depth[root] = 0;
+    while (top > 0)
+    {
+        int32_t cur = stack[top - 1];
+        if (nextSon[cur] < sonsOffsets[cur + 1]) // enter the next son
+        {
+            int32_t son = sons[nextSon[cur]++];
+            index->entry[son] = time++;
+            index->depth[son] = index->depth[cur] + 1;
+            nextSon[son] = sonsOffsets[son];
+            stack[top++] = son;
+        }
+        else // done with the subtree of cur
+        {
+            index->exit[cur] = time - 1;
+            top--;
+        }
+    }
+    free(stack);
+    free(nextSon);
+    return index;
+}
+
+int isAncestor(const SubtreeIndex *index, int x, int y)
+{
+    return index->entry[x] <= index->entry[y] && index->entry[y] <= index->exit[x];
+}
+
+int subtreeSize(const SubtreeIndex *index, int x)
+{
+    return index->exit[x] - index->entry[x] + 1;
+}
+
+int nodeDepth(const SubtreeIndex *index, int x)
+{
+    return index->depth[x];
+}
+
+void freeSubtreeIndex(SubtreeIndex *index)
+{
+    free(index->entry);
+    free(index->exit);
+    free(index->depth);
+    free(index);
+}
@@ -0,0 +1,146 @@
+/**
+* @file TreeValidator.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief checking that a parsed graph is really a tree
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph parsed from a file, with its sons set but without fathers
+* Process: a single pass over the sons of all the nodes, in the order of their lines, sets the
+* father of every node. the father column doubles as a generation-stamped visited array - the
+* stamp of a son is the line it was last seen in - so a son seen twice in the same line, or in
+* two different lines, is found in O(1) without clearing anything between lines. then the root is
+* found, and a walk from it checks that every node is reachable, which means there are no cycles.
+* the check is defined once by a macro and specialized for the int32_t columns of AllTree and the
+* uint32_t and uint64_t columns of WideTree.
+* Output : 1 if the graph is a tree, 0 and the first problem found otherwise
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief records an error with a formatted message, if error isn't NULL
+ * @param line - the line of the error in the file, 0 if the error isn't in a single line
+ */
+void setValidationError(ParseError *error, long line, const char *format, long long first,
+                        long long second);
+
+/**
+ * @brief defines the check of the columns of a graph whose ids and offsets are of a given type.
+ * it is done in three steps:
+ * a single pass over the sons of all the nodes, in the order of their lines, sets the father of
+ * every node, and checks no node has more than one father or appears twice among the sons of the
+ * same node.
+ * then the single node without a father is found.
+ * then the tree is walked from the root, and all the nodes must be reached. as every node but the
+ * root has exactly one father, a node can't be reached twice, and any node that isn't reached
+ * lies on or below a cycle.
+ * @param name - the name of the check
+ * @param Id - the type of the ids and the offsets. (Id) -1 marks a missing father.
+ */
+#define DEFINE_VALIDATE_COLUMNS(name, Id) \
+int name(const Id *sonsOffsets, const Id *sons, Id *father, Id n, long long *root, \
+         ParseError *error) \
+{ \
+    for (Id i = 0; i < n; i++) \
+    { \
+        father[i] = (Id) -1; \
+    } \
+    for (Id i = 0; i < n; i++) \
+    { \
+        for (Id j = sonsOffsets[i]; j < sonsOffsets[i + 1]; j++) \
+        { \
+            Id son = sons[j]; \
+            if (father[son] == i) \
+            { \
+                setValidationError(error, (long) i + 2, "vertex %lld appears more than once in " \
+                                                        "the line", (long long) son, 0); \
+                return 0; \
+            } \
+            if (father[son] != (Id) -1) \
+            { \
+                setValidationError(error, (long) i + 2, "vertex %lld already has a father, in " \
+                                                        "line %lld", (long long) son, \
+                                   (long long) father[son] + 2); \
+                return 0; \
+            } \
+            father[son] = i; \
+        } \
+    } \
+    *root = -1; \
+    for (Id i = 0; i < n; i++) \
+    { \
+        if (father[i] == (Id) -1 && *root != -1) \
+        { \
+            setValidationError(error, 0, "vertices %lld and %lld have no father - there can be " \
+                                         "only one root", *root, (long long) i); \
+            return 0; \
+        } \
+        if (father[i] == (Id) -1) \
+        { \
+            *root = (long long) i; \
+        } \
+    } \
+    if (*root == -1) \
+    { \
+        setValidationError(error, 0, "every vertex has a father, so there is no root and the " \
+                                     "graph has a cycle", 0, 0); \
+        return 0; \
+    } \
+    Id *stack = (Id *) checkedMalloc((size_t) n * sizeof(Id)); \
+    unsigned char *reached = (unsigned char *) checkedCalloc((size_t) n / 8 + 1, 1); \
+    Id numOfReached = 1; \
+    Id top = 0; \
+    stack[top++] = (Id) *root; \
+    reached[*root / 8] |= (unsigned char) (1 << (*root % 8)); \
+    while (top > 0) \
+    { \
+        Id cur = stack[--top]; \
+        for (Id j = sonsOffsets[cur]; j < sonsOffsets[cur + 1]; j++) \
+        { \
+            stack[top++] = sons[j]; \
+            reached[sons[j] / 8] |= (unsigned char) (1 << (sons[j] % 8)); \
+            numOfReached++; \
+        } \
+    } \
+    free(stack); \
+    for (Id i = 0; i < n && numOfReached < n; i++) \
+    { \
+        if ((reached[i / 8] & (1 << (i % 8))) == 0) \
+        { \
+            setValidationError(error, 0, "vertex %lld is not reachable from the root %lld - it " \
+                                         "lies on or below a cycle", (long long) i, *root); \
+            break; \
+        } \
+    } \
+    free(reached); \
+    return numOfReached == n; \
+}
+
+DEFINE_VALIDATE_COLUMNS(validateColumns, int32_t)
+
+DEFINE_VALIDATE_COLUMNS(validateColumns32, uint32_t)
+
+DEFINE_VALIDATE_COLUMNS(validateColumns64, uint64_t)
+
+int validateTree(AllTree *mainTree, ParseError *error)
+{
+    long long root;
+    return validateColumns(mainTree->sonsOffsets, mainTree->sons, mainTree->father,
+                           mainTree->value, &root, error);
+}
+
+void setValidationError(ParseError *error, long line, const char *format, long long first,
+                        long long second)
+{
+    if (error != NULL)
+    {
+        error->line = line;
+        snprintf(error->message, PARSE_ERROR_LENGTH, format, first, second);
+    }
+}
@@ -0,0 +1,347 @@
+/**
+* @file TreeWide.c
+* @author Tal Shaked <tal.shaked3@mail.huji.ac.il>
+* @version 1.0
+* @date 27 Nov 2019
+*
+* @brief reading a tree of more than 2^31 - 1 vertices into memory, and finding its stats and the
+* path between two of its vertices
+* @section LICENSE
+* This program is not a free software;
+*
+*
+* Input : a graph file of more than 2147483647 vertices, and two of its vertices
+* Process: the tree is kept in the same compressed sparse row layout as AllTree, but its ids and
+* offsets are as wide as the number of its nodes needs - uint32_t up to 2^32 - 1 nodes, which
+* leaves the largest value free to mark a missing father, and uint64_t above it, up to about
+* 9 * 10^17. the width is chosen once the first line is read. the lines are read by the scanner of
+* TreeParser.c, and the tree is checked, measured and searched by the kernels of TreeValidator.c,
+* TreeMetrics.c and TreeBfs.c - every one of them is defined once by a macro and specialized for
+* each width, so the loops over the columns never check the width. the columns grow as the lines
+* are read, so a number of vertices far beyond the lines of the file doesn't allocate memory for
+* all of them.
+* the trees of at most 2147483647 vertices are read as an AllTree instead, with its int32 columns.
+* Output : the WideTree, its StreamedMetrics and the path, or the first error in the file
+*/
+#include "TreeAnalyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define INITIAL_WIDE_CAPACITY (1 << 16)
+#define MAX_WIDE_NODES (LLONG_MAX / 10) // so the digits of a vertex never overflow
+#define MAX_NARROW_NODES 4294967295LL // the ids of uint32_t columns, and their missing father
+
+#define ERROR_COMPRESSED "compressed files of more than 2147483647 vertices can't be read"
+
+/**
+ * @brief reads the number of nodes in the first line of a graph file
+ * @param scanner - the scanner, positioned at the start of the file. advanced past the line.
+ * @return - the number of nodes, 0 if the line isn't a positive number of at most MAX_WIDE_NODES
+ */
+long long scanWideNumOfNodes(Scanner *scanner);
+
+/**
+ * @brief doubles the room of a column, up to a limit
+ * @param capacity - in: the number of values the column has room for, out: the new number
+ * @param limit - the most values the column ever needs
+ * @param width - the size of a value
+ * @return - the column, moved if needed. exits the program if memory allocation fails.
+ */
+void *growWideColumn(void *column, size_t *capacity, size_t limit, size_t width);
+
+/**
+ * @brief records an error with a formatted message, if error isn't NULL
+ * @param line - the line of the error in the file, 0 if the error isn't in a single line
+ */
+void setWideError(ParseError *error, long line, const char *format, long long first,
+                  long long second);
+
+/**
+ * @brief defines the kernels of a WideTree whose ids and offsets are of a given type:
+ * parseWideLines##suffix - reads the lines of the nodes, after the first line, into the columns
+ * of the sons with scanSons##suffix. returns 1 if they are valid, 0 and the first error otherwise.
+ * validateWide##suffix - sets the fathers and the root with validateColumns##suffix. returns 1
+ * if the graph is a tree, 0 and the first problem otherwise.
+ * analyzeWide##suffix - computes the metrics with analyzeColumns##suffix
+ * wideBfs##suffix - a BFS from a node level by level with expandFrontier##suffix, which sets the
+ * node every node is reached from
+ * writeWidePath##suffix - writes the path from u to the node of the last BFS
+ * @param suffix - the suffix of the names of the kernels
+ * @param Id - the unsigned type of the ids and the offsets
+ */
+#define DEFINE_WIDE_KERNELS(suffix, Id) \
+int parseWideLines##suffix(WideTree *tree, Scanner *scanner, ParseError *error) \
+{ \
+    Id n = (Id) tree->numOfNodes; \
+    size_t nodesCapacity = (n < INITIAL_WIDE_CAPACITY) ? n : INITIAL_WIDE_CAPACITY; \
+    size_t sonsCapacity = INITIAL_WIDE_CAPACITY; \
+    Id *sonsOffsets = (Id *) checkedMalloc((nodesCapacity + 1) * sizeof(Id)); \
+    Id *sons = (Id *) checkedMalloc(sonsCapacity * sizeof(Id)); \
+    Id numOfNodes = 0; \
+    Id numOfSons = 0; \
+    long line = 2; \
+    const char *message = NULL; \
+    sonsOffsets[0] = 0; \
+    while (scanner->cur < scanner->end && message == NULL) \
+    { \
+        const char *next; \
+        const char *contentEnd = lineContentEnd(scanner, &next); \
+        long long room = (numOfNodes < n) ? (long long) (sonsCapacity - numOfSons) : 0; \
+        long long numOfLineSons = scanSons##suffix(scanner->cur, contentEnd, (long long) n, \
+                                                   sons + numOfSons, room); \
+        if (numOfNodes == n) /* only blank lines may follow the lines of the nodes */ \
+        { \
+            message = (numOfLineSons != LINE_BLANK) ? ERROR_EXTRA_CONTENT : NULL; \
+        } \
+        else if (numOfLineSons < 0) \
+        { \
+            message = (numOfLineSons == LINE_BLANK) ? ERROR_EMPTY_LINE : ERROR_INVALID_LINE; \
+        } \
+        else if ((unsigned long long) numOfLineSons > (Id) ((Id) -1 - numOfSons)) \
+        { \
+            message = ERROR_TOO_MANY_SONS; \
+        } \
+        else \
+        { \
+            if (numOfLineSons > room) /* the sons didn't fit, make room and read them again */ \
+            { \
+                while (sonsCapacity - numOfSons < (unsigned long long) numOfLineSons) \
+                { \
+                    sons = (Id *) growWideColumn(sons, &sonsCapacity, (Id) -1, sizeof(Id)); \
+                } \
+                scanSons##suffix(scanner->cur, contentEnd, (long long) n, sons + numOfSons, \
+                                 numOfLineSons); \
+            } \
+            if (numOfNodes == nodesCapacity) \
+            { \
+                sonsOffsets = (Id *) growWideColumn(sonsOffsets, &nodesCapacity, n, sizeof(Id)); \
+            } \
+            numOfSons += (Id) numOfLineSons; \
+            sonsOffsets[++numOfNodes] = numOfSons; \
+        } \
+        if (message == NULL) \
+        { \
+            line++; \
+        } \
+        scanner->cur = next; \
+    } \
+    if (message == NULL && numOfNodes < n) /* less lines than nodes */ \
+    { \
+        message = ERROR_MISSING_LINES; \
+    } \
+    tree->sonsOffsets = sonsOffsets; \
+    tree->sons = sons; \
+    if (message != NULL) \
+    { \
+        setWideError(error, line, message, 0, 0); \
+        return 0; \
+    } \
+    return 1; \
+} \
+\
+int validateWide##suffix(WideTree *tree, ParseError *error) \
+{ \
+    Id n = (Id) tree->numOfNodes; \
+    tree->father = checkedMalloc(n * sizeof(Id)); \
+    return validateColumns##suffix((const Id *) tree->sonsOffsets, (const Id *) tree->sons, \
+                                   (Id *) tree->father, n, &tree->root, error); \
+} \
+\
+void analyzeWide##suffix(const WideTree *tree, StreamedMetrics *metrics) \
+{ \
+    analyzeColumns##suffix((const Id *) tree->sonsOffsets, (const Id *) tree->sons, \
+                           (Id) tree->numOfNodes, (Id) tree->root, metrics); \
+} \
+\
+void wideBfs##suffix(WideTree *tree, long long from) \
+{ \
+    Id n = (Id) tree->numOfNodes; \
+    if (tree->previousInPath == NULL) \
+    { \
+        tree->previousInPath = checkedMalloc(n * sizeof(Id)); \
+    } \
+    Id *previousInPath = (Id *) tree->previousInPath; \
+    Id *queue = (Id *) checkedMalloc(n * sizeof(Id)); \
+    Id head = 0; \
+    Id tail = 1; \
+    long long numOfEdges = 0; \
+    queue[0] = (Id) from; \
+    previousInPath[from] = (Id) -1; \
+    while (head < tail) /* every level is written right after the one before it */ \
+    { \
+        Id levelEnd = tail; \
+        tail += expandFrontier##suffix((const Id *) tree->sonsOffsets, (const Id *) tree->sons, \
+                                       (const Id *) tree->father, NULL, previousInPath, queue, \
+                                       head, levelEnd, queue + levelEnd, &numOfEdges); \
+        head = levelEnd; \
+    } \
+    free(queue); \
+    countBfs((long long) tail, numOfEdges); \
+} \
+\
+void writeWidePath##suffix(const WideTree *tree, long long u, OutputBuffer *out) \
+{ \
+    const Id *previousInPath = (const Id *) tree->previousInPath; \
+    for (Id cur = (Id) u; cur != (Id) -1; cur = previousInPath[cur]) \
+    { \
+        appendNumber(out, (long long) cur); \
+        appendChar(out, (previousInPath[cur] == (Id) -1) ? '\n' : ' '); \
+    } \
+}
+
+DEFINE_WIDE_KERNELS(32, uint32_t)
+
+DEFINE_WIDE_KERNELS(64, uint64_t)
+
+long long peekNumOfNodes(const char *fileName)
+{
+    MappedFile file;
+    if (mapFile(fileName, &file) == 0)
+    {
+        return 0;
+    }
+    Scanner scanner = {file.data, file.data + file.size};
+    long long numOfNodesInTree = (compressionOf(file.data, file.size) == COMPRESSION_NONE) ?
+                                 scanWideNumOfNodes(&scanner) : 0;
+    unmapFile(&file);
+    return numOfNodesInTree;
+}
+
+WideTree *readWideTree(const char *fileName, ParseError *error)
+{
+    MappedFile file;
+    setWideError(error, 0, "", 0, 0);
+    if (mapFile(fileName, &file) == 0)
+    {
+        setWideError(error, 0, ERROR_EMPTY_FILE, 0, 0);
+        return NULL;
+    }
+    if (compressionOf(file.data, file.size) != COMPRESSION_NONE)
+    {
+        setWideError(error, 0, ERROR_COMPRESSED, 0, 0);
+        unmapFile(&file);
+        return NULL;
+    }
+    Scanner scanner = {file.data, file.data + file.size};
+    long long numOfNodesInTree = scanWideNumOfNodes(&scanner);
+    if (numOfNodesInTree == 0)
+    {
+        setWideError(error, 1, ERROR_NUM_OF_NODES, 0, 0);
+        unmapFile(&file);
+        return NULL;
+    }
+    WideTree *tree = (WideTree *) checkedMalloc(sizeof(WideTree));
+    tree->numOfNodes = numOfNodesInTree;
+    tree->width = (numOfNodesInTree <= MAX_NARROW_NODES) ? 4 : 8;
+    tree->root = -1;
+    tree->father = NULL;
+    tree->previousInPath = NULL;
+    int valid = (tree->width == 4) ? parseWideLines32(tree, &scanner, error) :
+                parseWideLines64(tree, &scanner, error);
+    unmapFile(&file);
+    if (!valid)
+    {
+        freeWideTree(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+int validateWideTree(WideTree *tree, ParseError *error)
+{
+    return (tree->width == 4) ? validateWide32(tree, error) : validateWide64(tree, error);
+}
+
+void analyzeWideTree(const WideTree *tree, StreamedMetrics *metrics)
+{
+    if (tree->width == 4)
+    {
+        analyzeWide32(tree, metrics);
+    }
+    else
+    {
+        analyzeWide64(tree, metrics);
+    }
+}
+
+void wideBfs(WideTree *tree, long long from)
+{
+    if (tree->width == 4)
+    {
+        wideBfs32(tree, from);
+    }
+    else
+    {
+        wideBfs64(tree, from);
+    }
+}
+
+void writeWidePath(const WideTree *tree, long long u, OutputBuffer *out)
+{
+    if (tree->width == 4)
+    {
+        writeWidePath32(tree, u, out);
+    }
+    else
+    {
+        writeWidePath64(tree, u, out);
+    }
+}
+
+void freeWideTree(WideTree *tree)
+{
+    free(tree->sonsOffsets);
+    free(tree->sons);
+    free(tree->father);
+    free(tree->previousInPath);
+    free(tree);
+}
+
+long long scanWideNumOfNodes(Scanner *scanner)
+{
+    const char *next;
+    const char *contentEnd = lineContentEnd(scanner, &next);
+    const char *p = scanner->cur;
+    long long num = 0;
+    if (p == contentEnd)
+    {
+        return 0;
+    }
+    for (; p < contentEnd; p++)
+    {
+        if (*p < '0' || *p > '9' || num > MAX_WIDE_NODES / 10)
+        {
+            return 0;
+        }
+        num = num * 10 + (*p - '0');
+    }
+    if (num > MAX_WIDE_NODES)
+    {
+        return 0;
+    }
+    scanner->cur = next;
+    return num;
+}
+
+void *growWideColumn(void *column, size_t *capacity, size_t limit, size_t width)
+{
+    size_t newCapacity = 2 * *capacity;
+    if (newCapacity > limit)
+    {
+        newCapacity = limit;
+    }
+    *capacity = newCapacity;
+    return checkedRealloc(column, (newCapacity + 1) * width);
+}
+
+void setWideError(ParseError *error, long line, const char *format, long long first,
+                  long long second)
+{
+    if (error != NULL)
+    {
+        error->line = line;
+        snprintf(error->message, PARSE_ERROR_LENGTH, format, first, second);
+    }
+}